@@ -169,6 +169,13 @@ bool App::readConfiguration() {
         context_->setFullScreen(conf.read("fullscreen", false));
         context_->setPlayIntro(conf.read("play_intro", true));
         context_->setTimeForClick(conf.read("time_for_click", 80));
+        context_->setSurfacesThreads(conf.read("surfaces_threads", 4));
+        context_->setCheckSurfaces(conf.read("check_surfaces", false));
+        context_->setCheckLosTiles(conf.read("check_los_tiles", false));
+        context_->setCheckObjectives(conf.read("check_objectives", false));
+        context_->setAiThreads(conf.read("ai_threads", 4));
+        context_->setAiBudget(conf.read("ai_budget", 32));
+        context_->setMapsMemoryBudget(conf.read("maps_memory_budget", 8192));
         bool origDataDirFound = conf.readInto(origDataDir, "data_dir");
         bool ourDataDirFound = conf.readInto(ourDataDir, "freesynd_data_dir");
 
@@ -361,6 +368,7 @@ bool App::initialize(const std::string& iniPath) {
     if (!maps().initialize()) {
         return false;
     }
+    maps().setMemoryBudget(context_->getMapsMemoryBudget() * 1024);
 
     if (context_->isPlayIntro()) {
         LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading intro sounds..."))
@@ -649,6 +657,14 @@ void App::run(int start_mission) {
 #endif
 }
 
+/*!
+ * The game is encoded in memory, which is quick, then the file is
+ * written by save_writer_ in its own thread. Use saveWriter() to know
+ * when the file is written.
+ * \param fileSlot Slot of the save
+ * \param name Name of the save
+ * \return false if the save could not be started
+ */
 bool App::saveGameToFile(int fileSlot, std::string name) {
     LOG(Log::k_FLG_IO, "App", "saveGameToFile", ("Saving %s in slot %d", name.c_str(), fileSlot))
 
@@ -658,37 +674,44 @@ bool App::saveGameToFile(int fileSlot, std::string name) {
     File::getFullPathForSaveSlot(fileSlot, path);
     LOG(Log::k_FLG_IO, "App", "saveGameToFile", ("Saving to file %s", path.c_str()))
 
-    outfile.open_to_overwrite(path.c_str());
+#ifdef _DEBUG
+    // to measure time spent encoding the game
+    uint32 startTicks = SDL_GetTicks();
+#endif
+    outfile.open_to_buffer();
 
-    if (outfile) {
-        // write file format version
-        outfile.write8(1); // major
-        outfile.write8(2); // minor
+    // write file format version
+    outfile.write8(1); // major
+    outfile.write8(3); // minor
 
-        // Slot name is 31 characters long, nul-padded
-        outfile.write_string(name, 31);
+    // Slot name is 31 characters long, nul-padded
+    outfile.write_string(name, 31);
 
-        // Session
-        g_Session.saveToFile(outfile);
+    // Session
+    g_Session.saveToFile(outfile);
 
-        // Weapons
-        g_gameCtrl.weaponManager().saveToFile(outfile);
+    // Weapons
+    g_gameCtrl.weaponManager().saveToFile(outfile);
 
-        // Mods
-        g_gameCtrl.mods().saveToFile(outfile);
+    // Mods
+    g_gameCtrl.mods().saveToFile(outfile);
 
-        // Agents
-        // TODO move in sesion saveToFile
-        g_gameCtrl.agents().saveToFile(outfile);
+    // Agents
+    // TODO move in sesion saveToFile
+    g_gameCtrl.agents().saveToFile(outfile);
 
-        // save researches
-        // TODO move in sesion saveToFile
-        g_Session.researchManager().saveToFile(outfile);
+    // save researches
+    // TODO move in sesion saveToFile
+    g_Session.researchManager().saveToFile(outfile);
 
-        return true;
+    if (!outfile) {
+        return false;
     }
+    LOG(Log::k_FLG_IO, "App", "saveGameToFile", ("Game encoded in %d ms (%d bytes)",
+        SDL_GetTicks() - startTicks, (int) outfile.buffer().size()))
 
-    return false;
+    // v1.3: file ends with a CRC added by the writer
+    return save_writer_.start(path, outfile.buffer());
 }
 
 bool App::loadGameFromFile(int fileSlot) {
@@ -698,6 +721,10 @@ bool App::loadGameFromFile(int fileSlot) {
 
     File::getFullPathForSaveSlot(fileSlot, path);
 
+#ifdef _DEBUG
+    // to measure time spent reading and decoding the game
+    uint32 startTicks = SDL_GetTicks();
+#endif
     infile.open_to_read(path.c_str());
 
     if (infile) {
@@ -709,11 +736,16 @@ bool App::loadGameFromFile(int fileSlot) {
         FormatVersion v(vMaj, vMin);
 
         // validate that this is a supported version.
-        if (v.gt(1,2)) {
+        if (v.gt(1,3)) {
             FSERR(Log::k_FLG_IO, "App", "loadGameFromFile", ("Cannot load file, unsupported version %d.%d", vMaj, vMin))
             return false;
         }
 
+        if (v.gt(1,2) && !SaveGameWriter::checkCrc(infile.buffer())) {
+            FSERR(Log::k_FLG_IO, "App", "loadGameFromFile", ("Cannot load file, %s is corrupted\n", path.c_str()))
+            return false;
+        }
+
         if (v == 0x0100) {
             // the 1.0 format is in native byte order instead of big-endian.
             infile.set_system_endian();
@@ -742,6 +774,8 @@ bool App::loadGameFromFile(int fileSlot) {
         // Research
         g_Session.researchManager().loadFromFile(infile, v);
 
+        LOG(Log::k_FLG_IO, "App", "loadGameFromFile", ("Game read and decoded in %d ms (%d bytes)",
+            SDL_GetTicks() - startTicks, (int) infile.buffer().size()))
         return true;
     }
 
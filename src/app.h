@@ -51,6 +51,7 @@
 #include "appcontext.h"
 #include "core/gamesession.h"
 #include "core/gamecontroller.h"
+#include "core/savegamewriter.h"
 
 /*!
  * Application class.
@@ -108,8 +109,10 @@ class App : public Singleton < App > {
 
     void waitForKeyPress();
 
-    //! Save game to a file
+    //! Starts saving the game to a file
     bool saveGameToFile(int fileSlot, std::string name);
+    //! Returns the object writing saved games
+    SaveGameWriter &saveWriter() { return save_writer_; }
     //! Load game from a file
     bool loadGameFromFile(int fileSlot);
 
@@ -163,6 +166,7 @@ private:
     SoundManager intro_sounds_;
     SoundManager game_sounds_;
     MusicManager music_;
+    SaveGameWriter save_writer_;
 };
 
 #define g_App   App::singleton()
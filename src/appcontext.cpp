@@ -31,6 +31,13 @@ AppContext::AppContext() {
     time_for_click_ = 80; 
     fullscreen_ = false;
     playIntro_ = true;
+    surfaces_threads_ = 4;
+    check_surfaces_ = false;
+    check_los_tiles_ = false;
+    check_objectives_ = false;
+    ai_threads_ = 4;
+    ai_budget_ = 32;
+    maps_memory_budget_ = 8192;
     language_ = NULL;
 }
 
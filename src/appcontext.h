@@ -58,6 +58,27 @@ public:
     void setTimeForClick(int32 time) { time_for_click_ = time; }
     int32 getTimeForClick() { return time_for_click_; }
 
+    void setSurfacesThreads(int nb) { surfaces_threads_ = nb; }
+    int getSurfacesThreads() { return surfaces_threads_; }
+
+    void setCheckSurfaces(bool check) { check_surfaces_ = check; }
+    bool isCheckSurfaces() { return check_surfaces_; }
+
+    void setCheckLosTiles(bool check) { check_los_tiles_ = check; }
+    bool isCheckLosTiles() { return check_los_tiles_; }
+
+    void setCheckObjectives(bool check) { check_objectives_ = check; }
+    bool isCheckObjectives() { return check_objectives_; }
+
+    void setAiThreads(int nbThreads) { ai_threads_ = nbThreads; }
+    int getAiThreads() { return ai_threads_; }
+
+    void setAiBudget(int budget) { ai_budget_ = budget; }
+    int getAiBudget() { return ai_budget_; }
+
+    void setMapsMemoryBudget(int32 kbytes) { maps_memory_budget_ = kbytes; }
+    int32 getMapsMemoryBudget() { return maps_memory_budget_; }
+
     void setLanguage(FS_Lang lang);
     FS_Lang currLanguage(void) {return curr_language_; }
     std::string getMessage(const std::string & id);
@@ -72,6 +93,20 @@ private:
      * if it will be longer it will be treated as dragging
     */
     int32 time_for_click_;
+    /*! Number of threads used to classify map tiles when a mission is loaded.*/
+    int surfaces_threads_;
+    /*! True means the threaded tile classification is compared with a serial one.*/
+    bool check_surfaces_;
+    /*! True means tiles crossed by shots are also checked the old way.*/
+    bool check_los_tiles_;
+    /*! True means objectives are polled every tick to check triggers are not missed.*/
+    bool check_objectives_;
+    /*! Number of threads used to evaluate ped behaviours.*/
+    int ai_threads_;
+    /*! Maximum number of throttled ped behaviours executed per step. 0 means no limit.*/
+    int ai_budget_;
+    /*! Maximum memory in KB used by the cache of maps. 0 means no limit.*/
+    int32 maps_memory_budget_;
     /*! Language file. */
     ConfigFile  *language_;
     FS_Lang curr_language_;
@@ -0,0 +1,300 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+/*
+ * Micro benchmarks of low level code. They work on generated data
+ * so they can be run without the game data and give timings that can be
+ * compared from one build to another (run it before and after a change).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <SDL.h>
+
+#include "map.h"
+#include "gfx/tilemanager.h"
+#include "gfx/screen.h"
+#include "utils/portablefile.h"
+
+/*!
+ * A tile manager with generated tiles : tile 0 is transparent,
+ * the type of the other tiles cycles through all types.
+ */
+class GeneratedTileManager : public TileManager {
+public:
+    GeneratedTileManager() {
+        uint8 pixels[TILE_WIDTH * TILE_HEIGHT];
+        memset(pixels, 0, sizeof(pixels));
+        for (int i = 0; i < kNumOfTiles; i++) {
+            a_tiles_[i] = new Tile(i, pixels, i != 0,
+                (Tile::EType) (i % Tile::kNbTypes));
+        }
+    }
+};
+
+//! Small LCG so the generated data is the same on every platform
+static uint32 nextRandom(uint32 &seed) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static void writeLE32(std::vector<uint8> &data, size_t offset, uint32 value) {
+    data[offset] = value & 0xff;
+    data[offset + 1] = (value >> 8) & 0xff;
+    data[offset + 2] = (value >> 16) & 0xff;
+    data[offset + 3] = (value >> 24) & 0xff;
+}
+
+/*!
+ * Generates map data in the format read by Map::loadMap() : a city
+ * of rectangular buildings of random size and height on a ground level.
+ */
+static void generateMapData(int maxX, int maxY, int maxZ, std::vector<uint8> &data) {
+    uint32 seed = 1;
+    std::vector<int> heights(maxX * maxY, 1);
+    int nbBuildings = maxX * maxY / 40;
+    for (int b = 0; b < nbBuildings; b++) {
+        int bx = nextRandom(seed) % maxX;
+        int by = nextRandom(seed) % maxY;
+        int bw = 2 + nextRandom(seed) % 7;
+        int bh = 2 + nextRandom(seed) % 7;
+        int height = 2 + nextRandom(seed) % (maxZ - 2);
+        for (int y = by; y < by + bh && y < maxY; y++) {
+            for (int x = bx; x < bx + bw && x < maxX; x++) {
+                heights[y * maxX + x] = height;
+            }
+        }
+    }
+
+    size_t lookupSize = maxX * maxY * 4;
+    data.assign(12 + lookupSize + maxX * maxY * maxZ, 0);
+    writeLE32(data, 0, maxX);
+    writeLE32(data, 4, maxY);
+    writeLE32(data, 8, maxZ);
+
+    for (int i = 0; i < maxX * maxY; i++) {
+        uint32 offset = lookupSize + i * maxZ;
+        writeLE32(data, 12 + i * 4, offset);
+
+        uint8 *column = &data[12 + offset];
+        column[0] = Tile::kGround;
+        for (int z = 1; z < heights[i]; z++) {
+            column[z] = 1 + nextRandom(seed) % 255;
+        }
+    }
+}
+
+/*!
+ * Walks the map tiles in the same order as MapRenderer::render() does,
+ * for every viewport that covers the map.
+ * \return the number of visible tiles so the walk is not optimized away
+ */
+static int walkLikeRenderer(Map &map) {
+    int visible = 0;
+    for (int vy = 0; vy < map.height(); vy += Screen::kScreenHeight) {
+        for (int vx = 0; vx < map.width(); vx += Screen::kScreenWidth) {
+            TilePoint mtp = map.screenToTilePoint(vx, vy);
+            int sw = mtp.tx;
+            int chk = Screen::kScreenWidth / (TILE_WIDTH / 2) + 2
+                + Screen::kScreenHeight / (TILE_HEIGHT / 3) + map.maxZ() * 2;
+            int sh = mtp.ty - 8;
+            int shm = sh + chk;
+            int chky = sh < 0 ? 0 : sh;
+            int zr = shm + map.maxZ() + 1;
+
+            for (int inc = 0; inc < zr; ++inc) {
+                int ye = sh + inc;
+                int ys = ye - map.maxZ() - 2;
+                int tile_z = map.maxZ() + 1;
+                for (int yb = ys; yb < ye; ++yb) {
+                    if (yb < 0 || yb < sh || yb >= shm) {
+                        --tile_z;
+                        continue;
+                    }
+                    int tile_y = yb;
+                    for (int tile_x = sw; tile_y >= chky && tile_x < map.maxX(); ++tile_x) {
+                        if (tile_x < 0 || tile_y >= map.maxY()) {
+                            --tile_y;
+                            continue;
+                        }
+                        if (tile_z <= map.maxZAt(tile_x, tile_y) &&
+                                map.getTileAt(tile_x, tile_y, tile_z)->notTransparent()) {
+                            visible++;
+                        }
+                        --tile_y;
+                    }
+                    --tile_z;
+                }
+            }
+        }
+    }
+    return visible;
+}
+
+/*!
+ * Reads every tile then probes its six neighbours, as the surfaces
+ * are built in Mission::setSurfaces().
+ * \return a sum of walk data so the walk is not optimized away
+ */
+static int walkLikeSurfaces(Map &map) {
+    int sum = 0;
+    for (int y = 0; y < map.maxY(); y++) {
+        for (int x = 0; x < map.maxX(); x++) {
+            for (int z = 0; z < map.maxZ(); z++) {
+                sum += map.getTileAt(x, y, z)->getWalkData();
+                sum += map.getTileAt(x - 1, y, z)->getWalkData();
+                sum += map.getTileAt(x + 1, y, z)->getWalkData();
+                sum += map.getTileAt(x, y - 1, z)->getWalkData();
+                sum += map.getTileAt(x, y + 1, z)->getWalkData();
+                sum += map.getTileAt(x, y, z - 1)->getWalkData();
+                sum += map.getTileAt(x, y, z + 1)->getWalkData();
+            }
+        }
+    }
+    return sum;
+}
+
+/*!
+ * Times the map accesses of the renderer and the surface builder
+ * on a map of the size of the biggest game maps.
+ */
+static void benchMap(int iterations) {
+    GeneratedTileManager tileManager;
+    std::vector<uint8> data;
+    generateMapData(128, 128, 12, data);
+    Map map(&tileManager, 0);
+    map.loadMap(&data[0]);
+
+    uint32 start = SDL_GetTicks();
+    int visible = 0;
+    for (int i = 0; i < iterations; i++) {
+        visible += walkLikeRenderer(map);
+    }
+    printf("map render walk   : %5u ms (%d tiles)\n", SDL_GetTicks() - start, visible);
+
+    start = SDL_GetTicks();
+    int sum = 0;
+    for (int i = 0; i < iterations; i++) {
+        sum += walkLikeSurfaces(map);
+    }
+    printf("map surfaces walk : %5u ms (%d)\n", SDL_GetTicks() - start, sum);
+}
+
+/*!
+ * Number of records in the file of the PortableFile benchmark : each
+ * record looks like an agent in a saved game.
+ */
+static const int kNbFileRecords = 2000;
+//! Name of the file written and read by the PortableFile benchmark
+static const char *kBenchFileName = "bench.tmp";
+
+//! Writes the records of the PortableFile benchmark
+static void saveRecords() {
+    // the file is written when it goes out of scope
+    PortableFile outfile;
+    outfile.open_to_overwrite(kBenchFileName);
+    for (int i = 0; i < kNbFileRecords; i++) {
+        outfile.write32(i);
+        outfile.write_string("Agent name", 20);
+        outfile.write8b(i % 2 == 0);
+        outfile.write8(i % 256);
+        outfile.write16(i % 65536);
+        outfile.write_float(i * 0.5f);
+        outfile.write_double(i * 0.25);
+        outfile.write64(i * 1000000ULL);
+    }
+}
+
+//! Reads the records of the PortableFile benchmark
+static uint32 loadRecords() {
+    PortableFile infile;
+    infile.open_to_read(kBenchFileName);
+    uint32 sum = 0;
+    for (int i = 0; i < kNbFileRecords && infile; i++) {
+        sum += infile.read32();
+        sum += infile.read_string(20, true).size();
+        sum += infile.read8b();
+        sum += infile.read8();
+        sum += infile.read16();
+        sum += (uint32) infile.read_float();
+        sum += (uint32) infile.read_double();
+        sum += (uint32) infile.read64();
+    }
+    return sum;
+}
+
+/*!
+ * Times the saving and loading of a file through PortableFile. The file
+ * is written in the current directory and removed afterwards.
+ */
+static void benchPortableFile(int iterations) {
+    uint32 start = SDL_GetTicks();
+    for (int i = 0; i < iterations; i++) {
+        saveRecords();
+    }
+    printf("file save         : %5u ms\n", SDL_GetTicks() - start);
+
+    start = SDL_GetTicks();
+    uint32 sum = 0;
+    for (int i = 0; i < iterations; i++) {
+        sum += loadRecords();
+    }
+    printf("file load         : %5u ms (%u)\n", SDL_GetTicks() - start, sum);
+
+    remove(kBenchFileName);
+}
+
+static void usage() {
+    printf("Usage: bench [-n <iterations>]\n");
+    printf("Options:\n");
+    printf("\t-n\tnumber of times each benchmark is run (default 20)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int iterations = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp("-n", argv[i]) && i + 1 < argc) {
+            i++;
+            iterations = atoi(argv[i]);
+        } else {
+            usage();
+        }
+    }
+
+    if (SDL_Init(SDL_INIT_TIMER) < 0) {
+        printf("Cannot initialize SDL timer: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    printf("%d iterations\n", iterations);
+    benchMap(iterations);
+    benchPortableFile(iterations);
+
+    SDL_Quit();
+    return 0;
+}
@@ -38,7 +38,7 @@
 
 // Set this to enable speed measurement of code execution
 // 0 > disable
-// 1 > map renderer
+// 1 > map renderer and walkable surfaces
 #define EXEC_SPEED_TIME 0
 
 #if EXEC_SPEED_TIME == 1
@@ -25,13 +25,17 @@
  *                                                                      *
  ************************************************************************/
 
-#include <list>
+#include <algorithm>
 
 #include "core/gamecontroller.h"
 #include "core/gamesession.h"
 #include "mission.h"
+#include "utils/log.h"
 
 GameController::GameController() {
+    nbEventsQueued_ = 0;
+    nbEventsCoalesced_ = 0;
+    dispatchDepth_ = 0;
     agents_.setModManager(&mods_);
     agents_.setWeaponManager(&weaponMgr_);
 }
@@ -54,6 +58,7 @@ bool GameController::reset() {
 void GameController::clearAllListeners() {
     game_listeners_.clear();
     mission_listeners_.clear();
+    clearPendingEvents();
 }
 
 /*!
@@ -63,66 +68,157 @@ void GameController::clearAllListeners() {
  */
 void GameController::addListener(GameEventListener *pListener, GameEvent::EEventStream stream) {
     if (pListener) {
-        if (stream == GameEvent::kGame) {
-            // Check if listener has already subscribed
-            for (std::list < GameEventListener * >::iterator it = game_listeners_.begin();
-             it != game_listeners_.end(); it++) {
-                 if (pListener == *it) {
-                     return;
-                 }
+        std::vector<GameEventListener *> &listeners =
+            stream == GameEvent::kGame ? game_listeners_ : mission_listeners_;
+        // Check if listener has already subscribed
+        for (size_t i = 0; i < listeners.size(); i++) {
+            if (pListener == listeners[i]) {
+                return;
             }
-            game_listeners_.push_back(pListener);
-        } else if (stream == GameEvent::kMission) {
-            // Check if listener has already subscribed
-            for (std::list < GameEventListener * >::iterator it = mission_listeners_.begin();
-             it != mission_listeners_.end(); it++) {
-                 if (pListener == *it) {
-                     return;
-                 }
-            }
-            mission_listeners_.push_back(pListener);
         }
+        listeners.push_back(pListener);
     }
 }
 
 //! Removes the listener from the given stream of events
 void GameController::removeListener(GameEventListener *pListener, GameEvent::EEventStream stream) {
     if (pListener) {
-        if (stream == GameEvent::kGame) {
-            for (std::list < GameEventListener * >::iterator it = game_listeners_.begin();
-             it != game_listeners_.end(); it++) {
-                 if (pListener == *it) {
-                     game_listeners_.erase(it);
-                     return;
-                 }
-            }
-        } else if (stream == GameEvent::kMission) {
-            for (std::list < GameEventListener * >::iterator it = mission_listeners_.begin();
-             it != mission_listeners_.end(); it++) {
-                 if (pListener == *it) {
-                     mission_listeners_.erase(it);
-                     return;
-                 }
+        std::vector<GameEventListener *> &listeners =
+            stream == GameEvent::kGame ? game_listeners_ : mission_listeners_;
+        for (size_t i = 0; i < listeners.size(); i++) {
+            if (pListener == listeners[i]) {
+                if (dispatchDepth_ > 0) {
+                    // an event is being sent : remove it at the end
+                    listeners[i] = NULL;
+                } else {
+                    listeners.erase(listeners.begin() + i);
+                }
+                return;
             }
         }
     }
 }
-//! Sends the event to the listeners
+
+/*!
+ * Events that only tell a state has changed are coalesced : a ped drawing
+ * his weapon twice before the next dispatch or several policemen warning
+ * the agents give only one event. Objective and death events are never
+ * coalesced as listeners must see all of them in order.
+ */
+bool GameController::isCoalescable(GameEvent::EEventType type) {
+    return type == GameEvent::kEvtWarnAgent;
+}
+
+/*!
+ * A listener may remove itself or another listener while handling the
+ * event : it is only marked as removed so that no other listener is
+ * skipped, and erased once every listener has been called.
+ */
+void GameController::sendToListeners(std::vector<GameEventListener *> &listeners, GameEvent &evt) {
+    dispatchDepth_++;
+    for (size_t i = 0; i < listeners.size(); i++) {
+        if (listeners[i]) {
+            listeners[i]->handleGameEvent(evt);
+        }
+    }
+    dispatchDepth_--;
+
+    if (dispatchDepth_ == 0) {
+        purgeRemovedListeners(game_listeners_);
+        purgeRemovedListeners(mission_listeners_);
+    }
+}
+
+//! Erases the listeners removed during a dispatch
+void GameController::purgeRemovedListeners(std::vector<GameEventListener *> &listeners) {
+    for (size_t i = 0; i < listeners.size(); ) {
+        if (listeners[i] == NULL) {
+            listeners.erase(listeners.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+/*!
+ * Events on the game stream are sent immediately to the listeners.
+ * Events on the mission stream are queued until dispatchMissionEvents()
+ * is called so listeners don't react in the middle of another object's
+ * update. A coalescable event is dropped if one of the same type is already
+ * pending. Weapon selections are merged into a single kEvtArmedPedsChanged
+ * event, queued at the position of the first selection, so that listeners
+ * process all peds who drew or cleared their weapon at once.
+ * \param evt The event
+ */
 void GameController::fireGameEvent(GameEvent & evt) {
-    switch (evt.stream) {
-    case GameEvent::kGame:
-        for (std::list < GameEventListener * >::iterator it = game_listeners_.begin();
-                        it != game_listeners_.end(); it++) {
-            (*it)->handleGameEvent(evt);
+    if (evt.stream == GameEvent::kGame) {
+        sendToListeners(game_listeners_, evt);
+        return;
+    }
+
+    nbEventsQueued_++;
+    if (evt.type == GameEvent::kEvtShootingWeaponSelected ||
+            evt.type == GameEvent::kEvtShootingWeaponDeselected) {
+        if (pendingCoalescable_.count(GameEvent::kEvtArmedPedsChanged) == 0) {
+            GameEvent armedEvt(GameEvent::kMission, GameEvent::kEvtArmedPedsChanged);
+            pendingEvents_.push_back(armedEvt);
+            pendingCoalescable_.insert(GameEvent::kEvtArmedPedsChanged);
+        } else {
+            nbEventsCoalesced_++;
         }
-        break;
-    case GameEvent::kMission:
-        for (std::list < GameEventListener * >::iterator it = mission_listeners_.begin();
-                        it != mission_listeners_.end(); it++) {
-            (*it)->handleGameEvent(evt);
+        pendingArmedChanges_.add(evt.pPed, evt.type == GameEvent::kEvtShootingWeaponSelected);
+        return;
+    }
+
+    if (isCoalescable(evt.type)) {
+        if (pendingCoalescable_.count(evt.type) != 0) {
+            nbEventsCoalesced_++;
+            return;
         }
-        break;
+        pendingCoalescable_.insert(evt.type);
     }
+    pendingEvents_.push_back(evt);
+}
+
+/*!
+ * Sends the pending mission events in the order they were fired.
+ * Events fired by listeners during the dispatch are sent in the same call.
+ * The armed state changes event is skipped when every ped went back
+ * to his previous state.
+ */
+void GameController::dispatchMissionEvents() {
+    while (!pendingEvents_.empty()) {
+        dispatchingEvents_.swap(pendingEvents_);
+        dispatchingArmedChanges_.swap(pendingArmedChanges_);
+        pendingArmedChanges_.clear();
+        pendingCoalescable_.clear();
+        for (size_t i = 0; i < dispatchingEvents_.size(); i++) {
+            GameEvent &evt = dispatchingEvents_[i];
+            if (evt.type == GameEvent::kEvtArmedPedsChanged) {
+                if (dispatchingArmedChanges_.empty()) {
+                    continue;
+                }
+                evt.pArmedChanges = &dispatchingArmedChanges_;
+            }
+            sendToListeners(mission_listeners_, evt);
+        }
+        dispatchingEvents_.clear();
+        dispatchingArmedChanges_.clear();
+    }
+}
+
+/*!
+ * Called when leaving a mission : pending events refer to objects
+ * that will be destroyed.
+ */
+void GameController::clearPendingEvents() {
+    LOG(Log::k_FLG_GAME, "GameController", "clearPendingEvents", ("%d mission events queued, %d coalesced, %d dropped",
+        nbEventsQueued_, nbEventsCoalesced_, (int) pendingEvents_.size()));
+    pendingEvents_.clear();
+    pendingCoalescable_.clear();
+    pendingArmedChanges_.clear();
+    nbEventsQueued_ = 0;
+    nbEventsCoalesced_ = 0;
 }
 
 /*!
@@ -277,12 +373,82 @@ int GameController::get_nb_mvt_for_active_synds(int nb_active_synds) {
  * This method is just a wrapper for the call of GameController.fireGameEvent().
  * \param stream The stream of the event
  * \param type The type of the event
- * \param pCtx The context of the event.
+ * \param pPed The ped concerned by the event.
  */
-void GameEvent::sendEvt(EEventStream stream, EEventType type, void *pCtx) {
-    GameEvent evt;
-    evt.stream = stream;
-    evt.type = type;
-    evt.pCtxt = pCtx;
+void GameEvent::sendEvt(EEventStream stream, EEventType type, PedInstance *pPed) {
+    GameEvent evt(stream, type);
+    evt.pPed = pPed;
     g_gameCtrl.fireGameEvent(evt);
 }
+
+/*!
+ * If the ped is already in the list, only his new state is kept.
+ * \param pPed The ped who drew or cleared his weapon
+ * \param armed True if the ped drew his weapon
+ */
+void ArmedPedsChanges::add(PedInstance *pPed, bool armed) {
+    std::map<PedInstance *, Change>::iterator it = changes_.find(pPed);
+    if (it == changes_.end()) {
+        Change change;
+        change.wasArmed = !armed;
+        change.armed = armed;
+        changes_[pPed] = change;
+        count(armed, 1);
+        return;
+    }
+
+    Change &change = it->second;
+    if (change.armed != armed) {
+        if (change.armed != change.wasArmed) {
+            // the ped is back to his previous state
+            count(change.armed, -1);
+        } else {
+            count(armed, 1);
+        }
+        change.armed = armed;
+    }
+}
+
+//! Updates the number of peds who drew or cleared their weapon
+void ArmedPedsChanges::count(bool armed, int delta) {
+    if (armed) {
+        nbArmed_ += delta;
+    } else {
+        nbCleared_ += delta;
+    }
+}
+
+/*!
+ * Behaviours use this to know if they must react without looking at
+ * every ped in the list.
+ * \param armed True to look for peds who drew their weapon
+ * \param pExcluded This ped is not counted (usually the ped who reacts)
+ */
+bool ArmedPedsChanges::hasChange(bool armed, PedInstance *pExcluded) const {
+    int nb = armed ? nbArmed_ : nbCleared_;
+    if (pExcluded != NULL && contains(pExcluded, armed)) {
+        nb--;
+    }
+    return nb > 0;
+}
+
+bool ArmedPedsChanges::contains(PedInstance *pPed, bool armed) const {
+    std::map<PedInstance *, Change>::const_iterator it = changes_.find(pPed);
+    if (it == changes_.end()) {
+        return false;
+    }
+    const Change &change = it->second;
+    return change.armed == armed && change.armed != change.wasArmed;
+}
+
+void ArmedPedsChanges::clear() {
+    changes_.clear();
+    nbArmed_ = 0;
+    nbCleared_ = 0;
+}
+
+void ArmedPedsChanges::swap(ArmedPedsChanges &other) {
+    changes_.swap(other.changes_);
+    std::swap(nbArmed_, other.nbArmed_);
+    std::swap(nbCleared_, other.nbCleared_);
+}
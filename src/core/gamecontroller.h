@@ -29,7 +29,9 @@
 #define CORE_GAMECONTROLLER_H_
 
 #include <cassert>
-#include <list>
+#include <map>
+#include <set>
+#include <vector>
 
 #include "utils/singleton.h"
 #include "core/gameevent.h"
@@ -64,8 +66,12 @@ class GameController : public Singleton < GameController > {
     void addListener(GameEventListener *pListener, GameEvent::EEventStream stream);
     //! Removes the listener from the given stream of events
     void removeListener(GameEventListener *pListener, GameEvent::EEventStream stream);
-    //! Sends the event to the listeners
+    //! Sends the event to the listeners or queues it for the mission stream
     void fireGameEvent(GameEvent & evt);
+    //! Sends the queued mission events to the listeners
+    void dispatchMissionEvents();
+    //! Drops the queued mission events
+    void clearPendingEvents();
     //! Removes all listeners from every stream
     void clearAllListeners();
 
@@ -97,6 +103,12 @@ class GameController : public Singleton < GameController > {
     //! Checks if mission is completed and updates game state
     void handle_mission_end(Mission *p_mission);
 private:
+    //! Calls every listener of the list with the event
+    void sendToListeners(std::vector<GameEventListener *> &listeners, GameEvent &evt);
+    //! Erases the listeners removed during a dispatch
+    void purgeRemovedListeners(std::vector<GameEventListener *> &listeners);
+    //! Returns true if an event of that type is dropped when one is already pending
+    static bool isCoalescable(GameEvent::EEventType type);
     //! Simulates syndicates fighting for countries
     void simulate_enemy_moves();
     // helper method
@@ -114,9 +126,25 @@ private:
     /*! Manager of missions.*/
     MissionManager missions_;
     /*! List of listeners for game stream events.*/
-    std::list<GameEventListener *> game_listeners_;
+    std::vector<GameEventListener *> game_listeners_;
     /*! List of listeners for mission stream events.*/
-    std::list<GameEventListener *> mission_listeners_;
+    std::vector<GameEventListener *> mission_listeners_;
+    /*! Mission events waiting for the next dispatch.*/
+    std::vector<GameEvent> pendingEvents_;
+    /*! Mission events being dispatched.*/
+    std::vector<GameEvent> dispatchingEvents_;
+    /*! Types of the coalescable events in pendingEvents_.*/
+    std::set<GameEvent::EEventType> pendingCoalescable_;
+    /*! Peds who drew or cleared their weapon since the last dispatch.*/
+    ArmedPedsChanges pendingArmedChanges_;
+    /*! Armed state changes being dispatched.*/
+    ArmedPedsChanges dispatchingArmedChanges_;
+    /*! Number of mission events queued since last clear.*/
+    int nbEventsQueued_;
+    /*! Number of mission events dropped or merged with a pending one.*/
+    int nbEventsCoalesced_;
+    /*! Number of dispatches in progress : listeners can't be erased while > 0.*/
+    int dispatchDepth_;
 };
 
 #define g_gameCtrl    GameController::singleton()
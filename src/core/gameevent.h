@@ -24,12 +24,58 @@
 #define GAMEVENT_H
 
 #include <stddef.h>
+#include <map>
+
+#include "model/position.h"
+
+class PedInstance;
+class MapObject;
+class Research;
+
+/*!
+ * List of the peds that drew or cleared their weapon since the last
+ * dispatch of mission events. A ped is listed once with his last state
+ * and is dropped if he went back to the state he had before.
+ */
+class ArmedPedsChanges {
+public:
+    ArmedPedsChanges() : nbArmed_(0), nbCleared_(0) {}
+
+    //! Records that the ped drew (armed is true) or cleared his weapon
+    void add(PedInstance *pPed, bool armed);
+    //! Returns true if a ped other than pExcluded went to the given state
+    bool hasChange(bool armed, PedInstance *pExcluded = NULL) const;
+    //! Returns true if the ped went to the given state
+    bool contains(PedInstance *pPed, bool armed) const;
+    //! Returns true if no ped changed his state
+    bool empty() const { return nbArmed_ == 0 && nbCleared_ == 0; }
+    //! Removes all peds from the list
+    void clear();
+    //! Exchanges the content with the other list
+    void swap(ArmedPedsChanges &other);
+
+private:
+    void count(bool armed, int delta);
+
+    struct Change {
+        bool wasArmed;
+        bool armed;
+    };
+    //! State of each ped who changed
+    std::map<PedInstance *, Change> changes_;
+    //! Number of listed peds who drew their weapon
+    int nbArmed_;
+    //! Number of listed peds who cleared their weapon
+    int nbCleared_;
+};
 
 /*!
  * An event is dispatched by the Game controller towards listener that
  * will handle it. There are several stream on which events are posted:
  * A game stream that concerns general events and a mission stream that
  * contains events inside a mission.
+ * Events on the game stream are dispatched immediately whereas events
+ * on the mission stream are queued and dispatched once per game tick.
  */
 class GameEvent {
 public:
@@ -57,22 +103,42 @@ public:
         kObjFailed,
         /*! Send when an objective has been completed succesfuly.*/
         kObjCompleted,
-        /*! Sent when a ped has shown his weapon.*/
+        /*! Sent when a ped has shown his weapon (merged into kEvtArmedPedsChanged).*/
         kEvtShootingWeaponSelected,
-        /*! Sent when a ped cleared his selected shooting weapon.*/
+        /*! Sent when a ped cleared his selected shooting weapon (merged into kEvtArmedPedsChanged).*/
         kEvtShootingWeaponDeselected,
         /*! Sent when a policeman warns a player agent.*/
-        kEvtWarnAgent
+        kEvtWarnAgent,
+        /*! Sent once per dispatch with all peds that drew or cleared their weapon.*/
+        kEvtArmedPedsChanged
     };
+
+    explicit GameEvent(EEventStream aStream = kGame, EEventType aType = kNone) {
+        stream = aStream;
+        type = aType;
+        pPed = NULL;
+        pTarget = NULL;
+        pResearch = NULL;
+        pArmedChanges = NULL;
+    }
+
     //! The stream on which the event is posted
     EEventStream stream;
     //! The type of event
     EEventType type;
-    //! An event may hold information for the listener
-    void *pCtxt;
+    //! Ped who died or drew/cleared his weapon
+    PedInstance *pPed;
+    //! Target of an objective for kObjTargetSet
+    MapObject *pTarget;
+    //! Research that has ended for kResearch
+    Research *pResearch;
+    //! Evacuation point for kObjEvacuate
+    WorldPoint locW;
+    //! Peds who drew or cleared their weapon for kEvtArmedPedsChanged
+    const ArmedPedsChanges *pArmedChanges;
 
     //! Convenient method to send game event
-    static void sendEvt(EEventStream stream, EEventType type, void *pCtx = NULL);
+    static void sendEvt(EEventStream stream, EEventType type, PedInstance *pPed = NULL);
 };
 
 /*!
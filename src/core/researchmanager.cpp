@@ -178,10 +178,8 @@ bool ResearchManager::reset() {
 }
 
 void ResearchManager::fireGameEvent(Research *pResearch) {
-    GameEvent evt;
-    evt.stream = GameEvent::kGame;
-    evt.type = GameEvent::kResearch;
-    evt.pCtxt = pResearch;
+    GameEvent evt(GameEvent::kGame, GameEvent::kResearch);
+    evt.pResearch = pResearch;
     g_gameCtrl.fireGameEvent(evt);
 }
 
@@ -0,0 +1,166 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <stdio.h>
+#include <SDL_thread.h>
+
+#include "core/savegamewriter.h"
+#include "utils/ccrc32.h"
+#include "utils/log.h"
+
+/*! Size of the blocks written at once.*/
+static const int kBlockSize = 4096;
+
+SaveGameWriter::SaveGameWriter() {
+    pThread_ = NULL;
+    started_ = false;
+    written_ = 0;
+    done_ = false;
+    result_ = false;
+}
+
+SaveGameWriter::~SaveGameWriter() {
+    finish();
+}
+
+/*!
+ * Computes the CRC of the data and starts the thread that writes
+ * the file. If the thread cannot be created, the file is written
+ * before returning. A previous write must be finished.
+ * \param path Full path of the save file
+ * \param data The encoded game
+ * \return false if a write is already in progress
+ */
+bool SaveGameWriter::start(const std::string &path, const std::string &data) {
+    if (started_) {
+        FSERR(Log::k_FLG_IO, "SaveGameWriter", "start", ("A game is already being saved\n"))
+        return false;
+    }
+
+    path_ = path;
+    data_ = data;
+    CCRC32 crc;
+    uint32 value = crc.FullCRC((const unsigned char *) data_.data(), data_.size());
+    // CRC is stored big-endian like the rest of the file
+    data_.push_back((char) ((value >> 24) & 0xff));
+    data_.push_back((char) ((value >> 16) & 0xff));
+    data_.push_back((char) ((value >> 8) & 0xff));
+    data_.push_back((char) (value & 0xff));
+
+    written_ = 0;
+    done_ = false;
+    result_ = false;
+    started_ = true;
+    pThread_ = SDL_CreateThread(writeLoop, this);
+    if (pThread_ == NULL) {
+        FSERR(Log::k_FLG_IO, "SaveGameWriter", "start", ("Cannot create writer thread\n"));
+        // write the file now
+        writeLoop(this);
+    }
+    return true;
+}
+
+int SaveGameWriter::progress() const {
+    if (data_.empty()) {
+        return 0;
+    }
+    return (int) ((int64) written_ * 100 / data_.size());
+}
+
+/*!
+ * Waits for the thread to end. Does nothing if no write was started.
+ * \return true if the file was saved
+ */
+bool SaveGameWriter::finish() {
+    if (!started_) {
+        return false;
+    }
+    if (pThread_) {
+        SDL_WaitThread(pThread_, NULL);
+        pThread_ = NULL;
+    }
+    started_ = false;
+    data_.clear();
+    return result_;
+}
+
+int SaveGameWriter::writeLoop(void *pData) {
+    SaveGameWriter *pWriter = static_cast<SaveGameWriter *>(pData);
+    pWriter->result_ = pWriter->write();
+    pWriter->done_ = true;
+    return 0;
+}
+
+/*!
+ * Writes the data to a temporary file and renames it.
+ */
+bool SaveGameWriter::write() {
+    std::string tmpPath(path_);
+    tmpPath.append(".tmp");
+
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (!fp) {
+        FSERR(Log::k_FLG_IO, "SaveGameWriter", "write", ("Cannot write file %s\n", tmpPath.c_str()))
+        return false;
+    }
+
+    bool ok = true;
+    int size = data_.size();
+    while (ok && written_ < size) {
+        int len = size - written_ < kBlockSize ? size - written_ : kBlockSize;
+        ok = fwrite(data_.data() + written_, 1, len, fp) == (size_t) len;
+        written_ += len;
+    }
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok) {
+        // rename() does not replace an existing file on Windows
+        remove(path_.c_str());
+        ok = rename(tmpPath.c_str(), path_.c_str()) == 0;
+    }
+    if (!ok) {
+        FSERR(Log::k_FLG_IO, "SaveGameWriter", "write", ("Cannot write file %s\n", path_.c_str()))
+        remove(tmpPath.c_str());
+    }
+    LOG(Log::k_FLG_IO, "SaveGameWriter", "write", ("%d bytes written in %s", size, path_.c_str()))
+    return ok;
+}
+
+/*!
+ * Compares the CRC of the content with the one stored in the last 4 bytes.
+ * \param data Content of the save file
+ * \return false if the data is corrupted
+ */
+bool SaveGameWriter::checkCrc(const std::string &data) {
+    if (data.size() < 4) {
+        return false;
+    }
+
+    size_t size = data.size() - 4;
+    const unsigned char *crcBytes = (const unsigned char *) data.data() + size;
+    CCRC32 crc;
+    uint32 value = crc.FullCRC((const unsigned char *) data.data(), size);
+    uint32 stored = (crcBytes[0] << 24) | (crcBytes[1] << 16)
+        | (crcBytes[2] << 8) | crcBytes[3];
+    return value == stored;
+}
@@ -0,0 +1,79 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef CORE_SAVEGAMEWRITER_H_
+#define CORE_SAVEGAMEWRITER_H_
+
+#include <string>
+
+#include "common.h"
+
+struct SDL_Thread;
+
+/*!
+ * Writes a saved game in a separate thread so the menus stay responsive.
+ * The game is first encoded in memory by the caller, then the writer
+ * appends a CRC of the data and writes everything to a temporary file
+ * which replaces the save file only when complete. So an interrupted
+ * save never corrupts the previous one.
+ */
+class SaveGameWriter {
+public:
+    SaveGameWriter();
+    ~SaveGameWriter();
+
+    //! Starts writing the data in the given file
+    bool start(const std::string &path, const std::string &data);
+    //! Returns true while the data is being written
+    bool isWriting() const { return started_ && !done_; }
+    //! Returns true if a write was started and finish() not yet called
+    bool isStarted() const { return started_; }
+    //! Returns the percentage of data written
+    int progress() const;
+    //! Waits for the end of writing and returns the result
+    bool finish();
+
+    //! Checks the CRC at the end of a saved game
+    static bool checkCrc(const std::string &data);
+
+private:
+    static int writeLoop(void *pData);
+    bool write();
+
+private:
+    /*! Where to save the game.*/
+    std::string path_;
+    /*! Encoded game followed by its CRC.*/
+    std::string data_;
+    SDL_Thread *pThread_;
+    /*! True between start() and finish().*/
+    bool started_;
+    /*! Number of bytes written by the thread.*/
+    volatile int written_;
+    /*! Set by the thread when it's over.*/
+    volatile bool done_;
+    /*! Result of the write.*/
+    bool result_;
+};
+
+#endif  // CORE_SAVEGAMEWRITER_H_
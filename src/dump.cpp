@@ -492,9 +492,13 @@ void Screen::scale2x(int x, int y, int width, int height,
 
 #include <cstdio>
 #include <cstdlib>
+#include <set>
+#include <vector>
 
 #include "common.h"
 #include "editor/editorapp.h"
+#include "editor/mapexporter.h"
+#include "editor/missionindex.h"
 #include "utils/file.h"
 #include "utils/log.h"
 #include "default_ini.h"
@@ -530,6 +534,49 @@ void print_usage() {
 #else
     printf(" (default: $HOME/.freesynd/freesynd.ini)\n");
 #endif
+    printf("    -e, --export <dir>    export all maps to PNG files in <dir> and exit.\n");
+    printf("    -j, --jobs <n>        number of threads used to export.\n");
+    printf("    --sprites             also export sprite sheets.\n");
+    printf("    --force               export images even if their source has not changed.\n");
+}
+
+/*!
+ * Exports the maps of all missions and optionally the sprite sheets.
+ * \return 0 if all images were exported or up to date.
+ */
+int exportData(EditorApp *app, const std::string &outDir, int nbJobs,
+        bool withSprites, bool force) {
+    if (nbJobs < 1) {
+        nbJobs = g_Ctx.getSurfacesThreads();
+    }
+
+    MapExporter exporter(outDir);
+    exporter.setForce(force);
+    if (!exporter.initialize()) {
+        return 1;
+    }
+
+    MissionIndex index;
+    index.load(nbJobs);
+    std::set<uint16> ids;
+    for (int i = 1; i <= MissionIndex::kNbMissions; i++) {
+        if (index.entry(i).valid) {
+            ids.insert(index.entry(i).mapId);
+        }
+    }
+    std::vector<uint16> mapIds(ids.begin(), ids.end());
+
+    exporter.exportMaps(app->maps(), mapIds, nbJobs);
+
+    if (withSprites) {
+        app->gameSprites().load();
+        exporter.exportSprites(app->gameSprites(), nbJobs);
+    }
+
+    printf("%d images exported, %d up to date, %d failed\n",
+        exporter.nbWritten(), exporter.nbSkipped(), exporter.nbFailed());
+
+    return exporter.nbFailed() == 0 ? 0 : 1;
 }
 
 int main(int argc, char *argv[]) {
@@ -544,6 +591,11 @@ int main(int argc, char *argv[]) {
     std::string iniPath;
 
     bool disable_sound = true;
+    // Batch export is done instead of running the editor when a directory is given
+    std::string exportDir;
+    int nbJobs = 0;
+    bool withSprites = false;
+    bool force = false;
 
     for (int i = 1; i < argc; ++i) {
 
@@ -553,9 +605,39 @@ int main(int argc, char *argv[]) {
         }
 
         if (0 == strcmp("-i", argv[i]) || 0 == strcmp("--ini", argv[i])) {
+            if (i + 1 >= argc) {
+                print_usage();
+                return 1;
+            }
             i++;
             iniPath = argv[i];
         }
+
+        if (0 == strcmp("-e", argv[i]) || 0 == strcmp("--export", argv[i])) {
+            if (i + 1 >= argc) {
+                print_usage();
+                return 1;
+            }
+            i++;
+            exportDir = argv[i];
+        }
+
+        if (0 == strcmp("-j", argv[i]) || 0 == strcmp("--jobs", argv[i])) {
+            if (i + 1 >= argc) {
+                print_usage();
+                return 1;
+            }
+            i++;
+            nbJobs = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--sprites", argv[i])) {
+            withSprites = true;
+        }
+
+        if (0 == strcmp("--force", argv[i])) {
+            force = true;
+        }
     }
 
 #ifdef _DEBUG
@@ -586,6 +668,18 @@ int main(int argc, char *argv[]) {
     LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application..."))
     std::auto_ptr<EditorApp> app(new EditorApp(disable_sound));
 
+    if (exportDir.size() != 0) {
+        int res = 1;
+        if (app->initializeData(iniPath)) {
+            res = exportData(app.get(), exportDir, nbJobs, withSprites, force);
+        }
+        app->destroy();
+#ifdef _DEBUG
+        Log::close();
+#endif
+        return res;
+    }
+
     if (app->initialize(iniPath)) {
         LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application completed"))
         LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting game loop"))
@@ -173,6 +173,13 @@ bool EditorApp::readConfiguration() {
         string ourDataDir;
         context_->setFullScreen(conf.read("fullscreen", false));
         context_->setTimeForClick(conf.read("time_for_click", 80));
+        context_->setSurfacesThreads(conf.read("surfaces_threads", 4));
+        context_->setCheckSurfaces(conf.read("check_surfaces", false));
+        context_->setCheckLosTiles(conf.read("check_los_tiles", false));
+        context_->setCheckObjectives(conf.read("check_objectives", false));
+        context_->setAiThreads(conf.read("ai_threads", 4));
+        context_->setAiBudget(conf.read("ai_budget", 32));
+        context_->setMapsMemoryBudget(conf.read("maps_memory_budget", 8192));
         bool origDataDirFound = conf.readInto(origDataDir, "data_dir");
         bool ourDataDirFound = conf.readInto(ourDataDir, "freesynd_data_dir");
 
@@ -365,6 +372,7 @@ bool EditorApp::initialize(const std::string& iniPath) {
     if (!maps().initialize()) {
         return false;
     }
+    maps().setMemoryBudget(context_->getMapsMemoryBudget() * 1024);
 
     LOG(Log::k_FLG_INFO, "EditorApp", "initialize", ("Loading game sounds..."))
     if (!game_sounds_.loadSounds(SoundManager::SAMPLES_GAME)) {
@@ -379,6 +387,28 @@ bool EditorApp::initialize(const std::string& iniPath) {
     return true;
 }
 
+/*!
+ * Reads the configuration and the tileset without opening a window
+ * so the data can be exported from the command line.
+ * \param iniPath The path to the config file.
+ * \return True if initialization is ok.
+ */
+bool EditorApp::initializeData(const std::string& iniPath) {
+    iniPath_ = iniPath;
+
+    if (!readConfiguration()) {
+        LOG(Log::k_FLG_GFX, "EditorApp", "initializeData", ("failed to read configuration..."))
+        return false;
+    }
+
+    if (!testOriginalData()) {
+        LOG(Log::k_FLG_GFX, "EditorApp", "initializeData", ("failed to test original Syndicate data..."))
+        return false;
+    }
+
+    return maps().initialize();
+}
+
 void EditorApp::waitForKeyPress() {
 
     while (running_) {
@@ -53,6 +53,8 @@ class EditorApp : public Singleton < EditorApp > {
 
     //! Initialize application
     bool initialize(const std::string& iniPath);
+    //! Initialize only what is needed to read the game data
+    bool initializeData(const std::string& iniPath);
 
     GameSpriteManager &gameSprites() {
         return game_sprites_;
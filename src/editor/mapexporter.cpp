@@ -0,0 +1,537 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <SDL_thread.h>
+#include <png.h>
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "editor/mapexporter.h"
+#include "map.h"
+#include "mapmanager.h"
+#include "gfx/spritemanager.h"
+#include "gfx/tile.h"
+#include "utils/ccrc32.h"
+#include "utils/file.h"
+#include "utils/log.h"
+
+const int MapExporter::kSpritesPerSheet = 256;
+const int MapExporter::kSheetWidth = 1024;
+
+/*!
+ * Creates the directory if it does not exist.
+ * \return False if the directory cannot be created.
+ */
+static bool createDirectory(const std::string &path) {
+#ifdef _WIN32
+    if (!CreateDirectory(path.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "createDirectory", ("Cannot create directory %s", path.c_str()))
+        return false;
+    }
+#else
+    DIR * rep = opendir(path.c_str());
+    if (rep == NULL) {
+        if (mkdir(path.c_str(), 0755) == -1) {
+            FSERR(Log::k_FLG_IO, "MapExporter", "createDirectory", ("Cannot create directory %s", path.c_str()))
+            return false;
+        }
+    } else {
+        closedir(rep);
+    }
+#endif
+    return true;
+}
+
+MapExporter::MapExporter(const std::string &outDir) : outDir_(outDir)
+{
+    memset(palette_, 0, sizeof(palette_));
+    paletteChecksum_ = 0;
+    force_ = false;
+    nbWritten_ = 0;
+    nbSkipped_ = 0;
+    nbFailed_ = 0;
+}
+
+/*!
+ * Reads the palette and creates the output directory.
+ * \return False if the palette cannot be read.
+ */
+bool MapExporter::initialize() {
+    int size;
+    uint8 *pal = File::loadOriginalFile("hpal02.dat", size);
+    if (pal == NULL || size != 768) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "initialize", ("Cannot read palette hpal02.dat"))
+        delete[] pal;
+        return false;
+    }
+
+    for (int i = 0; i < 768; i++) {
+        palette_[i] = (pal[i] << 2) | (pal[i] >> 4);
+    }
+
+    CCRC32 crc;
+    paletteChecksum_ = crc.FullCRC(pal, size);
+    delete[] pal;
+
+    return createDirectory(outDir_);
+}
+
+/*!
+ * Maps whose source has changed are loaded by the calling thread as
+ * the MapManager cannot be shared, then they are drawn and written
+ * by the given number of threads. Maps are exported in batches of one
+ * map per thread : they stay locked while the threads draw them so the
+ * manager cannot release them, then they are unlocked before the next
+ * batch is loaded so the map memory budget is respected.
+ * \param maps Manager used to load the maps
+ * \param mapIds Ids of maps to export
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void MapExporter::exportMaps(MapManager &maps, const std::vector<uint16> &mapIds, int nbThreads) {
+    std::string dir(outDir_);
+    dir.append("/maps");
+    if (!createDirectory(dir)) {
+        nbFailed_ += (int) mapIds.size();
+        return;
+    }
+
+    items_.clear();
+    std::vector<uint16> lockedIds;
+    for (size_t i = 0; i < mapIds.size(); i++) {
+        char filename[20];
+        sprintf(filename, "map%02d.dat", mapIds[i]);
+
+        const char *files[] = { filename };
+        Item item;
+        if (!sourceChecksum(files, 1, &item.checksum)) {
+            nbFailed_++;
+            continue;
+        }
+
+        char name[20];
+        sprintf(name, "/map%02d.png", mapIds[i]);
+        item.path = dir + name;
+        if (!force_ && isUpToDate(item.path, item.checksum)) {
+            nbSkipped_++;
+            continue;
+        }
+
+        item.pMap = maps.loadMap(mapIds[i]);
+        if (item.pMap == NULL) {
+            nbFailed_++;
+            continue;
+        }
+        // loading the next maps must not release this one
+        maps.lockMap(mapIds[i]);
+        lockedIds.push_back(mapIds[i]);
+        item.pSprites = NULL;
+        item.firstSprite = 0;
+        item.lastSprite = 0;
+        items_.push_back(item);
+
+        if ((int) items_.size() >= nbThreads) {
+            exportMapBatch(maps, lockedIds, nbThreads);
+        }
+    }
+    exportMapBatch(maps, lockedIds, nbThreads);
+}
+
+/*!
+ * Exports the pending maps and unlocks them.
+ * \param maps Manager used to load the maps
+ * \param lockedIds Ids of the pending maps, emptied
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void MapExporter::exportMapBatch(MapManager &maps, std::vector<uint16> &lockedIds, int nbThreads) {
+    exportItems(nbThreads);
+    for (size_t i = 0; i < lockedIds.size(); i++) {
+        maps.unlockMap(lockedIds[i]);
+    }
+    lockedIds.clear();
+}
+
+/*!
+ * Sprites are drawn in sheets of kSpritesPerSheet sprites, one sheet
+ * per image. All sheets share the checksum of the sprite files.
+ * \param sprites Loaded game sprites
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void MapExporter::exportSprites(GameSpriteManager &sprites, int nbThreads) {
+    int nbSheets = (sprites.spriteCount() + kSpritesPerSheet - 1) / kSpritesPerSheet;
+    std::string dir(outDir_);
+    dir.append("/sprites");
+    if (!createDirectory(dir)) {
+        nbFailed_ += nbSheets;
+        return;
+    }
+
+    const char *files[] = { "hspr-0.tab", "hspr-0.dat" };
+    uint32 checksum;
+    if (!sourceChecksum(files, 2, &checksum)) {
+        nbFailed_ += nbSheets;
+        return;
+    }
+
+    items_.clear();
+    for (int i = 0; i < nbSheets; i++) {
+        char name[20];
+        sprintf(name, "/sheet%02d.png", i);
+
+        Item item;
+        item.path = dir + name;
+        item.checksum = checksum;
+        if (!force_ && isUpToDate(item.path, item.checksum)) {
+            nbSkipped_++;
+            continue;
+        }
+
+        item.pMap = NULL;
+        item.pSprites = &sprites;
+        item.firstSprite = i * kSpritesPerSheet;
+        item.lastSprite = item.firstSprite + kSpritesPerSheet;
+        if (item.lastSprite > sprites.spriteCount()) {
+            item.lastSprite = sprites.spriteCount();
+        }
+        items_.push_back(item);
+    }
+
+    exportItems(nbThreads);
+}
+
+/*!
+ * Items are distributed between the given number of threads, the
+ * calling thread exporting the first ones.
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void MapExporter::exportItems(int nbThreads) {
+    if (nbThreads > (int) items_.size()) {
+        nbThreads = items_.size();
+    }
+    if (nbThreads < 1) {
+        return;
+    }
+
+    std::vector<ExportJob> jobs(nbThreads);
+    std::vector<SDL_Thread *> threads(nbThreads, (SDL_Thread *) NULL);
+    for (int i = 0; i < nbThreads; i++) {
+        jobs[i].pExporter = this;
+        jobs[i].first = i;
+        jobs[i].step = nbThreads;
+        jobs[i].nbWritten = 0;
+        jobs[i].nbFailed = 0;
+    }
+
+    for (int i = 1; i < nbThreads; i++) {
+        threads[i] = SDL_CreateThread(exportLoop, &jobs[i]);
+        if (threads[i] == NULL) {
+            LOG(Log::k_FLG_IO, "MapExporter", "exportItems",
+                ("Cannot create thread, exporting images inline"));
+            exportLoop(&jobs[i]);
+        }
+    }
+
+    exportLoop(&jobs[0]);
+
+    for (int i = 0; i < nbThreads; i++) {
+        if (threads[i]) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+        nbWritten_ += jobs[i].nbWritten;
+        nbFailed_ += jobs[i].nbFailed;
+    }
+
+    LOG(Log::k_FLG_IO, "MapExporter", "exportItems", ("%d images exported with %d threads", (int) items_.size(), nbThreads))
+    items_.clear();
+}
+
+/*!
+ * Each thread draws its items in its own buffer which is reused
+ * from one item to the other.
+ */
+int MapExporter::exportLoop(void *pData) {
+    ExportJob *pJob = static_cast<ExportJob *>(pData);
+    MapExporter *pExporter = pJob->pExporter;
+    std::vector<uint8> pixels;
+
+    for (size_t i = pJob->first; i < pExporter->items_.size(); i += pJob->step) {
+        const Item &item = pExporter->items_[i];
+        int width, height;
+        if (item.pMap) {
+            drawMap(item.pMap, pixels, width, height);
+        } else {
+            drawSprites(item.pSprites, item.firstSprite, item.lastSprite,
+                pixels, width, height);
+        }
+
+        if (pExporter->writePng(item.path, width, height, pixels)
+            && writeChecksum(item.path, item.checksum)) {
+            pJob->nbWritten++;
+        } else {
+            pJob->nbFailed++;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * The checksum of the palette is included as it changes the images.
+ * \param files Names of the original files
+ * \param nbFiles Number of files
+ * \param pChecksum Set with the checksum
+ * \return False if a file cannot be read.
+ */
+bool MapExporter::sourceChecksum(const char **files, int nbFiles, uint32 *pChecksum) {
+    CCRC32 crc;
+    uint32 value = 0xffffffff;
+    crc.PartialCRC(&value, (const unsigned char *) &paletteChecksum_, sizeof(paletteChecksum_));
+
+    for (int i = 0; i < nbFiles; i++) {
+        int size;
+        uint8 *data = File::loadOriginalFile(files[i], size);
+        if (data == NULL) {
+            FSERR(Log::k_FLG_IO, "MapExporter", "sourceChecksum", ("Cannot read %s", files[i]))
+            return false;
+        }
+        crc.PartialCRC(&value, data, size);
+        delete[] data;
+    }
+
+    *pChecksum = value ^ 0xffffffff;
+    return true;
+}
+
+/*!
+ * The checksum is stored in a text file with the same name as
+ * the image plus the ".crc" extension.
+ */
+bool MapExporter::isUpToDate(const std::string &path, uint32 checksum) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    fclose(fp);
+
+    std::string crcPath(path);
+    crcPath.append(".crc");
+    fp = fopen(crcPath.c_str(), "r");
+    if (fp == NULL) {
+        return false;
+    }
+    unsigned int stored;
+    bool upToDate = fscanf(fp, "%x", &stored) == 1 && stored == checksum;
+    fclose(fp);
+    return upToDate;
+}
+
+bool MapExporter::writeChecksum(const std::string &path, uint32 checksum) {
+    std::string crcPath(path);
+    crcPath.append(".crc");
+    FILE *fp = fopen(crcPath.c_str(), "w");
+    if (fp == NULL) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "writeChecksum", ("Cannot write %s", crcPath.c_str()))
+        return false;
+    }
+    fprintf(fp, "%08x\n", checksum);
+    fclose(fp);
+    return true;
+}
+
+/*!
+ * Tiles are drawn in the same order as the MapRenderer : by increasing
+ * x + y + z, then by decreasing z and increasing x.
+ * \param pMap Map to draw
+ * \param pixels Buffer resized to the image
+ * \param width Set with the image width
+ * \param height Set with the image height
+ */
+void MapExporter::drawMap(Map *pMap, std::vector<uint8> &pixels, int &width, int &height) {
+    int maxX = pMap->maxX();
+    int maxY = pMap->maxY();
+    int maxZ = pMap->maxZ();
+
+    // screen position of the left and top most tiles
+    int offsetX = (maxX - maxY + 1) * (TILE_WIDTH / 2);
+    int offsetY = 2 * (TILE_HEIGHT / 3);
+    width = (maxX + maxY) * (TILE_WIDTH / 2);
+    height = (maxX + maxY + maxZ - 3) * (TILE_HEIGHT / 3) + TILE_HEIGHT;
+
+    pixels.assign(width * height, 0);
+
+    int maxDepth = (maxX - 1) + (maxY - 1) + (maxZ - 1);
+    for (int depth = 0; depth <= maxDepth; depth++) {
+        for (int z = (depth < maxZ ? depth : maxZ - 1); z >= 0; z--) {
+            int diag = depth - z;
+            int x = diag - (maxY - 1) > 0 ? diag - (maxY - 1) : 0;
+            for (; x < maxX && x <= diag; x++) {
+                int y = diag - x;
+                if (z > pMap->maxZAt(x, y)) {
+                    continue;
+                }
+                Tile *pTile = pMap->getTileAt(x, y, z);
+                if (pTile->notTransparent()) {
+                    int screenX = (maxX + x - y) * (TILE_WIDTH / 2) - offsetX;
+                    int screenY = (maxZ + x + y - z + 1) * (TILE_HEIGHT / 3) - offsetY;
+                    pTile->drawTo(&pixels[0], width, height, screenX, screenY);
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * Sprites are put side by side in rows.
+ * \param pSprites Sprites to draw
+ * \param first First sprite to draw
+ * \param last Sprite after the last one to draw
+ * \param pixels Buffer resized to the image
+ * \param width Set with the image width
+ * \param height Set with the image height
+ */
+void MapExporter::drawSprites(GameSpriteManager *pSprites, int first, int last,
+        std::vector<uint8> &pixels, int &width, int &height) {
+    width = kSheetWidth;
+    for (int i = first; i < last; i++) {
+        if (pSprites->sprite(i)->width() > width) {
+            width = pSprites->sprite(i)->width();
+        }
+    }
+
+    // first pass computes the height of the sheet
+    int x = 0, y = 0, rowHeight = 0;
+    for (int i = first; i < last; i++) {
+        Sprite *pSprite = pSprites->sprite(i);
+        if (x + pSprite->width() > width) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        x += pSprite->width();
+        if (pSprite->height() > rowHeight) {
+            rowHeight = pSprite->height();
+        }
+    }
+    height = y + rowHeight > 0 ? y + rowHeight : 1;
+
+    pixels.assign(width * height, 0);
+
+    std::vector<uint8> sprData;
+    x = 0;
+    y = 0;
+    rowHeight = 0;
+    for (int i = first; i < last; i++) {
+        Sprite *pSprite = pSprites->sprite(i);
+        int w = pSprite->width();
+        int h = pSprite->height();
+        if (x + w > width) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        if (w > 0 && h > 0) {
+            sprData.resize(w * h);
+            pSprite->data(&sprData[0]);
+            for (int j = 0; j < h; j++) {
+                for (int k = 0; k < w; k++) {
+                    uint8 c = sprData[j * w + k];
+                    if (c != 255) {
+                        pixels[(y + j) * width + x + k] = c;
+                    }
+                }
+            }
+        }
+        x += w;
+        if (h > rowHeight) {
+            rowHeight = h;
+        }
+    }
+}
+
+/*!
+ * Writes a paletted PNG. This method can be called by several threads
+ * at the same time as libpng structures are local.
+ * \return False if the file cannot be written.
+ */
+bool MapExporter::writePng(const std::string &path, int width, int height,
+        const std::vector<uint8> &pixels) {
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "writePng", ("Cannot write to %s", path.c_str()))
+        return false;
+    }
+
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    if (!png_ptr) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "writePng", ("Cannot create png write struct"))
+        fclose(fp);
+        return false;
+    }
+
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "writePng", ("Cannot create png info struct"))
+        png_destroy_write_struct(&png_ptr, NULL);
+        fclose(fp);
+        return false;
+    }
+
+    std::vector<png_bytep> rows(height);
+    for (int i = 0; i < height; i++) {
+        rows[i] = (png_bytep) &pixels[i * width];
+    }
+
+    png_color palette[256];
+    for (int i = 0; i < 256; i++) {
+        palette[i].red = palette_[i * 3];
+        palette[i].green = palette_[i * 3 + 1];
+        palette[i].blue = palette_[i * 3 + 2];
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        FSERR(Log::k_FLG_IO, "MapExporter", "writePng", ("Error while writing %s", path.c_str()))
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        fclose(fp);
+        return false;
+    }
+
+    png_init_io(png_ptr, fp);
+    png_set_IHDR(png_ptr, info_ptr, width, height, 8,
+            PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
+            PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_set_PLTE(png_ptr, info_ptr, palette, 256);
+    png_write_info(png_ptr, info_ptr);
+    png_write_image(png_ptr, &rows[0]);
+    png_write_end(png_ptr, info_ptr);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+
+    fclose(fp);
+    return true;
+}
@@ -0,0 +1,121 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef EDITOR_MAPEXPORTER_H_
+#define EDITOR_MAPEXPORTER_H_
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+class Map;
+class MapManager;
+class GameSpriteManager;
+
+/*!
+ * Exports whole maps and sprite sheets to PNG files.
+ * Images are drawn and compressed by several threads, each one using
+ * its own pixel buffer. The checksum of the source data is saved next
+ * to each image so that images whose source has not changed are not
+ * exported again.
+ */
+class MapExporter {
+public:
+    /*! Number of sprites in each sprite sheet.*/
+    static const int kSpritesPerSheet;
+    /*! Minimum width of a sprite sheet in pixels.*/
+    static const int kSheetWidth;
+
+    MapExporter(const std::string &outDir);
+
+    //! Loads the palette used for the images
+    bool initialize();
+    //! If true, images are exported even if their source has not changed
+    void setForce(bool force) { force_ = force; }
+
+    //! Exports the given maps
+    void exportMaps(MapManager &maps, const std::vector<uint16> &mapIds, int nbThreads);
+    //! Exports the game sprites in sheets
+    void exportSprites(GameSpriteManager &sprites, int nbThreads);
+
+    int nbWritten() const { return nbWritten_; }
+    int nbSkipped() const { return nbSkipped_; }
+    int nbFailed() const { return nbFailed_; }
+
+private:
+    /*! An image to export.*/
+    struct Item {
+        /*! Path of the PNG file.*/
+        std::string path;
+        /*! Checksum of the source data.*/
+        uint32 checksum;
+        /*! Map to draw or NULL for a sprite sheet.*/
+        Map *pMap;
+        GameSpriteManager *pSprites;
+        /*! First sprite of the sheet.*/
+        int firstSprite;
+        /*! Sprite after the last one of the sheet.*/
+        int lastSprite;
+    };
+
+    /*! Items exported by a thread.*/
+    struct ExportJob {
+        MapExporter *pExporter;
+        int first;
+        int step;
+        int nbWritten;
+        int nbFailed;
+    };
+
+    static int exportLoop(void *pData);
+    //! Exports all pending items with the given number of threads
+    void exportItems(int nbThreads);
+    //! Exports the pending maps and unlocks them
+    void exportMapBatch(MapManager &maps, std::vector<uint16> &lockedIds, int nbThreads);
+    //! Returns true if the image exists and was made from the same source
+    bool isUpToDate(const std::string &path, uint32 checksum);
+    //! Computes the checksum of the given original files and the palette
+    bool sourceChecksum(const char **files, int nbFiles, uint32 *pChecksum);
+
+    static void drawMap(Map *pMap, std::vector<uint8> &pixels, int &width, int &height);
+    static void drawSprites(GameSpriteManager *pSprites, int first, int last,
+            std::vector<uint8> &pixels, int &width, int &height);
+    bool writePng(const std::string &path, int width, int height,
+            const std::vector<uint8> &pixels);
+    static bool writeChecksum(const std::string &path, uint32 checksum);
+
+private:
+    std::string outDir_;
+    /*! Palette with 8 bits components.*/
+    uint8 palette_[768];
+    /*! Checksum of the palette file.*/
+    uint32 paletteChecksum_;
+    bool force_;
+    std::vector<Item> items_;
+    int nbWritten_;
+    int nbSkipped_;
+    int nbFailed_;
+};
+
+#endif  // EDITOR_MAPEXPORTER_H_
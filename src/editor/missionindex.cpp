@@ -0,0 +1,247 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <SDL_thread.h>
+
+#include <vector>
+
+#include "editor/missionindex.h"
+#include "missionmanager.h"
+#include "utils/file.h"
+#include "utils/log.h"
+#include "utils/portablefile.h"
+
+const int MissionIndex::kNbMissions = 50;
+
+/*! Name of the index in the cache directory.*/
+static const char *kIndexFilename = "missions.idx";
+/*! Version of the index file format.*/
+static const uint8 kIndexVersion = 1;
+
+MissionIndex::MissionIndex() {
+    entries_ = new Entry[kNbMissions];
+    loaded_ = false;
+}
+
+MissionIndex::~MissionIndex() {
+    delete[] entries_;
+}
+
+/*!
+ * Does nothing if the index is already loaded.
+ * \param nbThreads Number of threads used if the index must be built
+ */
+void MissionIndex::load(int nbThreads) {
+    if (loaded_) {
+        return;
+    }
+
+    if (readFromCache()) {
+        LOG(Log::k_FLG_IO, "MissionIndex", "load", ("Mission index read from cache"))
+        loaded_ = true;
+    } else {
+        rebuild(nbThreads);
+    }
+}
+
+/*!
+ * Missions are distributed between the given number of threads, the
+ * calling thread indexing the first ones.
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void MissionIndex::rebuild(int nbThreads) {
+    if (nbThreads > kNbMissions) {
+        nbThreads = kNbMissions;
+    }
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+
+    std::vector<BuildJob> jobs(nbThreads);
+    std::vector<SDL_Thread *> threads(nbThreads, (SDL_Thread *) NULL);
+    for (int i = 0; i < nbThreads; i++) {
+        jobs[i].pIndex = this;
+        jobs[i].firstId = i + 1;
+        jobs[i].step = nbThreads;
+    }
+
+    // first mission is read before starting threads so that tables
+    // shared by the file decoders are initialized by this thread
+    indexMission(1, entries_[0]);
+    jobs[0].firstId += nbThreads;
+
+    for (int i = 1; i < nbThreads; i++) {
+        threads[i] = SDL_CreateThread(buildLoop, &jobs[i]);
+        if (threads[i] == NULL) {
+            LOG(Log::k_FLG_IO, "MissionIndex", "rebuild",
+                ("Cannot create thread, indexing missions inline"));
+            buildLoop(&jobs[i]);
+        }
+    }
+
+    buildLoop(&jobs[0]);
+
+    for (int i = 1; i < nbThreads; i++) {
+        if (threads[i]) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+
+    LOG(Log::k_FLG_IO, "MissionIndex", "rebuild", ("Mission index built with %d threads", nbThreads))
+    loaded_ = true;
+    saveToCache();
+}
+
+int MissionIndex::buildLoop(void *pData) {
+    BuildJob *pJob = static_cast<BuildJob *>(pData);
+    for (int id = pJob->firstId; id <= kNbMissions; id += pJob->step) {
+        indexMission(id, pJob->pIndex->entries_[id - 1]);
+    }
+    return 0;
+}
+
+/*!
+ * Ped, vehicle and weapon are selected like MissionManager does when
+ * it creates the mission.
+ * \param missionId Id of the mission
+ * \param entry Entry to fill
+ */
+void MissionIndex::indexMission(int missionId, Entry &entry) {
+    entry.valid = false;
+    entry.mapId = 0;
+    entry.pedTypes = 0;
+    entry.vehicleTypes = 0;
+    entry.weaponTypes = 0;
+    entry.objectiveTypes = 0;
+
+    // level data is too large for the stack of a thread
+    LevelData::LevelDataAll *pLevelData = new LevelData::LevelDataAll;
+    MissionManager missionMgr;
+    if (!missionMgr.load_level_data(missionId, *pLevelData)) {
+        delete pLevelData;
+        return;
+    }
+
+    entry.valid = true;
+    entry.mapId = READ_LE_UINT16(pLevelData->mapinfos.map);
+
+    for (int i = 0; i < 256; i++) {
+        const LevelData::People &ped = pLevelData->people[i];
+        if (ped.type == 0x0 || ped.location == LevelData::kPeopleLocNotVisible
+            || ped.location == LevelData::kPeopleLocAboveWalkSurf
+            || (i >= 4 && i < 8)) {
+            continue;
+        }
+        entry.pedTypes |= ped.type_ped;
+    }
+
+    for (int i = 0; i < 64; i++) {
+        const LevelData::Cars &car = pLevelData->cars[i];
+        if (car.type != 0x0 && car.sub_type < 64) {
+            entry.vehicleTypes |= (uint64) 1 << car.sub_type;
+        }
+    }
+
+    for (int i = 0; i < 512; i++) {
+        const LevelData::Weapons &weapon = pLevelData->weapons[i];
+        if (weapon.desc != 0 && weapon.sub_type < 32) {
+            entry.weaponTypes |= 1 << weapon.sub_type;
+        }
+    }
+
+    for (int i = 0; i < 6; i++) {
+        uint16 type = READ_LE_UINT16(pLevelData->objectives[i].type);
+        if (type != 0 && type < 32) {
+            entry.objectiveTypes |= 1 << type;
+        }
+    }
+
+    delete pLevelData;
+}
+
+/*!
+ * \return false if there is no index in the cache or if it is not valid.
+ */
+bool MissionIndex::readFromCache() {
+    std::string path;
+    if (!File::getCachePath(path)) {
+        return false;
+    }
+    path.append(kIndexFilename);
+
+    PortableFile infile;
+    infile.open_to_read(path.c_str());
+    if (!infile) {
+        return false;
+    }
+
+    if (infile.read_string(4, false) != "FSMI" || infile.read8() != kIndexVersion
+        || infile.read8() != kNbMissions) {
+        FSERR(Log::k_FLG_IO, "MissionIndex", "readFromCache", ("Mission index %s is not valid\n", path.c_str()))
+        return false;
+    }
+
+    for (int i = 0; i < kNbMissions; i++) {
+        Entry &entry = entries_[i];
+        entry.valid = infile.read8b();
+        entry.mapId = infile.read16();
+        entry.pedTypes = infile.read32();
+        entry.vehicleTypes = infile.read64();
+        entry.weaponTypes = infile.read32();
+        entry.objectiveTypes = infile.read32();
+    }
+
+    return infile;
+}
+
+void MissionIndex::saveToCache() {
+    std::string path;
+    if (!File::getCachePath(path)) {
+        return;
+    }
+    path.append(kIndexFilename);
+
+    PortableFile outfile;
+    outfile.open_to_overwrite(path.c_str());
+    if (!outfile) {
+        FSERR(Log::k_FLG_IO, "MissionIndex", "saveToCache", ("Cannot write file %s\n", path.c_str()))
+        return;
+    }
+
+    outfile.write_string("FSMI", 4);
+    outfile.write8(kIndexVersion);
+    outfile.write8(kNbMissions);
+    for (int i = 0; i < kNbMissions; i++) {
+        const Entry &entry = entries_[i];
+        outfile.write8b(entry.valid);
+        outfile.write16(entry.mapId);
+        outfile.write32(entry.pedTypes);
+        outfile.write64(entry.vehicleTypes);
+        outfile.write32(entry.weaponTypes);
+        outfile.write32(entry.objectiveTypes);
+    }
+
+    if (!outfile.close()) {
+        FSERR(Log::k_FLG_IO, "MissionIndex", "saveToCache", ("Cannot write file %s\n", path.c_str()))
+    }
+}
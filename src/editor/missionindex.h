@@ -0,0 +1,96 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef EDITOR_MISSIONINDEX_H_
+#define EDITOR_MISSIONINDEX_H_
+
+#include "common.h"
+#include "ped.h"
+
+/*!
+ * Summary of the content of all missions, used to search missions without
+ * loading them. The index is built from the level data only (no map nor
+ * surfaces) and is saved in the cache directory so it's built only once.
+ */
+class MissionIndex {
+public:
+    /*! Number of missions in the game.*/
+    static const int kNbMissions;
+
+    /*! What a mission contains. Each type is a bit in a mask.*/
+    struct Entry {
+        /*! False if the mission file could not be read.*/
+        bool valid;
+        /*! Id of the mission map.*/
+        uint16 mapId;
+        /*! Mask of PedInstance::PedType values.*/
+        uint32 pedTypes;
+        /*! Bit n is set if there is a vehicle of type n.*/
+        uint64 vehicleTypes;
+        /*! Bit n is set if there is a weapon of subtype n.*/
+        uint32 weaponTypes;
+        /*! Bit n is set if there is an objective of type n.*/
+        uint32 objectiveTypes;
+
+        bool hasPedType(PedInstance::PedType type) const {
+            return (pedTypes & type) != 0;
+        }
+
+        bool hasVehicleType(uint8 type) const {
+            return type < 64 && (vehicleTypes & ((uint64) 1 << type)) != 0;
+        }
+    };
+
+    MissionIndex();
+    ~MissionIndex();
+
+    //! Reads the index from the cache or builds it if needed
+    void load(int nbThreads);
+    //! Builds the index from the mission files and saves it
+    void rebuild(int nbThreads);
+
+    //! Returns the entry for the given mission (from 1 to kNbMissions)
+    const Entry &entry(int missionId) const { return entries_[missionId - 1]; }
+
+private:
+    /*! Missions indexed by a thread.*/
+    struct BuildJob {
+        MissionIndex *pIndex;
+        int firstId;
+        int step;
+    };
+
+    static int buildLoop(void *pData);
+    //! Fills the entry with the content of the mission file
+    static void indexMission(int missionId, Entry &entry);
+
+    bool readFromCache();
+    void saveToCache();
+
+private:
+    Entry *entries_;
+    /*! True when entries are filled.*/
+    bool loaded_;
+};
+
+#endif  // EDITOR_MISSIONINDEX_H_
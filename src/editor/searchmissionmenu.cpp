@@ -30,8 +30,7 @@
 #include "editor/editormenuid.h"
 #include "gfx/screen.h"
 #include "system.h"
-#include "missionmanager.h"
-#include "mission.h"
+#include "appcontext.h"
 #include "model/vehicle.h"
 
 std::string PedTypeAdapter::getName() {
@@ -71,6 +70,8 @@ SearchMissionMenu::SearchMissionMenu(MenuManager * m):
 
     // Accept button
     addOption(17, 347, 128, 25, "BACK", FontManager::SIZE_2, fs_edit_menus::kMenuIdMain);
+    // Rebuild index button
+    rebuildButId_ = addOption(256, 347, 128, 25, "REINDEX", FontManager::SIZE_2);
     // Main menu button
     searchButId_ = addOption(500, 347,  128, 25, "SEARCH", FontManager::SIZE_2);
 }
@@ -115,37 +116,25 @@ void SearchMissionMenu::handleShow()
     g_System.showCursor();
 
     initSearchCriterias();
+    // built only the first time the editor is launched
+    index_.load(g_Ctx.getSurfacesThreads());
 }
 
 void SearchMissionMenu::handleLeave() {
     g_System.hideCursor();
 }
 
-bool SearchMissionMenu::matchMissionWithPedType(Mission *pMission) {
+bool SearchMissionMenu::matchMissionWithPedType(const MissionIndex::Entry &entry) {
     if (searchOnPedType_) {
-        for (size_t pedId = 0; pedId < pMission->numPeds(); pedId++) {
-            PedInstance *pPed = pMission->ped(pedId);
-
-            if (pPed->type() == pedTypeCriteria_) {
-                return true;
-            }
-        }
-        return false;
+        return entry.hasPedType(pedTypeCriteria_);
     }
 
     return true;
 }
 
-bool SearchMissionMenu::matchMissionWithVehicleType(Mission *pMission) {
+bool SearchMissionMenu::matchMissionWithVehicleType(const MissionIndex::Entry &entry) {
     if (searchOnVehicleType_) {
-        for (size_t vId = 0; vId < pMission->numVehicles(); vId++) {
-            Vehicle *pVehicle = pMission->vehicle(vId);
-
-            if (pVehicle->getType() == vehicleTypeCriteria_) {
-                return true;
-            }
-        }
-        return false;
+        return entry.hasVehicleType(vehicleTypeCriteria_);
     }
 
     return true;
@@ -153,30 +142,22 @@ bool SearchMissionMenu::matchMissionWithVehicleType(Mission *pMission) {
 
 void SearchMissionMenu::handleAction(const int actionId, void *ctx, const int modKeys) {
     if (actionId == searchButId_) {
-        MissionManager missionMgr;
-
         // first clear result list
         g_App.getMissionResultList().clear();
 
-        for (int misId = 1; misId <= 50; misId++) {
-            Mission *pMission = missionMgr.loadMission(misId);
-
-            if (pMission) {
-                bool keepMission = matchMissionWithPedType(pMission);
-
-                if (keepMission) {
-                    keepMission = matchMissionWithVehicleType(pMission);
-                }
-
-                if (keepMission) {
-                    g_App.getMissionResultList().push_back(misId);
-                }
+        for (int misId = 1; misId <= MissionIndex::kNbMissions; misId++) {
+            const MissionIndex::Entry &entry = index_.entry(misId);
 
-                delete pMission;
+            if (entry.valid && matchMissionWithPedType(entry)
+                    && matchMissionWithVehicleType(entry)) {
+                g_App.getMissionResultList().push_back(misId);
             }
         }
 
         menu_manager_->gotoMenu(fs_edit_menus::kMenuIdListMis);
+    } else if (actionId == rebuildButId_) {
+        // after original data has changed
+        index_.rebuild(g_Ctx.getSurfacesThreads());
     } else if (actionId == pPedTypeListBox_->getId()) {
         std::pair<int, void *> * pPair = static_cast<std::pair<int, void *> *> (ctx);
         PedTypeAdapter *pType = static_cast<PedTypeAdapter *> (pPair->second);
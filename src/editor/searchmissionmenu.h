@@ -28,8 +28,7 @@
 
 #include "utils/seqmodel.h"
 #include "ped.h"
-
-class Mission;
+#include "editor/missionindex.h"
 
 class PedTypeAdapter {
 public:
@@ -74,11 +73,12 @@ protected:
     void initSearchCriterias();
     void initVehicleTypeListAndWidget();
 
-    bool matchMissionWithPedType(Mission *pMission);
-    bool matchMissionWithVehicleType(Mission *pMission);
+    bool matchMissionWithPedType(const MissionIndex::Entry &entry);
+    bool matchMissionWithVehicleType(const MissionIndex::Entry &entry);
 
 protected:
     int searchButId_;
+    int rebuildButId_;
     ListBox *pPedTypeListBox_;
     ListBox *pVehicleTypeListBox_;
 
@@ -90,6 +90,9 @@ protected:
 
     bool searchOnVehicleType_;
     uint8 vehicleTypeCriteria_;
+
+    /*! Content of the missions used to answer searches.*/
+    MissionIndex index_;
 };
 
 #endif // SEARCHMISSIONMENU_H_
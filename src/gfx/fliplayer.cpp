@@ -24,6 +24,8 @@
 
 #include <cstdio>
 
+#include <SDL_thread.h>
+
 #include "fliplayer.h"
 #include "screen.h"
 #include "utils/log.h"
@@ -193,6 +195,8 @@ const sample_timings g_rg_sample_offsets_and_timings[] = {
 
 #endif
 
+const int FliPlayer::kFrameRingSize = 4;
+
 FliPlayer::~FliPlayer() {
     if (offscreen_) {
         delete[] offscreen_;
@@ -225,6 +229,7 @@ void FliPlayer::loadFliData(uint8 *data) {
     if (offscreen_)
         delete[] offscreen_;
     offscreen_ = new uint8[fli_info_.width * fli_info_.height];
+    dirtyRows_.assign(fli_info_.height, 0);
 
     memset(palette_, 0, sizeof(palette_));
 }
@@ -273,6 +278,8 @@ FrameTypeChunkHeader FliPlayer::readFrameTypeChunkHeader(ChunkHeader chunkHead,
 
 void FliPlayer::decodeByteRun(uint8 *data) {
     uint8 *ptr = (uint8 *) offscreen_;
+    // the whole frame is replaced
+    memset(&dirtyRows_[0], 1, dirtyRows_.size());
     while ((ptr - offscreen_) < (fli_info_.width * fli_info_.height)) {
         uint8 chunks = *data++;
         while (chunks--) {
@@ -320,6 +327,7 @@ void FliPlayer::decodeDeltaFLC(uint8 *data) {
             case OP_LASTPIXEL:
                 *(uint8 *) (offscreen_ + (currentLine * fli_info_.width) +
                             (fli_info_.width - 1)) = (opcode & 0xFF);
+                dirtyRows_[currentLine] = 1;
                 break;
             case OP_LINESKIPCOUNT:
                 currentLine += -(int16) opcode;
@@ -328,6 +336,9 @@ void FliPlayer::decodeDeltaFLC(uint8 *data) {
         } while (((opcode >> 14) & 3) != OP_PACKETCOUNT);
 
         uint16 column = 0;
+        if (packetCount > 0) {
+            dirtyRows_[currentLine] = 1;
+        }
 
         //Now interpret the RLE data
         while (packetCount--) {
@@ -364,14 +375,34 @@ void FliPlayer::decodeDeltaFLC(uint8 *data) {
 
 #define FRAME_TYPE  0xF1FA
 
+/*!
+ * Decodes the next frame and applies its palette.
+ * \return False if the next frame cannot be decoded.
+ */
 bool FliPlayer::decodeFrame() {
+    bool res = decodeChunks();
+    if (paletteChanged_) {
+        g_System.setPalette8b3(palette_);
+    }
+    return res;
+}
+
+/*!
+ * Decodes all the chunks of the next frame in the offscreen buffer.
+ * The palette is not applied so this can be called from another thread.
+ * Changed rows are flagged in dirtyRows_.
+ * \return False if the next frame cannot be decoded.
+ */
+bool FliPlayer::decodeChunks() {
     FrameTypeChunkHeader frameHeader;
     ChunkHeader cHeader = readChunkHeader(fli_data_);
+    paletteChanged_ = false;
+    memset(&dirtyRows_[0], 0, dirtyRows_.size());
     do {
         switch (cHeader.type) {
         case 4:
             setPalette(fli_data_ + 6);
-            g_System.setPalette8b3(palette_);
+            paletteChanged_ = true;
             break;
         case 7:
             decodeDeltaFLC(fli_data_ + 6);
@@ -433,26 +464,146 @@ void FliPlayer::copyCurrentFrameToScreen() {
                      0, false);
 }
 
+/*!
+ * Decodes the next frame and copies in the slot the rows that changed.
+ * \param slot Index in the ring
+ * \return False if there was no frame to decode.
+ */
+bool FliPlayer::decodeToRing(int slot) {
+    DecodedFrame &frame = ring_[slot];
+
+    frame.valid = hasFrames() && decodeChunks();
+    if (!frame.valid) {
+        return false;
+    }
+
+    frame.dirtyRows = dirtyRows_;
+    for (int row = 0; row < fli_info_.height; row++) {
+        if (dirtyRows_[row]) {
+            memcpy(&frame.pixels[row * fli_info_.width],
+                offscreen_ + row * fli_info_.width, fli_info_.width);
+        }
+    }
+
+    frame.paletteChanged = paletteChanged_;
+    if (paletteChanged_) {
+        memcpy(frame.palette, palette_, sizeof(palette_));
+    }
+
+    return true;
+}
+
+/*!
+ * The screen still holds the previous frame so only the rows that
+ * changed are scaled.
+ */
+void FliPlayer::presentFrame(const DecodedFrame &frame) {
+    if (frame.paletteChanged) {
+        g_System.setPalette8b3(frame.palette);
+    }
+
+    for (int row = 0; row < fli_info_.height; row++) {
+        if (frame.dirtyRows[row]) {
+            g_Screen.scale2x(0, row * 2, fli_info_.width, 1,
+                &frame.pixels[row * fli_info_.width], 0, false);
+        }
+    }
+
+    g_System.updateScreen();
+}
+
+int FliPlayer::decoderLoop(void *pData) {
+    FliPlayer *pPlayer = static_cast<FliPlayer *>(pData);
+
+    for (int slot = 0; ; slot = (slot + 1) % kFrameRingSize) {
+        SDL_SemWait(pPlayer->pFreeSem_);
+        if (pPlayer->stopDecoder_) {
+            break;
+        }
+        bool valid = pPlayer->decodeToRing(slot);
+        SDL_SemPost(pPlayer->pReadySem_);
+        if (!valid) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * Frames are decoded by another thread a few frames ahead. Each frame
+ * is displayed at a fixed time from the start of the animation, so
+ * decoding time does not slow down the animation.
+ * \param intro True for the intro, which is played slower.
+ * \param pIntroFont Not used.
+ * \return False if no animation was loaded.
+ */
 bool FliPlayer::play(bool intro, Font *pIntroFont) {
     if (!fli_data_)
         return false;
 
     g_Screen.clear(0);
-    int cur_frame = 0;
-    while (hasFrames()) {
+
+    const int frameDelay = 1000 / (intro ? 10 : 15);      //fps
+    ring_.resize(kFrameRingSize);
+    for (int i = 0; i < kFrameRingSize; i++) {
+        ring_[i].pixels.resize(fli_info_.width * fli_info_.height);
+        ring_[i].dirtyRows.resize(fli_info_.height);
+    }
+
+    stopDecoder_ = false;
+    pFreeSem_ = SDL_CreateSemaphore(kFrameRingSize);
+    pReadySem_ = SDL_CreateSemaphore(0);
+    SDL_Thread *pThread = SDL_CreateThread(decoderLoop, this);
+    if (pThread == NULL) {
+        FSERR(Log::k_FLG_GFX, "FliPlayer", "play", ("Cannot create decoder thread\n"));
+    }
+
+    int nbFrames = 0;
+    int nbLate = 0;
+    int deadline = g_System.getTicks();
+    for (int slot = 0; ; slot = (slot + 1) % kFrameRingSize) {
         // Consumes events now so they won't be piled up after the animation
         pManager_->handleEvents();
 
-        if (!decodeFrame())
+        if (pThread) {
+            SDL_SemWait(pReadySem_);
+        } else {
+            decodeToRing(slot);
+        }
+
+        if (!ring_[slot].valid)
             break;
-        copyCurrentFrameToScreen();
+        presentFrame(ring_[slot]);
+        nbFrames++;
 
-        cur_frame++;
+        if (pThread) {
+            SDL_SemPost(pFreeSem_);
+        }
 
-        g_System.updateScreen();
-        g_System.delay(1000 / (intro ? 10 : 15));      //fps
+        deadline += frameDelay;
+        int now = g_System.getTicks();
+        if (now < deadline) {
+            g_System.delay(deadline - now);
+        } else if (now - deadline > frameDelay) {
+            // too late to catch up : restart the clock from now
+            nbLate++;
+            deadline = now;
+        }
     }
 
+    if (pThread) {
+        stopDecoder_ = true;
+        SDL_SemPost(pFreeSem_);
+        SDL_WaitThread(pThread, NULL);
+    }
+    SDL_DestroySemaphore(pFreeSem_);
+    SDL_DestroySemaphore(pReadySem_);
+    pFreeSem_ = NULL;
+    pReadySem_ = NULL;
+    ring_.clear();
+
+    LOG(Log::k_FLG_GFX, "FliPlayer", "play", ("%d frames played, %d late", nbFrames, nbLate));
+
     //clear the backscreen
     //bzero(Screen::pixels(), GAME_SCREEN_WIDTH * GAME_SCREEN_HEIGHT);
 
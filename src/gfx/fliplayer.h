@@ -25,9 +25,13 @@
 #ifndef FLIPLAYER_H
 #define FLIPLAYER_H
 
+#include <vector>
+
 #include "common.h"
 #include "system.h"
 
+struct SDL_semaphore;
+
 typedef struct FliHeader {
     uint32 size;
     uint16 type;                //0xAF12
@@ -58,7 +62,9 @@ class MenuManager;
  */
 class FliPlayer {
 public:
-    FliPlayer(MenuManager *pManager) : fli_data_(0), offscreen_(0) {pManager_ = pManager;}
+    FliPlayer(MenuManager *pManager) : fli_data_(0), offscreen_(0),
+        paletteChanged_(false), stopDecoder_(false), pFreeSem_(NULL),
+        pReadySem_(NULL) {pManager_ = pManager;}
     virtual ~FliPlayer();
 
     //! Play an entire animation without interruption
@@ -77,6 +83,32 @@ public:
     const uint8 *offscreen() const { return offscreen_; }
 
 protected:
+    /*! Number of decoded frames that can wait to be displayed.*/
+    static const int kFrameRingSize;
+
+    /*!
+     * A decoded frame waiting to be displayed. Only the rows that changed
+     * since the previous frame are copied in it.
+     */
+    struct DecodedFrame {
+        std::vector<uint8> pixels;
+        /*! 1 for each row that has changed.*/
+        std::vector<uint8> dirtyRows;
+        uint8 palette[256 * 3];
+        bool paletteChanged;
+        /*! False if there was no more frame to decode.*/
+        bool valid;
+    };
+
+    //! Decodes the chunks of the next frame in the offscreen buffer
+    bool decodeChunks();
+    //! Decodes the next frame and stores it in the given slot of the ring
+    bool decodeToRing(int slot);
+    //! Displays the changed rows of a decoded frame
+    void presentFrame(const DecodedFrame &frame);
+    //! Decodes frames ahead of the display while playing
+    static int decoderLoop(void *pData);
+
     bool isValidChunk(uint16 type);
     ChunkHeader readChunkHeader(uint8 *mem);
     FrameTypeChunkHeader readFrameTypeChunkHeader(ChunkHeader chunkHead,
@@ -90,6 +122,18 @@ protected:
     uint8 palette_[256 * 3];
     FliHeader fli_info_;
     MenuManager *pManager_;
+    /*! True if the last decoded frame has changed the palette.*/
+    bool paletteChanged_;
+    /*! 1 for each row that has been changed by the last decoded frame.*/
+    std::vector<uint8> dirtyRows_;
+    /*! Frames decoded by the decoder thread.*/
+    std::vector<DecodedFrame> ring_;
+    /*! Set to tell the decoder thread to stop.*/
+    volatile bool stopDecoder_;
+    /*! Counts the slots of the ring that can be decoded into.*/
+    SDL_semaphore *pFreeSem_;
+    /*! Counts the decoded frames waiting to be displayed.*/
+    SDL_semaphore *pReadySem_;
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "cp437.h"
 
 #include <stdlib.h>
+#include <algorithm>
 
 FontRange::FontRange()
 {
@@ -179,16 +180,65 @@ void Font::setSpriteManager(SpriteManager *sprites, int offset, char base, const
     sprites_ = sprites;
     offset_ = offset - base;
     range_ = range;
+    runCache_.clear();
 }
 
 void Font::setSpriteManager(SpriteManager *sprites, int offset, char base, const std::string& valid_chars) {
     setSpriteManager(sprites, offset, base, FontRange(valid_chars));
 }
 
+TextRun *TextRunCache::find(const TextRunKey &key) {
+    std::map<TextRunKey, Entry>::iterator it = runs_.find(key);
+    if (it == runs_.end()) {
+        return NULL;
+    }
+    // move the key to the front of its usage list
+    KeyList &lru = usage(key);
+    lru.splice(lru.begin(), lru, it->second.lruPos);
+    return it->second.pRun;
+}
+
+TextRun *TextRunCache::add(const TextRunKey &key) {
+    KeyList &lru = usage(key);
+    size_t maxSize = (key.flags & TextRunKey::kRunWidthOnly) ? kMaxWidths : kMaxRuns;
+    if (lru.size() >= maxSize) {
+        std::map<TextRunKey, Entry>::iterator oldest = runs_.find(lru.back());
+        delete oldest->second.pRun;
+        runs_.erase(oldest);
+        lru.pop_back();
+    }
+
+    lru.push_front(key);
+    Entry &entry = runs_[key];
+    entry.pRun = new TextRun();
+    entry.lruPos = lru.begin();
+    return entry.pRun;
+}
+
+void TextRunCache::clear() {
+    for (std::map<TextRunKey, Entry>::iterator it = runs_.begin();
+            it != runs_.end(); it++) {
+        delete it->second.pRun;
+    }
+    runs_.clear();
+    runsLru_.clear();
+    widthsLru_.clear();
+}
+
 void Font::drawText(int x, int y, const char *text, bool dos, bool x2) {
-    int sc = x2 ? 2 : 1;
-    int ox = x;
-    const unsigned char *c = (const unsigned char *)text;
+    TextRunKey key;
+    key.text = text;
+    key.flags = (dos ? TextRunKey::kRunDos : 0) | (x2 ? TextRunKey::kRunX2 : 0);
+    key.color = -1;
+    drawRun(x, y, key);
+}
+
+void Font::layoutText(const TextRunKey &key, std::vector<PlacedGlyph> &glyphs) {
+    bool dos = (key.flags & TextRunKey::kRunDos) != 0;
+    int sc = (key.flags & TextRunKey::kRunX2) ? 2 : 1;
+    int x = 0;
+    int y = 0;
+    const unsigned char *c = (const unsigned char *)key.text.c_str();
     for (unsigned char cc = decode(c, dos); cc; cc = decode(c, dos)) {
         if (cc == 0xff) {
             // invalid utf8 code, skip it.
@@ -199,7 +249,7 @@ void Font::drawText(int x, int y, const char *text, bool dos, bool x2) {
             continue;
         }
         if (cc == '\n') {
-            x = ox;
+            x = 0;
             y += textHeight() - sc;
             continue;
         }
@@ -213,14 +263,93 @@ void Font::drawText(int x, int y, const char *text, bool dos, bool x2) {
             else if (cc == '-')
                 y_offset = 2 * sc;
 
-            s->draw(x, y + y_offset, 0, false, x2);
-            
+            PlacedGlyph glyph = { s, x, y + y_offset };
+            glyphs.push_back(glyph);
+
             x += s->width() * sc - sc;
         }
     }
 }
 
+/*!
+ * Glyphs are drawn in the buffer in the same order as they were drawn
+ * on screen, so overlapping pixels give the same result.
+ * \param key The text and drawing options
+ * \param pRun The run to fill
+ */
+void Font::composeRun(const TextRunKey &key, TextRun *pRun) {
+    std::vector<PlacedGlyph> glyphs;
+    layoutText(key, glyphs);
+
+    int sc = (key.flags & TextRunKey::kRunX2) ? 2 : 1;
+    pRun->x = pRun->y = pRun->width = pRun->height = 0;
+    if (glyphs.empty()) {
+        return;
+    }
+
+    int minX = glyphs[0].x, minY = glyphs[0].y, maxX = minX, maxY = minY;
+    for (size_t n = 0; n < glyphs.size(); n++) {
+        const PlacedGlyph &g = glyphs[n];
+        minX = std::min(minX, g.x);
+        minY = std::min(minY, g.y);
+        maxX = std::max(maxX, g.x + g.pSprite->width() * sc);
+        maxY = std::max(maxY, g.y + g.pSprite->height() * sc);
+    }
+    pRun->x = minX;
+    pRun->y = minY;
+    pRun->width = maxX - minX;
+    pRun->height = maxY - minY;
+    pRun->pixels.assign(pRun->width * pRun->height, 255);
+
+    std::vector<uint8> data;
+    for (size_t n = 0; n < glyphs.size(); n++) {
+        const PlacedGlyph &g = glyphs[n];
+        int sw = g.pSprite->width();
+        int sh = g.pSprite->height();
+        data.resize(sw * sh);
+        g.pSprite->data(&data[0]);
+
+        uint8 *pBase = &pRun->pixels[0] + (g.y - minY) * pRun->width + g.x - minX;
+        for (int j = 0; j < sh; j++) {
+            for (int i = 0; i < sw; i++) {
+                uint8 c = glyphColor(data[j * sw + i], key.color);
+                if (c == 255) {
+                    continue;
+                }
+                for (int dy = 0; dy < sc; dy++) {
+                    uint8 *pDst = pBase + (j * sc + dy) * pRun->width + i * sc;
+                    for (int dx = 0; dx < sc; dx++) {
+                        pDst[dx] = c;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Font::drawRun(int x, int y, const TextRunKey &key) {
+    TextRun *pRun = runCache_.find(key);
+    if (pRun == NULL) {
+        pRun = runCache_.add(key);
+        composeRun(key, pRun);
+    }
+
+    if (pRun->width > 0) {
+        g_Screen.blit(x + pRun->x, y + pRun->y, pRun->width, pRun->height, &pRun->pixels[0]);
+    }
+}
+
 int Font::textWidth(const char *text, bool dos, bool x2) {
+    TextRunKey key;
+    key.text = text;
+    key.flags = TextRunKey::kRunWidthOnly |
+        (dos ? TextRunKey::kRunDos : 0) | (x2 ? TextRunKey::kRunX2 : 0);
+    key.color = -1;
+    TextRun *pRun = runCache_.find(key);
+    if (pRun != NULL) {
+        return pRun->width;
+    }
+
     int sc = x2 ? 2 : 1;
     int x = 0;
     const unsigned char *c = (const unsigned char *)text;
@@ -238,6 +367,10 @@ int Font::textWidth(const char *text, bool dos, bool x2) {
             x += s->width() * sc - sc;
         }
     }
+
+    pRun = runCache_.add(key);
+    pRun->x = pRun->y = pRun->height = 0;
+    pRun->width = x;
     return x;
 }
 
@@ -274,12 +407,25 @@ void MenuFont::setSpriteManager(SpriteManager *sprites, int darkOffset, int ligh
     offset_ = darkOffset - base;
     lightOffset_ = lightOffset - base;
     range_ = FontRange(valid_chars);
+    runCache_.clear();
 }
 
 void MenuFont::drawText(int x, int y, bool dos, const char *text, bool highlighted, bool x2) {
-    int sc = x2 ? 2 : 1;
-    int ox = x;
-    const unsigned char *c = (const unsigned char *)text;
+    TextRunKey key;
+    key.text = text;
+    key.flags = (dos ? TextRunKey::kRunDos : 0) | (x2 ? TextRunKey::kRunX2 : 0) |
+        (highlighted ? TextRunKey::kRunHighlighted : 0);
+    key.color = -1;
+    drawRun(x, y, key);
+}
+
+void MenuFont::layoutText(const TextRunKey &key, std::vector<PlacedGlyph> &glyphs) {
+    bool dos = (key.flags & TextRunKey::kRunDos) != 0;
+    bool highlighted = (key.flags & TextRunKey::kRunHighlighted) != 0;
+    int sc = (key.flags & TextRunKey::kRunX2) ? 2 : 1;
+    int x = 0;
+    int y = 0;
+    const unsigned char *c = (const unsigned char *)key.text.c_str();
     Sprite *pDef = getSprite('A', false);
     for (unsigned char cc = decode(c, dos); cc; cc = decode(c, dos)) {
         if (cc == 0xff) {
@@ -291,7 +437,7 @@ void MenuFont::drawText(int x, int y, bool dos, const char *text, bool highlight
             continue;
         }
         if (cc == '\n') {
-            x = ox;
+            x = 0;
             y += textHeight() - sc;
             continue;
         }
@@ -306,8 +452,9 @@ void MenuFont::drawText(int x, int y, bool dos, const char *text, bool highlight
                 y_offset = (pDef->height() *sc)/2 - (getSprite('/', false)->height() * sc) / 2;
             }
 
-            s->draw(x, y + y_offset, 0, false, x2);
-            
+            PlacedGlyph glyph = { s, x, y + y_offset };
+            glyphs.push_back(glyph);
+
             x += s->width() * sc - sc;
         }
     }
@@ -323,10 +470,18 @@ GameFont::GameFont() :Font() {}
  * \param toColor The color used to draw the text.
  */
 void GameFont::drawText(int x, int y, const char *text, uint8 toColor) {
+    TextRunKey key;
+    key.text = text;
+    key.flags = 0;
+    key.color = toColor;
+    drawRun(x, y, key);
+}
+
+void GameFont::layoutText(const TextRunKey &key, std::vector<PlacedGlyph> &glyphs) {
     int sc = 1;
-    int ox = x;
-    uint8 fromColor = 252;
-    const unsigned char *c = (const unsigned char *)text;
+    int x = 0;
+    int y = 0;
+    const unsigned char *c = (const unsigned char *)key.text.c_str();
     Sprite *pDef = getSprite('A');
     for (unsigned char cc = decode(c, false); cc; cc = decode(c, false)) {
         if (cc == 0xff) {
@@ -340,7 +495,7 @@ void GameFont::drawText(int x, int y, const char *text, uint8 toColor) {
         }
         if (cc == '\n') {
             // If char is a space, only move the drawing origin to the next line
-            x = ox;
+            x = 0;
             y += textHeight() - sc;
             continue;
         }
@@ -357,23 +512,23 @@ void GameFont::drawText(int x, int y, const char *text, uint8 toColor) {
                 y_offset = (pDef->height() *sc)/2 - (getSprite('/')->height() * sc) / 2;
             }
 
-            uint8 *data = new uint8[s->width() * s->height()];
-            s->data(data);
-
-            // Change original color to the specified color
-            for (int i = 0; i < s->width() * s->height(); i++)
-                data[i] = (data[i] == fromColor ? toColor : 255);
-
-            // draw modified sprite
-            g_Screen.blit(x, y + y_offset, s->width(), s->height(), data);
-
-            delete[] data;
+            PlacedGlyph glyph = { s, x, y + y_offset };
+            glyphs.push_back(glyph);
 
             x += s->width() * sc - sc;
         }
     }
 }
 
+/*!
+ * Change original color to the specified color, other pixels
+ * are transparent.
+ */
+uint8 GameFont::glyphColor(uint8 color, int toColor) {
+    uint8 fromColor = 252;
+    return color == fromColor ? toColor : 255;
+}
+
 HChar::HChar():width_(0), height_(0), bits_(0) {
 }
 
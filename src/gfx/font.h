@@ -28,7 +28,10 @@
 
 #include "common.h"
 #include "spritemanager.h"
+#include <list>
 #include <map>
+#include <string>
+#include <vector>
 
 /*!
  * Font range description for 8-bit character sets.
@@ -46,6 +49,95 @@ private:
     unsigned int char_present_[8]; // 256 bits
 };
 
+/*!
+ * Identifies a text drawn with a font : the same text with the same
+ * options gives the same pixels.
+ */
+struct TextRunKey {
+    //! Bits used in flags
+    enum EFlags {
+        kRunDos = 0x01,
+        kRunX2 = 0x02,
+        kRunHighlighted = 0x04,
+        //! Only the width of the text is stored
+        kRunWidthOnly = 0x08
+    };
+
+    std::string text;
+    uint8 flags;
+    //! Color for fonts that recolor glyphs, -1 otherwise
+    int color;
+
+    bool operator<(const TextRunKey &other) const {
+        if (flags != other.flags) {
+            return flags < other.flags;
+        }
+        if (color != other.color) {
+            return color < other.color;
+        }
+        return text < other.text;
+    }
+};
+
+/*!
+ * A text whose glyphs have been composed in one buffer, so it can
+ * be drawn with a single blit.
+ */
+struct TextRun {
+    //! Position of the buffer relatively to the drawing point
+    int x;
+    //! Position of the buffer relatively to the drawing point
+    int y;
+    int width;
+    int height;
+    //! width * height pixels, 255 is transparent
+    std::vector<uint8> pixels;
+};
+
+/*!
+ * Keeps the last texts drawn with a font. Labels, list rows and hints are
+ * drawn with the same text at each frame so they are only composed once.
+ * When the cache is full, the least recently used text is removed. Texts
+ * whose width only is kept have their own limit so they don't push
+ * composed texts out.
+ */
+class TextRunCache {
+public:
+    //! Maximum number of composed texts kept
+    static const size_t kMaxRuns = 128;
+    //! Maximum number of text widths kept
+    static const size_t kMaxWidths = 256;
+
+    ~TextRunCache() { clear(); }
+
+    //! Returns the run for the key or NULL if not in cache
+    TextRun *find(const TextRunKey &key);
+    //! Creates an empty run for the key
+    TextRun *add(const TextRunKey &key);
+    //! Destroys all runs
+    void clear();
+
+private:
+    typedef std::list<TextRunKey> KeyList;
+
+    struct Entry {
+        TextRun *pRun;
+        //! Position of the key in its usage list
+        KeyList::iterator lruPos;
+    };
+
+    //! Returns the usage list for the kind of the key
+    KeyList &usage(const TextRunKey &key) {
+        return (key.flags & TextRunKey::kRunWidthOnly) ? widthsLru_ : runsLru_;
+    }
+
+    std::map<TextRunKey, Entry> runs_;
+    //! Keys of composed texts, most recently used first
+    KeyList runsLru_;
+    //! Keys of width only entries, most recently used first
+    KeyList widthsLru_;
+};
+
 /*!
  * Font class.
  */
@@ -67,13 +159,33 @@ public:
     bool isPrintable(uint16 unicode);
 
 protected:
+    /*!
+     * Position of a glyph in a text.
+     */
+    struct PlacedGlyph {
+        Sprite *pSprite;
+        int x;
+        int y;
+    };
+
     static unsigned char decode(const unsigned char * &c, bool dos);
     static int decodeUTF8(const unsigned char * &c);
     virtual Sprite *getSprite(unsigned char dos_char);
 
+    //! Computes the position of each glyph of the text
+    virtual void layoutText(const TextRunKey &key, std::vector<PlacedGlyph> &glyphs);
+    //! Returns the color to draw for a glyph pixel
+    virtual uint8 glyphColor(uint8 color, int toColor) { return color; }
+    //! Draws the text from the cache, composing it first if needed
+    void drawRun(int x, int y, const TextRunKey &key);
+    //! Composes all glyphs of the text in one buffer
+    void composeRun(const TextRunKey &key, TextRun *pRun);
+
     SpriteManager *sprites_;
     int offset_;
     FontRange range_;
+    /*! Texts already composed with this font.*/
+    TextRunCache runCache_;
 };
 
 /*! 
@@ -101,6 +213,7 @@ protected:
     virtual Sprite *getSprite(unsigned char dos_char, bool highlighted);
     //! draws a text at the given position
     void drawText(int x, int y, bool dos, const char *text, bool lighted, bool x2 = true);
+    void layoutText(const TextRunKey &key, std::vector<PlacedGlyph> &glyphs);
 
 protected:
     int lightOffset_;
@@ -118,6 +231,10 @@ public:
 
     //! draw a UTF-8 text at the given position with the given color
     void drawText(int x, int y, const char *text, uint8 toColor);
+
+protected:
+    void layoutText(const TextRunKey &key, std::vector<PlacedGlyph> &glyphs);
+    uint8 glyphColor(uint8 color, int toColor);
 };
 
 class HChar {
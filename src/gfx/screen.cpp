@@ -189,6 +189,37 @@ void Screen::blitRect(int x, int y, int width, int height,
     dirty_ = true;
 }
 
+/*!
+ * Unlike blitRect(), color 255 is copied like any other color so this
+ * can be used to restore a part of the screen that was saved before.
+ * \param x
+ * \param y
+ * \param width
+ * \param height
+ * \param pixeldata
+ * \param stride Length of a row in pixeldata (width if 0)
+ */
+void Screen::copyRect(int x, int y, int width, int height,
+                      const uint8 * pixeldata, int stride)
+{
+    stride = (stride == 0 ? width : stride);
+
+    int x1 = x < 0 ? 0 : x;
+    int y1 = y < 0 ? 0 : y;
+    int x2 = x + width > width_ ? width_ : x + width;
+    int y2 = y + height > height_ ? height_ : y + height;
+
+    if (x1 >= x2 || y1 >= y2)
+        return;
+
+    for (int j = y1; j < y2; ++j) {
+        memcpy(pixels_ + j * width_ + x1,
+            pixeldata + (j - y) * stride + (x1 - x), x2 - x1);
+    }
+
+    dirty_ = true;
+}
+
 void Screen::scale2x(int x, int y, int width, int height,
                      const uint8 * pixeldata, int stride, bool transp)
 {
@@ -54,6 +54,9 @@ public:
                   const uint8 * pixeldata, bool flipped = false, int stride = 0);
     void scale2x(int x, int y, int width, int height, const uint8 *pixeldata,
             int stride = 0, bool transp = true);
+    //! Copies pixels to the screen without transparency
+    void copyRect(int x, int y, int width, int height, const uint8 *pixeldata,
+            int stride = 0);
 
     void drawVLine(int x, int y, int length, uint8 color);
     void drawHLine(int x, int y, int length, uint8 color);
@@ -34,6 +34,9 @@
 #include "model/squad.h"
 #include "mission.h"
 #include "agentmanager.h"
+#include "utils/log.h"
+#include "utils/blockpool.h"
+#include "model/objectivedesc.h"
 
 
 //*************************************
@@ -45,6 +48,28 @@ const uint8 ShootAction::kShootActionNotAdded = 0;
 const uint8 ShootAction::kShootActionAutomaticShoot = 1;
 const uint8 ShootAction::kShootActionSingleShoot = 2;
 
+//*************************************
+// Pool of actions
+//*************************************
+/*!
+ * One free list by size of block, so in practice one by type of
+ * action. Actions are used by one thread at a time : the main thread, or
+ * the mission preload while no mission is played.
+ */
+static fs_utils::BlockPool gActionPool("Action", 64);
+
+void * Action::operator new(size_t size) {
+    return gActionPool.allocate(size);
+}
+
+void Action::operator delete(void *pBlock, size_t size) {
+    gActionPool.release(pBlock, size);
+}
+
+void Action::logPoolStats() {
+    gActionPool.logStats();
+}
+
 /*!
  * Default constructor.
  * \param aType What type of action.
@@ -386,6 +411,7 @@ bool TriggerAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed)
 bool EscapeAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed) {
     setSucceeded();
     pPed->escape();
+    pMission->signalObjectiveTrigger(kObjTrigEscape);
     return true;
 }
 
@@ -565,6 +591,7 @@ void PickupWeaponAction::doStart(Mission *pMission, PedInstance *pPed) {
 bool PickupWeaponAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed) {
     if (status_ != kActStatusWaitForAnim) {
         pWeapon_->setOwner(pPed);
+        pMission->signalObjectiveTrigger(kObjTrigWeaponTaken);
         pWeapon_->deactivate();
         pPed->addWeapon(pWeapon_);
         pMission->removeWeaponOnGround(pWeapon_);
@@ -590,6 +617,7 @@ bool EnterVehicleAction::doExecute(int elapsed, Mission *pMission, PedInstance *
     if (pPed->samePosition(pVehicle_)) {
         // state of ped is set in addPassenger
         pVehicle_->addPassenger(pPed);
+        pMission->signalObjectiveTrigger(kObjTrigVehicleEntry);
     }
     // Finish action anyway
     setSucceeded();
@@ -710,9 +738,7 @@ bool WaitBeforeShootingAction::doExecute(int elapsed, Mission *pMission, PedInst
     if (waitTimer_.update(elapsed)) {
         if (pPed->type() == PedInstance::kPedTypeAgent && pTarget_->isOurAgent()) {
             // Warn only for player agents
-            GameEvent evt;
-            evt.stream = GameEvent::kMission;
-            evt.type = GameEvent::kEvtWarnAgent;
+            GameEvent evt(GameEvent::kMission, GameEvent::kEvtWarnAgent);
             g_gameCtrl.fireGameEvent(evt);
         }
         setSucceeded();
@@ -902,7 +928,9 @@ HitAction(d) {
  */
 void PersuadedHitAction::doStart(Mission *pMission, PedInstance *pPed) {
     status_ = kActStatusWaitForAnim;
-    g_App.gameSounds().play(snd::PERSUADE);
+    Point2D scPt;
+    pMission->get_map()->tileToScreenPoint(pPed->position(), &scPt);
+    g_App.gameSounds().queue(snd::PERSUADE, scPt);
 }
 
 /*!
@@ -947,7 +975,7 @@ bool ShootAction::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
         // Shoot
         fs_dmg::DamageToInflict dmg;
         fillDamageDesc(pMission, pPed, pWeapon_, dmg);
-        pWeapon_->playSound();
+        pWeapon_->playSound(pMission);
         pWeapon_->fire(pMission, dmg, elapsed);
         // change state to firing
         pPed->goToState(PedInstance::pa_smFiring);
@@ -1051,7 +1079,7 @@ bool AutomaticShootAction::execute(int elapsed, Mission *pMission, PedInstance *
             pPed->setDirectionTowardPosition(aimedAt_);
             fs_dmg::DamageToInflict dmg;
             fillDamageDesc(pMission, pPed, pWeapon_, dmg);
-            pWeapon_->playSound();
+            pWeapon_->playSound(pMission);
             pWeapon_->fire(pMission, dmg, elapsed);
         }
     } else if (status_ == kActStatusWaitForTime) {
@@ -1095,7 +1123,7 @@ bool UseMedikitAction::execute(int elapsed, Mission *pMission, PedInstance *pPed
         if (!pWeapon_->isInstanceOf(Weapon::MediKit)) {
             setFailed();
         } else {
-            pWeapon_->playSound();
+            pWeapon_->playSound(pMission);
             fs_dmg::DamageToInflict dmg;
             dmg.d_owner = pPed;
             pWeapon_->fire(pMission, dmg, elapsed);
@@ -1128,7 +1156,7 @@ bool UseEnergyShieldAction::execute(int elapsed, Mission *pMission, PedInstance
             setFailed();
             return false;
         } else {
-            //pWeapon_->playSound();
+            //pWeapon_->playSound(pMission);
             fs_dmg::DamageToInflict dmg;
             pWeapon_->fire(pMission, dmg, elapsed);
         }
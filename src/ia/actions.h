@@ -112,6 +112,13 @@ public:
     //! Destructor of the class
     virtual ~Action() { }
 
+    //! Actions are allocated from a pool of recycled blocks
+    static void * operator new(size_t size);
+    //! Gives the block back to the pool
+    static void operator delete(void *pBlock, size_t size);
+    //! Logs allocation counters of the pool
+    static void logPoolStats();
+
     //! Entry point to execute the action
     virtual bool execute(int elapsed, Mission *pMission, PedInstance *pPed) = 0;
 
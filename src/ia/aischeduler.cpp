@@ -0,0 +1,143 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include "ia/aischeduler.h"
+#include "ped.h"
+#include "mission.h"
+#include "model/squad.h"
+#include "utils/log.h"
+
+//*************************************
+// Constant definition
+//*************************************
+const int AiScheduler::kFullRateDistance = 1500;
+const int AiScheduler::kNearDistance = 3000;
+const int AiScheduler::kNearPeriod = 100;
+const int AiScheduler::kFarPeriod = 250;
+
+AiScheduler::AiScheduler() {
+    budget_ = 0;
+    reset();
+}
+
+void AiScheduler::reset() {
+    cursor_ = 0;
+    nbFullUpdates_ = 0;
+    nbThrottledUpdates_ = 0;
+    nbPostponed_ = 0;
+}
+
+/*!
+ * Returns the tier in which the ped should be updated.
+ * \param pMission Mission data
+ * \param pPed The ped
+ * \param viewX Origin of the viewport on the map
+ * \param viewY Origin of the viewport on the map
+ */
+AiScheduler::Tier AiScheduler::tierForPed(Mission *pMission, PedInstance *pPed, int viewX, int viewY) {
+    if (pPed->isOurAgent() || pPed->isPersuaded() || pPed->isArmed()
+        || pPed->isCurrentActionFromSource(Action::kActionAlt)
+        || pMission->isObjectiveTarget(pPed)) {
+        // ped is with us, in the middle of a fight or panic or
+        // the mission depends on it
+        return kTierFull;
+    }
+
+    Point2D scPt;
+    pMission->get_map()->tileToScreenPoint(pPed->position(), &scPt);
+    if (scPt.x >= viewX && scPt.x < viewX + GAME_SCREEN_WIDTH
+        && scPt.y >= viewY && scPt.y < viewY + GAME_SCREEN_HEIGHT) {
+        return kTierFull;
+    }
+
+    Tier tier = kTierFar;
+    for (size_t i = 0; i < pMission->getSquad()->size(); i++) {
+        PedInstance *pAgent = pMission->getSquad()->member(i);
+        if (pAgent && pAgent->isAlive()) {
+            if (pPed->isCloseTo(pAgent, kFullRateDistance)) {
+                return kTierFull;
+            } else if (pPed->isCloseTo(pAgent, kNearDistance)) {
+                tier = kTierNear;
+            }
+        }
+    }
+    return tier;
+}
+
+/*!
+ * Decides which peds will execute their behaviour during this step.
+ * Must be called before peds are animated.
+ * \param pMission Mission data
+ * \param viewX Origin of the viewport on the map
+ * \param viewY Origin of the viewport on the map
+ */
+void AiScheduler::schedule(Mission *pMission, int viewX, int viewY) {
+    size_t nbPeds = pMission->numPeds();
+    if (nbPeds == 0) {
+        return;
+    }
+    if (cursor_ >= nbPeds) {
+        cursor_ = 0;
+    }
+
+    int nbServed = 0;
+    size_t nextCursor = cursor_;
+    for (size_t n = 0; n < nbPeds; n++) {
+        size_t i = (cursor_ + n) % nbPeds;
+        PedInstance *pPed = pMission->ped(i);
+        Behaviour &behaviour = pPed->behaviour();
+
+        if (pPed->isDead()) {
+            behaviour.setScheduled(true);
+            continue;
+        }
+
+        Tier tier = tierForPed(pMission, pPed, viewX, viewY);
+        if (tier == kTierFull) {
+            behaviour.setScheduled(true);
+            nbFullUpdates_++;
+            continue;
+        }
+
+        int period = (tier == kTierNear) ? kNearPeriod : kFarPeriod;
+        if (behaviour.pendingElapsed() < period) {
+            // not its turn yet
+            behaviour.setScheduled(false);
+        } else if (budget_ == 0 || nbServed < budget_) {
+            behaviour.setScheduled(true);
+            nbThrottledUpdates_++;
+            nbServed++;
+            nextCursor = i + 1;
+        } else {
+            // will be served first next time
+            behaviour.setScheduled(false);
+            nbPostponed_++;
+        }
+    }
+    cursor_ = nextCursor;
+}
+
+void AiScheduler::logStats() {
+    LOG(Log::k_FLG_GAME, "AiScheduler", "logStats", ("%d full rate updates, %d throttled updates, %d postponed",
+        nbFullUpdates_, nbThrottledUpdates_, nbPostponed_));
+}
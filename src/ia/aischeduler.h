@@ -0,0 +1,98 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef IA_AISCHEDULER_H_
+#define IA_AISCHEDULER_H_
+
+#include "common.h"
+
+class Mission;
+class PedInstance;
+
+/*!
+ * The AI scheduler decides, at each animation step, which peds will
+ * execute their behaviour. Actions and animations are always executed:
+ * only the decision making is throttled.
+ * Peds are placed in tiers according to their distance to the squad and
+ * to the viewport. Peds far from the action update less often and the
+ * number of such updates per step is limited by a budget. Peds that are
+ * due but over budget are served first on next step (round robin).
+ * Squad agents, persuaded peds and peds that are armed or fighting
+ * always update.
+ */
+class AiScheduler {
+public:
+    /*!
+     * Update frequency tiers.
+     */
+    enum Tier {
+        //! Behaviour is executed at each step
+        kTierFull,
+        //! Ped is not far from the squad
+        kTierNear,
+        //! Ped is far from the squad and not on screen
+        kTierFar
+    };
+
+    //! Peds closer than this to an agent always update
+    static const int kFullRateDistance;
+    //! Peds closer than this to an agent are in the near tier
+    static const int kNearDistance;
+    //! Minimum time in ms between two updates in the near tier
+    static const int kNearPeriod;
+    //! Minimum time in ms between two updates in the far tier
+    static const int kFarPeriod;
+
+    AiScheduler();
+
+    //! Resets the scheduler for a new mission
+    void reset();
+    /*!
+     * Sets the maximum number of throttled peds that can update during a step.
+     * 0 means no limit.
+     */
+    void setBudget(int budget) { budget_ = budget; }
+
+    //! Marks peds whose behaviour must be executed during this step
+    void schedule(Mission *pMission, int viewX, int viewY);
+
+    //! Logs statistics on scheduling
+    void logStats();
+
+private:
+    Tier tierForPed(Mission *pMission, PedInstance *pPed, int viewX, int viewY);
+
+private:
+    /*! Max number of throttled updates in a step.*/
+    int budget_;
+    /*! Index of the ped where to start serving throttled peds.*/
+    size_t cursor_;
+    /*! Number of behaviours executed because ped is important.*/
+    uint32 nbFullUpdates_;
+    /*! Number of throttled behaviours executed.*/
+    uint32 nbThrottledUpdates_;
+    /*! Number of behaviours postponed because budget was reached.*/
+    uint32 nbPostponed_;
+};
+
+#endif // IA_AISCHEDULER_H_
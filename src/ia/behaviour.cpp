@@ -36,12 +36,17 @@
 // Constant definition
 //*************************************
 const int CommonAgentBehaviourComponent::kRegeratesHealthStep = 1;
-const int PanicComponent::kScoutDistance = 1500;
+const int PanicComponent::kScoutDistance = PedSensors::kScoutDistance;
 const int PanicComponent::kDistanceToRun = 500;
 const double PersuadedBehaviourComponent::kMaxRangeForSearchingWeapon = 500.0;
-const int PoliceBehaviourComponent::kPoliceScoutDistance = 1500;
 const int PoliceBehaviourComponent::kPolicePendingTime = 1500;
-const int PlayerHostileBehaviourComponent::kEnemyScoutDistance = 1500;
+
+Behaviour::Behaviour() {
+    pThisPed_ = NULL;
+    scheduled_ = true;
+    pendingElapsed_ = 0;
+    applyElapsed_ = 0;
+}
 
 Behaviour::~Behaviour() {
     destroyComponents();
@@ -75,12 +80,55 @@ void Behaviour::replaceAllcomponentsBy(BehaviourComponent *pComp) {
 }
 
 /*!
- * Run the execute method  of each component listed in the behaviour.
- * Component must be enabled.
+ * Evaluates and applies the behaviour at once.
  * \param elapsed Time elapsed since last frame
  * \param pMission Mission data
  */
 void Behaviour::execute(int elapsed, Mission *pMission) {
+    if (evaluate(elapsed, pMission)) {
+        apply(pMission);
+    }
+}
+
+/*!
+ * Run the evaluate method of each component listed in the behaviour.
+ * Component must be enabled. If the AI scheduler has postponed the
+ * behaviour, elapsed time is accumulated for the next execution.
+ * This method may be called in parallel for different peds so it
+ * must not modify anything outside this behaviour.
+ * \param elapsed Time elapsed since last frame
+ * \param pMission Mission data
+ * \return true if apply() must be called.
+ */
+bool Behaviour::evaluate(int elapsed, Mission *pMission) {
+    if (pThisPed_->isDead()) {
+        return false;
+    }
+
+    pendingElapsed_ += elapsed;
+    if (!scheduled_) {
+        return false;
+    }
+    applyElapsed_ = pendingElapsed_;
+    pendingElapsed_ = 0;
+
+    bool pending = false;
+    for (std::list < BehaviourComponent * >::iterator it = compLst_.begin();
+            it != compLst_.end(); it++) {
+        BehaviourComponent *pComp = *it;
+        bool compPending = pComp->isEnabled() && pComp->evaluate(applyElapsed_, pMission, pThisPed_);
+        pComp->setPendingApply(compPending);
+        pending |= compPending;
+    }
+    return pending;
+}
+
+/*!
+ * Run the execute method of each component that has something to apply
+ * after evaluation. Components disabled since evaluation are skipped.
+ * \param pMission Mission data
+ */
+void Behaviour::apply(Mission *pMission) {
     if (pThisPed_->isDead()) {
         return;
     }
@@ -88,8 +136,9 @@ void Behaviour::execute(int elapsed, Mission *pMission) {
     for (std::list < BehaviourComponent * >::iterator it = compLst_.begin();
             it != compLst_.end(); it++) {
         BehaviourComponent *pComp = *it;
-        if (pComp->isEnabled()) {
-            pComp->execute(elapsed, pMission, pThisPed_);
+        if (pComp->isPendingApply() && pComp->isEnabled()) {
+            pComp->setPendingApply(false);
+            pComp->execute(applyElapsed_, pMission, pThisPed_);
         }
     }
 }
@@ -105,12 +154,14 @@ CommonAgentBehaviourComponent::CommonAgentBehaviourComponent(PedInstance *pPed):
  * \param pMission Mission data
  * \param pPed The owner of the behaviour
  */
-void CommonAgentBehaviourComponent::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
+bool CommonAgentBehaviourComponent::evaluate(int elapsed, Mission *pMission, PedInstance *pPed) {
     // If Agent is equiped with right chest, his health periodically updates
-    if (doRegenerates_ && healthTimer_.update(elapsed)) {
-        if (pPed->increaseHealth(kRegeratesHealthStep)) {
-            doRegenerates_ = false;
-        }
+    return doRegenerates_ && healthTimer_.update(elapsed);
+}
+
+void CommonAgentBehaviourComponent::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
+    if (pPed->increaseHealth(kRegeratesHealthStep)) {
+        doRegenerates_ = false;
     }
 }
 
@@ -203,8 +254,8 @@ void PersuadedBehaviourComponent::execute(int elapsed, Mission *pMission, PedIns
 
 void PersuadedBehaviourComponent::handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt) {
     if (evtType == Behaviour::kBehvEvtWeaponOut) {
-        PedInstance *pPedSource = static_cast<PedInstance *> (pCtxt);
-        if (pPedSource == pPed->owner()) {
+        ArmedPedsChanges *pChanges = static_cast<ArmedPedsChanges *> (pCtxt);
+        if (pChanges->contains(pPed->owner(), true)) {
             // the ped who is armed is our owner so select weapon or look for one
             if (pPed->numWeapons() > 0) {
                 pPed->selectWeapon(0);
@@ -214,8 +265,8 @@ void PersuadedBehaviourComponent::handleBehaviourEvent(PedInstance *pPed, Behavi
             }
         }
     } else if (evtType == Behaviour::kBehvEvtWeaponCleared) {
-        PedInstance *pPedSource = static_cast<PedInstance *> (pCtxt);
-        if (pPedSource == pPed->owner()) {
+        ArmedPedsChanges *pChanges = static_cast<ArmedPedsChanges *> (pCtxt);
+        if (pChanges->contains(pPed->owner(), false)) {
             // the ped who cleared his weapon is our owner so deselect weapon or
             // stop searching for one
             if (pPed->deselectWeapon() == NULL && status_ == kPersuadStatusLookForWeapon) {
@@ -292,18 +343,29 @@ PanicComponent::PanicComponent():
         BehaviourComponent(), scoutTimer_(500) {
     backFromPanic_ = false;
     status_ = kPanicStatusAlert;
+    pArmedPed_ = NULL;
+    pFoundPed_ = NULL;
     // this component will be activated by event to
     // lower CPU consumption
     setEnabled(false);
 }
 
-void PanicComponent::execute(int elapsed, Mission *pMission, PedInstance *pCivil) {
+bool PanicComponent::evaluate(int elapsed, Mission *pMission, PedInstance *pCivil) {
     if (pCivil->isPanicImmuned()) {
-        return;
+        return false;
     }
 
     if (status_ == kPanicStatusAlert && scoutTimer_.update(elapsed)) {
-        pArmedPed_ = findNearbyArmedPed(pMission, pCivil);
+        pFoundPed_ = findNearbyArmedPed(pMission, pCivil);
+        return true;
+    }
+    return false;
+}
+
+void PanicComponent::execute(int elapsed, Mission *pMission, PedInstance *pCivil) {
+    // status may have changed by an event since evaluation
+    if (status_ == kPanicStatusAlert) {
+        pArmedPed_ = pFoundPed_;
         if (pArmedPed_) {
             runAway(pCivil);
             status_ = kPanicStatusInPanic;
@@ -364,13 +426,7 @@ void PanicComponent::handleBehaviourEvent(PedInstance *pCivil, Behaviour::Behavi
  * \return NULL if no ped is found
  */
 PedInstance * PanicComponent::findNearbyArmedPed(Mission *pMission, PedInstance *pPed) {
-    for (size_t i = 0; i < pMission->numArmedPeds(); i++) {
-        PedInstance *pOtherPed = pMission->armedPedAtIndex(i);
-        if (pPed->isCloseTo(pOtherPed, kScoutDistance)) {
-            return pOtherPed;
-        }
-    }
-    return NULL;
+    return pMission->sensors().findArmedPed(pPed, false);
 }
 
 /*!
@@ -401,15 +457,32 @@ void  PanicComponent::runAway(PedInstance *pPed) {
 PoliceBehaviourComponent::PoliceBehaviourComponent():
         BehaviourComponent(), scoutTimer_(200) {
     status_ = kPoliceStatusDefault;
+    evaluatedStatus_ = kPoliceStatusDefault;
     pTarget_ = NULL;
+    pFoundPed_ = NULL;
+}
+
+bool PoliceBehaviourComponent::evaluate(int elapsed, Mission *pMission, PedInstance *pPed) {
+    if ((status_ == kPoliceStatusAlert && scoutTimer_.update(elapsed))
+        || status_ == kPoliceStatusCheckReengageOrDefault) {
+        evaluatedStatus_ = status_;
+        pFoundPed_ = findArmedPedNotPolice(pMission, pPed);
+        return true;
+    }
+    return false;
 }
 
 void PoliceBehaviourComponent::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
-    if (status_ == kPoliceStatusAlert && scoutTimer_.update(elapsed)) {
-        findAndEngageNewTarget(pMission, pPed);
+    if (status_ != evaluatedStatus_) {
+        // an event has changed the status since evaluation
+        return;
+    }
+
+    if (status_ == kPoliceStatusAlert) {
+        engageFoundTarget(pPed);
     } else if (status_ == kPoliceStatusCheckReengageOrDefault) {
         // check if there is a nearby enemy
-        bool foundNewTarget = findAndEngageNewTarget(pMission, pPed);
+        bool foundNewTarget = engageFoundTarget(pPed);
         if ( !foundNewTarget && !pPed->isCurrentActionFromSource(Action::kActionDefault)) {
             // there is no one around so go back to patrol if it's not already the case
             pPed->deselectWeapon();
@@ -437,7 +510,8 @@ void PoliceBehaviourComponent::handleBehaviourEvent(PedInstance *pPed, Behaviour
         break;
     case Behaviour::kBehvEvtWeaponCleared:
         // our target has dropped his weapon
-        if (status_ == kPoliceStatusFollowAndShootTarget && pTarget_ == pCtxt) {
+        if (status_ == kPoliceStatusFollowAndShootTarget &&
+                static_cast<ArmedPedsChanges *> (pCtxt)->contains(pTarget_, false)) {
             status_ = kPoliceStatusPendingEndFollow;
             pPed->stopShooting();
 
@@ -482,25 +556,21 @@ void PoliceBehaviourComponent::handleEjectionFromVehicle(PedInstance *pPed, void
     status_ = kPoliceStatusOutOfVehicle;
 }
 
-bool PoliceBehaviourComponent::findAndEngageNewTarget(Mission *pMission, PedInstance *pPed) {
-    PedInstance *pArmedGuy = findArmedPedNotPolice(pMission, pPed);
-    if (pArmedGuy != NULL) {
+bool PoliceBehaviourComponent::engageFoundTarget(PedInstance *pPed) {
+    PedInstance *pArmedGuy = pFoundPed_;
+    // target may have dropped his weapon since evaluation
+    if (pArmedGuy != NULL && pArmedGuy->isAlive() && pArmedGuy->isArmed()) {
         followAndShootTarget(pPed, pArmedGuy);
+        return true;
     }
-    return pArmedGuy != NULL;
+    return false;
 }
 
 /*!
  * Return a ped that has his weapon out and is not a police man and is close to this policeman.
  */
 PedInstance * PoliceBehaviourComponent::findArmedPedNotPolice(Mission *pMission, PedInstance *pPed) {
-    for (size_t i = 0; i < pMission->numArmedPeds(); i++) {
-        PedInstance *pOtherPed = pMission->armedPedAtIndex(i);
-        if (pPed != pOtherPed && pOtherPed->type() != PedInstance::kPedTypePolice && pPed->isCloseTo(pOtherPed, kPoliceScoutDistance)) {
-            return pOtherPed;
-        }
-    }
-    return NULL;
+    return pMission->sensors().findArmedPed(pPed, true);
 }
 
 void PoliceBehaviourComponent::followAndShootTarget(PedInstance *pPed, PedInstance *pArmedGuy) {
@@ -549,13 +619,35 @@ void PoliceBehaviourComponent::followAndShootTarget(PedInstance *pPed, PedInstan
 PlayerHostileBehaviourComponent::PlayerHostileBehaviourComponent():
         BehaviourComponent() {
     status_ = kHostileStatusDefault;
+    evaluatedStatus_ = kHostileStatusDefault;
+    pTarget_ = NULL;
+    pFoundPed_ = NULL;
 }
 
-void PlayerHostileBehaviourComponent::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
+bool PlayerHostileBehaviourComponent::evaluate(int elapsed, Mission *pMission, PedInstance *pPed) {
+    evaluatedStatus_ = status_;
     if (status_ == kHostileStatusDefault) {
         // In this mode, ped is looking for an enemy
-        PedInstance *pArmedGuy = findPlayerAgent(pMission, pPed);
-        if (pArmedGuy != NULL) {
+        pFoundPed_ = findPlayerAgent(pMission, pPed);
+        return pFoundPed_ != NULL;
+    } else if (status_ == kHostileStatusFollowAndShoot) {
+        return pTarget_->isDead();
+    } else if (status_ == kHostileStatusCheckForDefault) {
+        pFoundPed_ = findPlayerAgent(pMission, pPed);
+        return true;
+    }
+    return false;
+}
+
+void PlayerHostileBehaviourComponent::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
+    if (status_ != evaluatedStatus_) {
+        // an event has changed the status since evaluation
+        return;
+    }
+
+    if (status_ == kHostileStatusDefault) {
+        PedInstance *pArmedGuy = pFoundPed_;
+        if (pArmedGuy != NULL && pArmedGuy->isAlive()) {
             status_ = kHostileStatusFollowAndShoot;
             followAndShootTarget(pPed, pArmedGuy);
         }
@@ -570,8 +662,8 @@ void PlayerHostileBehaviourComponent::execute(int elapsed, Mission *pMission, Pe
         pPed->addMovementAction(pWait, false);
     } else if (status_ == kHostileStatusCheckForDefault) {
         // check if there is a nearby enemy
-        PedInstance *pArmedGuy = findPlayerAgent(pMission, pPed);
-        if (pArmedGuy != NULL) {
+        PedInstance *pArmedGuy = pFoundPed_;
+        if (pArmedGuy != NULL && pArmedGuy->isAlive()) {
             status_ = kHostileStatusFollowAndShoot;
             followAndShootTarget(pPed, pArmedGuy);
         } else {
@@ -591,13 +683,7 @@ void PlayerHostileBehaviourComponent::handleBehaviourEvent(PedInstance *pPed, Be
 }
 
 PedInstance * PlayerHostileBehaviourComponent::findPlayerAgent(Mission *pMission, PedInstance *pPed) {
-    for (size_t i = 0; i < pMission->getSquad()->size(); i++) {
-        PedInstance *pAgent = pMission->getSquad()->member(i);
-        if (pAgent && pAgent->isAlive() && pPed->isCloseTo(pAgent, kEnemyScoutDistance)) {
-            return pAgent;
-        }
-    }
-    return NULL;
+    return pMission->sensors().findSquadAgent(pPed);
 }
 
 void PlayerHostileBehaviourComponent::followAndShootTarget(PedInstance *pPed, PedInstance *pArmedGuy) {
@@ -53,9 +53,9 @@ public:
         kBehvEvtPersuadotronDeactivated,
         //! An ped has been hit
         kBehvEvtHit,
-        //! A ped has shown his weapon
+        //! Peds have shown their weapon (context is the ArmedPedsChanges)
         kBehvEvtWeaponOut,
-        //! A ped has cleared his weapon
+        //! Peds have cleared their weapon (context is the ArmedPedsChanges)
         kBehvEvtWeaponCleared,
         //! An action has ended
         kBehvEvtActionEnded,
@@ -65,15 +65,28 @@ public:
         kBehvEvtEjectedFromVehicle,
     };
 
+    Behaviour();
     virtual ~Behaviour();
 
     void setOwner(PedInstance *pPed) { pThisPed_ = pPed; }
+    /*!
+     * Tells whether the behaviour is executed on next animation step.
+     * When not scheduled, elapsed time is kept for next execution.
+     */
+    void setScheduled(bool scheduled) { scheduled_ = scheduled; }
+    //! Time elapsed since the last execution of the behaviour
+    int pendingElapsed() { return pendingElapsed_; }
     //! Adds a component to the behaviour
     void addComponent(BehaviourComponent *pComp);
     //! Destroy existing components and set given one as new one
     void replaceAllcomponentsBy(BehaviourComponent *pComp);
 
+    //! Evaluates then applies the behaviour
     virtual void execute(int elapsed, Mission *pMission);
+    //! Read phase : components look at the world without modifying it
+    bool evaluate(int elapsed, Mission *pMission);
+    //! Write phase : components apply what they have decided
+    void apply(Mission *pMission);
 
     virtual void handleBehaviourEvent(BehaviourEvent evtType, void *pCtxt = NULL);
 protected:
@@ -83,26 +96,44 @@ protected:
     PedInstance *pThisPed_;
     /*! List of behaviour components.*/
     std::list <BehaviourComponent *> compLst_;
+    /*! False means AI scheduler has postponed the execution.*/
+    bool scheduled_;
+    /*! Time elapsed since the last execution.*/
+    int pendingElapsed_;
+    /*! Time passed to components during the write phase.*/
+    int applyElapsed_;
 };
 
 /*!
  * Abstract class that represent an aspect of a behaviour.
  * A component may be disabled according to certain types of events.
+ * A component is run in two steps : evaluate() may be run in parallel
+ * with other peds and must only read the world and the component's
+ * own state. execute() is run serially, in peds order, only if evaluate()
+ * returned true. By default, everything is done in execute().
  */
 class BehaviourComponent {
 public:
-    BehaviourComponent() { enabled_ = true; }
+    BehaviourComponent() { enabled_ = true; pendingApply_ = false; }
     virtual ~BehaviourComponent() {}
 
     bool isEnabled() { return enabled_; }
-    void setEnabled(bool val) { enabled_ = val; }
-
+    //! Enabling or disabling a component drops what it had to apply
+    void setEnabled(bool val) { enabled_ = val; pendingApply_ = false; }
+    //! True if execute() must be called after evaluation
+    bool isPendingApply() { return pendingApply_; }
+    void setPendingApply(bool val) { pendingApply_ = val; }
+
+    //! Returns true if component has something to apply
+    virtual bool evaluate(int elapsed, Mission *pMission, PedInstance *pPed) { return true; }
     virtual void execute(int elapsed, Mission *pMission, PedInstance *pPed) = 0;
 
     virtual void handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt){};
 
 protected:
     bool enabled_;
+    /*! Set when evaluate() has returned true.*/
+    bool pendingApply_;
 };
 
 /*!
@@ -117,6 +148,7 @@ public:
 
     CommonAgentBehaviourComponent(PedInstance *pPed);
 
+    bool evaluate(int elapsed, Mission *pMission, PedInstance *pPed);
     void execute(int elapsed, Mission *pMission, PedInstance *pPed);
 
     void handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt);
@@ -200,6 +232,7 @@ public:
 
     PanicComponent();
 
+    bool evaluate(int elapsed, Mission *pMission, PedInstance *pPed);
     void execute(int elapsed, Mission *pMission, PedInstance *pPed);
 
     void handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt);
@@ -227,25 +260,27 @@ private:
     bool backFromPanic_;
     /*! The ped that frightened this civilian.*/
     PedInstance *pArmedPed_;
+    /*! Armed ped found during evaluation.*/
+    PedInstance *pFoundPed_;
 };
 
 class PoliceBehaviourComponent : public BehaviourComponent {
 public:
     PoliceBehaviourComponent();
 
+    bool evaluate(int elapsed, Mission *pMission, PedInstance *pPed);
     void execute(int elapsed, Mission *pMission, PedInstance *pPed);
 
     void handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt);
 private:
     void handleEjectionFromVehicle(PedInstance *pPed, void *pCtxt);
-    //! Find a nearby armed Ped and follow and shoot him
-    bool findAndEngageNewTarget(Mission *pMission, PedInstance *pPed);
+    //! Follow and shoot the armed ped found during evaluation if any
+    bool engageFoundTarget(PedInstance *pPed);
     //! Checks whether there is an armed ped next to the ped : returns that ped
     PedInstance * findArmedPedNotPolice(Mission *pMission, PedInstance *pPed);
     //! Initiate the process of following and shooting at a target
     void followAndShootTarget(PedInstance *pPed, PedInstance *pArmedGuy);
 private:
-    static const int kPoliceScoutDistance;
     static const int kPolicePendingTime;
     /*!
      * Status of police behaviour.
@@ -271,6 +306,10 @@ private:
     fs_utils::Timer scoutTimer_;
     /*! The ped that the police officer is watching and eventually shooting at.*/
     PedInstance *pTarget_;
+    /*! Armed ped found during evaluation.*/
+    PedInstance *pFoundPed_;
+    /*! Status when evaluation was done.*/
+    PoliceStatus evaluatedStatus_;
 };
 
 /*!
@@ -280,6 +319,7 @@ class PlayerHostileBehaviourComponent : public BehaviourComponent {
 public:
     PlayerHostileBehaviourComponent();
 
+    bool evaluate(int elapsed, Mission *pMission, PedInstance *pPed);
     void execute(int elapsed, Mission *pMission, PedInstance *pPed);
 
     void handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt);
@@ -289,8 +329,6 @@ private:
     PedInstance * findPlayerAgent(Mission *pMission, PedInstance *pPed);
     void followAndShootTarget(PedInstance *pPed, PedInstance *pArmedGuy);
 private:
-    static const int kEnemyScoutDistance;
-
    /*!
      * Status for behavior.
      */
@@ -308,6 +346,10 @@ private:
     PlayerHostileStatus status_;
     /*! The ped that the owner has targeted and potentially is shooting at.*/
     PedInstance *pTarget_;
+    /*! Agent found during evaluation.*/
+    PedInstance *pFoundPed_;
+    /*! Status when evaluation was done.*/
+    PlayerHostileStatus evaluatedStatus_;
 };
 
 
@@ -0,0 +1,180 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <SDL_thread.h>
+
+#include "ia/behaviourrunner.h"
+#include "ped.h"
+#include "mission.h"
+#include "utils/log.h"
+
+const size_t BehaviourRunner::kMinPedsPerWorker = 32;
+
+BehaviourRunner::BehaviourRunner() {
+    pDoneSem_ = NULL;
+    quit_ = false;
+    pMission_ = NULL;
+    elapsed_ = 0;
+}
+
+BehaviourRunner::~BehaviourRunner() {
+    stop();
+}
+
+/*!
+ * Creates the pool of workers. The main thread also evaluates peds
+ * so nbThreads - 1 threads are created.
+ * \param nbThreads Total number of threads evaluating behaviours
+ */
+void BehaviourRunner::start(int nbThreads) {
+    stop();
+
+    // Main thread is the last worker
+    Worker *pMainWorker = new Worker();
+    pMainWorker->pRunner = this;
+    pMainWorker->pThread = NULL;
+    pMainWorker->pStartSem = NULL;
+    workers_.push_back(pMainWorker);
+
+    if (nbThreads <= 1) {
+        return;
+    }
+
+    quit_ = false;
+    pDoneSem_ = SDL_CreateSemaphore(0);
+    for (int i = 1; i < nbThreads; i++) {
+        Worker *pWorker = new Worker();
+        pWorker->pRunner = this;
+        pWorker->pStartSem = SDL_CreateSemaphore(0);
+        pWorker->pThread = SDL_CreateThread(workerLoop, pWorker);
+        if (pWorker->pThread == NULL) {
+            FSERR(Log::k_FLG_GAME, "BehaviourRunner", "start", ("Cannot create worker thread\n"));
+            SDL_DestroySemaphore(pWorker->pStartSem);
+            delete pWorker;
+            break;
+        }
+        workers_.insert(workers_.end() - 1, pWorker);
+    }
+    LOG(Log::k_FLG_GAME, "BehaviourRunner", "start", ("Behaviours evaluated by %d threads", (int) workers_.size()));
+}
+
+void BehaviourRunner::stop() {
+    quit_ = true;
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker *pWorker = workers_[i];
+        if (pWorker->pThread) {
+            SDL_SemPost(pWorker->pStartSem);
+            SDL_WaitThread(pWorker->pThread, NULL);
+            SDL_DestroySemaphore(pWorker->pStartSem);
+        }
+        delete pWorker;
+    }
+    workers_.clear();
+
+    if (pDoneSem_) {
+        SDL_DestroySemaphore(pDoneSem_);
+        pDoneSem_ = NULL;
+    }
+}
+
+int BehaviourRunner::workerLoop(void *pData) {
+    Worker *pWorker = static_cast<Worker *>(pData);
+    BehaviourRunner *pRunner = pWorker->pRunner;
+
+    while (true) {
+        SDL_SemWait(pWorker->pStartSem);
+        if (pRunner->quit_) {
+            break;
+        }
+        pRunner->evaluateRange(pWorker);
+        SDL_SemPost(pRunner->pDoneSem_);
+    }
+    return 0;
+}
+
+/*!
+ * Evaluates behaviours of the worker's peds and records those that
+ * need to be applied.
+ */
+void BehaviourRunner::evaluateRange(Worker *pWorker) {
+    pWorker->commands.clear();
+    for (size_t i = pWorker->first; i < pWorker->last; i++) {
+        PedInstance *pPed = pMission_->ped(i);
+        if (pPed->behaviour().evaluate(elapsed_, pMission_)) {
+            pWorker->commands.push_back(pPed);
+        }
+    }
+}
+
+/*!
+ * Evaluates behaviours of all peds, in parallel if there are enough peds,
+ * then applies the results in peds order.
+ * \param pMission Mission data
+ * \param elapsed Time elapsed since last step
+ */
+void BehaviourRunner::run(Mission *pMission, int elapsed) {
+    if (workers_.empty()) {
+        start(1);
+    }
+
+    pMission_ = pMission;
+    elapsed_ = elapsed;
+
+    size_t nbPeds = pMission->numPeds();
+    size_t nbWorkers = nbPeds / kMinPedsPerWorker;
+    if (nbWorkers > workers_.size()) {
+        nbWorkers = workers_.size();
+    } else if (nbWorkers == 0) {
+        nbWorkers = 1;
+    }
+
+    // Split peds in contiguous ranges : main thread takes the last one
+    size_t firstWorker = workers_.size() - nbWorkers;
+    size_t chunk = (nbPeds + nbWorkers - 1) / nbWorkers;
+    for (size_t w = firstWorker; w < workers_.size(); w++) {
+        Worker *pWorker = workers_[w];
+        size_t n = w - firstWorker;
+        pWorker->first = n * chunk < nbPeds ? n * chunk : nbPeds;
+        pWorker->last = pWorker->first + chunk < nbPeds ? pWorker->first + chunk : nbPeds;
+    }
+
+    // Read phase
+    for (size_t w = firstWorker; w < workers_.size() - 1; w++) {
+        SDL_SemPost(workers_[w]->pStartSem);
+    }
+    evaluateRange(workers_.back());
+    for (size_t w = firstWorker; w < workers_.size() - 1; w++) {
+        SDL_SemWait(pDoneSem_);
+    }
+
+    // Write phase : ranges are contiguous so this is the peds order
+    for (size_t w = firstWorker; w < workers_.size(); w++) {
+        std::vector<PedInstance *> &commands = workers_[w]->commands;
+        for (size_t c = 0; c < commands.size(); c++) {
+            commands[c]->behaviour().apply(pMission);
+        }
+        commands.clear();
+    }
+
+    pMission_ = NULL;
+}
@@ -0,0 +1,92 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef IA_BEHAVIOURRUNNER_H_
+#define IA_BEHAVIOURRUNNER_H_
+
+#include <vector>
+
+#include "common.h"
+
+class Mission;
+class PedInstance;
+struct SDL_Thread;
+struct SDL_semaphore;
+
+/*!
+ * Runs the behaviours of all peds at the start of each animation step.
+ * The read phase is run in parallel by a pool of workers, each one
+ * taking a contiguous range of peds and recording in its own buffer
+ * the peds whose behaviour has something to apply. Once all workers
+ * have finished, the write phase is run by the main thread, buffer after
+ * buffer, so behaviours are always applied in peds order whatever the
+ * number of workers. With few peds, the main thread does both phases.
+ */
+class BehaviourRunner {
+public:
+    //! Under this number of peds, evaluation is done in the main thread
+    static const size_t kMinPedsPerWorker;
+
+    BehaviourRunner();
+    ~BehaviourRunner();
+
+    //! Creates the workers
+    void start(int nbThreads);
+    //! Destroys the workers
+    void stop();
+
+    //! Evaluates then applies behaviours of all peds
+    void run(Mission *pMission, int elapsed);
+
+private:
+    /*!
+     * A worker evaluates a range of peds.
+     */
+    struct Worker {
+        BehaviourRunner *pRunner;
+        SDL_Thread *pThread;
+        /*! Posted by the main thread to start an evaluation.*/
+        SDL_semaphore *pStartSem;
+        /*! Range of peds to evaluate : [first, last[.*/
+        size_t first;
+        size_t last;
+        /*! Peds of the range whose behaviour must be applied.*/
+        std::vector<PedInstance *> commands;
+    };
+
+    static int workerLoop(void *pData);
+    void evaluateRange(Worker *pWorker);
+
+private:
+    std::vector<Worker *> workers_;
+    /*! Posted by workers when they have finished.*/
+    SDL_semaphore *pDoneSem_;
+    /*! Set to stop workers.*/
+    bool quit_;
+    /*! Current mission during a run.*/
+    Mission *pMission_;
+    /*! Elapsed time during a run.*/
+    int elapsed_;
+};
+
+#endif // IA_BEHAVIOURRUNNER_H_
@@ -0,0 +1,164 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "ia/sensors.h"
+#include "ped.h"
+#include "mission.h"
+#include "model/squad.h"
+
+const int PedSensors::kScoutDistance;
+
+PedSensors::PedSensors() {
+    armedPeds_.reserve(32);
+    agents_.reserve(4);
+}
+
+/*!
+ * Stores the position of all armed peds and living squad agents, then
+ * finds for each living ped the first of them within scout range.
+ * Must be called before behaviours are evaluated as their results are
+ * only valid until peds move.
+ * \param pMission Mission data
+ */
+void PedSensors::update(Mission *pMission) {
+    clear();
+
+    for (size_t i = 0; i < pMission->numArmedPeds(); i++) {
+        PedInstance *pPed = pMission->armedPedAtIndex(i);
+        if (pPed->isAlive()) {
+            addSensedPed(armedPeds_, pPed);
+        }
+    }
+
+    for (size_t i = 0; i < pMission->getSquad()->size(); i++) {
+        PedInstance *pAgent = pMission->getSquad()->member(i);
+        if (pAgent && pAgent->isAlive()) {
+            addSensedPed(agents_, pAgent);
+        }
+    }
+
+    size_t nbIds = 0;
+    for (size_t i = 0; i < pMission->numPeds(); i++) {
+        if (pMission->ped(i)->id() >= nbIds) {
+            nbIds = pMission->ped(i)->id() + 1;
+        }
+    }
+    sights_.resize(nbIds);
+    observers_.assign(nbIds, NULL);
+
+    for (size_t i = 0; i < pMission->numPeds(); i++) {
+        PedInstance *pObserver = pMission->ped(i);
+        if (!pObserver->isAlive()) {
+            continue;
+        }
+
+        WorldPoint observerW(pObserver->position());
+        Sight &sight = sights_[pObserver->id()];
+        sight.pArmedPed = NULL;
+        sight.pArmedPedNotPolice = NULL;
+        sight.pAgent = NULL;
+
+        for (size_t a = 0; a < armedPeds_.size() && sight.pArmedPedNotPolice == NULL; a++) {
+            const SensedPed &sensed = armedPeds_[a];
+            if (sensed.pPed != pObserver && isInRange(sensed, observerW.x, observerW.y, observerW.z)) {
+                if (sight.pArmedPed == NULL) {
+                    sight.pArmedPed = sensed.pPed;
+                }
+                if (!sensed.isPolice) {
+                    sight.pArmedPedNotPolice = sensed.pPed;
+                }
+            }
+        }
+
+        for (size_t a = 0; a < agents_.size() && sight.pAgent == NULL; a++) {
+            const SensedPed &sensed = agents_[a];
+            if (sensed.pPed != pObserver && isInRange(sensed, observerW.x, observerW.y, observerW.z)) {
+                sight.pAgent = sensed.pPed;
+            }
+        }
+        observers_[pObserver->id()] = pObserver;
+    }
+}
+
+void PedSensors::clear() {
+    armedPeds_.clear();
+    agents_.clear();
+    observers_.clear();
+}
+
+void PedSensors::addSensedPed(std::vector<SensedPed> &list, PedInstance *pPed) {
+    WorldPoint posW(pPed->position());
+    SensedPed sensed;
+    sensed.pPed = pPed;
+    sensed.x = posW.x;
+    sensed.y = posW.y;
+    sensed.z = posW.z;
+    sensed.isPolice = pPed->type() == PedInstance::kPedTypePolice;
+    list.push_back(sensed);
+}
+
+//! Returns true if the sensed ped is closer than kScoutDistance to the point
+bool PedSensors::isInRange(const SensedPed &sensed, int x, int y, int z) const {
+    int cx = x - sensed.x;
+    int cy = y - sensed.y;
+    int cz = z - sensed.z;
+    return (cx * cx + cy * cy + cz * cz) < kScoutDistance * kScoutDistance;
+}
+
+/*!
+ * Returns what the observer saw during the last update.
+ * \return NULL if the observer was not alive or not in the mission
+ */
+const PedSensors::Sight * PedSensors::sightOf(PedInstance *pObserver) const {
+    size_t id = pObserver->id();
+    if (id >= observers_.size() || observers_[id] != pObserver) {
+        return NULL;
+    }
+    return &sights_[id];
+}
+
+/*!
+ * Return the first ped that has his weapon out and is close to the observer.
+ * \param pObserver The ped who's looking
+ * \param ignorePolice True means police officers are not returned
+ * \return NULL if no ped is found
+ */
+PedInstance * PedSensors::findArmedPed(PedInstance *pObserver, bool ignorePolice) const {
+    const Sight *pSight = sightOf(pObserver);
+    if (pSight == NULL) {
+        return NULL;
+    }
+    return ignorePolice ? pSight->pArmedPedNotPolice : pSight->pArmedPed;
+}
+
+/*!
+ * Return the first living agent of the squad close to the observer.
+ * \param pObserver The ped who's looking
+ * \return NULL if no agent is found
+ */
+PedInstance * PedSensors::findSquadAgent(PedInstance *pObserver) const {
+    const Sight *pSight = sightOf(pObserver);
+    if (pSight == NULL) {
+        return NULL;
+    }
+    return pSight->pAgent;
+}
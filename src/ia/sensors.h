@@ -0,0 +1,93 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef IA_SENSORS_H_
+#define IA_SENSORS_H_
+
+#include <vector>
+
+#include "common.h"
+
+class Mission;
+class PedInstance;
+
+/*!
+ * Sensors are computed once at the beginning of each game tick, before
+ * behaviours are evaluated, and shared by all behaviours. In a single
+ * pass, they find for every living ped the armed peds and squad agents
+ * that are within scout range, so behaviour components only read the
+ * result instead of walking the mission objects each time they scout
+ * their surroundings.
+ */
+class PedSensors {
+public:
+    //! Distance under which a ped sees another ped
+    static const int kScoutDistance = 1500;
+
+    PedSensors();
+
+    //! Computes what every ped sees
+    void update(Mission *pMission);
+    //! Forgets the last computation
+    void clear();
+
+    //! Returns the first armed ped seen by the observer
+    PedInstance * findArmedPed(PedInstance *pObserver, bool ignorePolice) const;
+    //! Returns the first living squad agent seen by the observer
+    PedInstance * findSquadAgent(PedInstance *pObserver) const;
+
+private:
+    /*!
+     * A ped that observers are looking for.
+     */
+    struct SensedPed {
+        PedInstance *pPed;
+        /*! World position of the ped when sensors were computed.*/
+        int x, y, z;
+        bool isPolice;
+    };
+
+    /*!
+     * What a ped sees : for each kind of target, the first one in range.
+     */
+    struct Sight {
+        PedInstance *pArmedPed;
+        PedInstance *pArmedPedNotPolice;
+        PedInstance *pAgent;
+    };
+
+    void addSensedPed(std::vector<SensedPed> &list, PedInstance *pPed);
+    bool isInRange(const SensedPed &sensed, int x, int y, int z) const;
+    const Sight * sightOf(PedInstance *pObserver) const;
+
+private:
+    /*! Armed peds in the order of the mission's list.*/
+    std::vector<SensedPed> armedPeds_;
+    /*! Living agents of the squad.*/
+    std::vector<SensedPed> agents_;
+    /*! What each ped sees, indexed by ped id.*/
+    std::vector<Sight> sights_;
+    /*! For each ped id, the observer whose sight is stored (NULL if none).*/
+    std::vector<PedInstance *> observers_;
+};
+
+#endif // IA_SENSORS_H_
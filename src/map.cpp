@@ -37,11 +37,13 @@ Map::Map(TileManager * tileManager, uint16 anId) : tile_manager_(tileManager)
 {
     id_ = anId;
     a_tiles_ = NULL;
+    a_max_z_ = NULL;
 }
 
 Map::~Map()
 {
     delete[] a_tiles_;
+    delete[] a_max_z_;
 }
 
 bool Map::loadMap(uint8 * mapData)
@@ -55,30 +57,32 @@ bool Map::loadMap(uint8 * mapData)
         ("Map size in tiles: max_x = %d, max_y = %d, max_z = %d.", max_x_, max_y_, max_z_));
 
     uint32 *lookup = new uint32[max_x_ * max_y_];
-    // NOTE : increased map height by 1 to enable range check on higher tiles
-    a_tiles_ = new Tile*[max_x_ * max_y_ * (max_z_ + 1)];
-
     for (int i = 0; i < max_x_ * max_y_; i++)
         lookup[i] = READ_LE_UINT32(mapData + 12 + i * 4);
-    for (int h = 0, z_real = max_z_ + 1; h < max_y_; h++)
+
+    // NOTE : increased map height by 1 to enable range check on higher tiles
+    int data_z = max_z_;
+    max_z_++;
+    // map is stored in bricks of kBrickSize * kBrickSize columns
+    bricks_x_ = (max_x_ + kBrickSize - 1) / kBrickSize;
+    int bricks_y = (max_y_ + kBrickSize - 1) / kBrickSize;
+    a_tiles_ = new Tile*[bricks_x_ * bricks_y * kBrickSize * kBrickSize * max_z_]();
+    a_max_z_ = new int8[max_x_ * max_y_];
+
+    for (int h = 0; h < max_y_; h++)
         for (int w = 0; w < max_x_; w++) {
             int idx = h * max_x_ + w;
+            Tile **column = a_tiles_ + tileIndex(w, h, 0);
 
-            for (int z = 0; z < max_z_; z++) {
+            for (int z = 0; z < data_z; z++) {
                 uint8 tileNum = *(mapData + 12 + lookup[idx] + z);
-                a_tiles_[idx * z_real + z] = tile_manager_->getTile(tileNum);
-
+                column[z] = tile_manager_->getTile(tileNum);
             }
+            column[data_z] = tile_manager_->getTile(0);
+            updateMaxZAt(w, h);
         }
     delete[] lookup;
 
-    max_z_++;
-    for (int h = 0, z = max_z_ - 1; h < max_y_; h++) {
-        for (int w = 0; w < max_x_; w++) {
-            a_tiles_[(h * max_x_ + w) * max_z_ + z] = tile_manager_->getTile(0);
-        }
-    }
-
     map_width_ = (max_x_ + max_y_) * (TILE_WIDTH / 2);
     map_height_ = (max_x_ + max_y_ + max_z_) * TILE_HEIGHT / 3;
     LOG(Log::k_FLG_GFX, "Map", "loadMap",
@@ -89,6 +93,23 @@ bool Map::loadMap(uint8 * mapData)
     return true;
 }
 
+/*!
+ * Computes the height of the given column : the highest tile
+ * that is not transparent.
+ */
+void Map::updateMaxZAt(int x, int y)
+{
+    Tile **column = a_tiles_ + tileIndex(x, y, 0);
+    int mz = -1;
+    for (int z = max_z_ - 1; z >= 0; z--) {
+        if (column[z]->notTransparent()) {
+            mz = z;
+            break;
+        }
+    }
+    a_max_z_[y * max_x_ + x] = mz;
+}
+
 void Map::mapDimensions(int *x, int *y, int *z)
 {
     *x = maxX();
@@ -197,24 +218,17 @@ TilePoint Map::screenToTilePoint(int x, int y)
     return mtp;
 }
 
+/*!
+ * Returns the z of the highest tile that is drawn at the given column.
+ * All tiles above are transparent.
+ * \return -1 if all tiles of the column are transparent
+ */
 int Map::maxZAt(int x, int y)
 {
     assert(x < max_x_);
     assert(y < max_y_);
-    /*
-    int idx = y * max_x_ + x;
-    int mz = 0;
-    for (int z = 0; z < max_z_; z++) {
-        int tile = map_data_[idx * max_z_ + z];
-        if (tile > 5) {
-            mz = z;
-        }
-    }
-    */
-    // TODO: disabling this thing, causes a lot of speed drain
-    // find a better for such optimization, not all objects are drawn
-    // that is why I disabled it
-    return max_z_ - 1;
+
+    return a_max_z_[y * max_x_ + x];
 }
 
 Tile * Map::getTileAt(int x, int y, int z)
@@ -227,7 +241,7 @@ Tile * Map::getTileAt(int x, int y, int z)
         return tile_manager_->getTile(0);
     }
 
-    return a_tiles_[(y * max_x_ + x) * max_z_ + z];
+    return a_tiles_[tileIndex(x, y, z)];
 }
 
 int Map::tileAt(int x, int y, int z)
@@ -239,7 +253,7 @@ int Map::tileAt(int x, int y, int z)
     if (z < 0 || z >= max_z_)
         return 0;
 
-    return a_tiles_[(y * max_x_ + x) * max_z_ + z]->id();
+    return a_tiles_[tileIndex(x, y, z)]->id();
 }
 
 void Map::patchMap(int x, int y, int z, uint8 tileNum)
@@ -247,7 +261,8 @@ void Map::patchMap(int x, int y, int z, uint8 tileNum)
     assert((x >= 0 && x < max_x_)
         && (y >= 0 && y < max_y_)
         && (z >= 0 && z < max_z_));
-    a_tiles_[(y * max_x_ + x) * max_z_ + z] = tile_manager_->getTile(tileNum);
+    a_tiles_[tileIndex(x, y, z)] = tile_manager_->getTile(tileNum);
+    updateMaxZAt(x, y);
 }
 
 
@@ -303,6 +318,22 @@ bool Map::isTileWalkableByCar(int x, int y, int z)
     return  pTile->isRoad();
 }
 
+/*!
+ * Returns the memory used by the map : the object itself and
+ * its array of tiles. Tiles are shared between maps so they're
+ * not counted.
+ */
+size_t Map::memorySize()
+{
+    size_t size = sizeof(Map);
+    if (a_tiles_) {
+        int bricks_y = (max_y_ + kBrickSize - 1) / kBrickSize;
+        size += bricks_x_ * bricks_y * kBrickSize * kBrickSize * max_z_ * sizeof(Tile *);
+        size += max_x_ * max_y_ * sizeof(int8);
+    }
+    return size;
+}
+
 const uint8 MiniMap::kOverlayNone = 0;
 const uint8 MiniMap::kOverlayOurAgent = 1;
 const uint8 MiniMap::kOverlayEnemyAgent = 2;
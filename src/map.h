@@ -35,9 +35,15 @@ class MapObject;
 
 /*!
  * Map class.
+ * Tiles are stored by columns : all tiles of a column (x, y) are
+ * contiguous. Columns are grouped in square bricks so that
+ * neighbour columns (in x and y) are close in memory.
  */
 class Map {
 public:
+    /*! Number of columns on each side of a brick.*/
+    static const int kBrickSize = 8;
+
     Map(TileManager *tileManager, uint16 anId);
     ~Map();
 
@@ -71,12 +77,31 @@ public:
     //! Return true if tile at given position is traversable by car
     bool isTileWalkableByCar(int x, int y, int z);
 
+    //! Returns the memory used by the map in bytes
+    size_t memorySize();
+
+protected:
+    //! Returns the index of the given tile in a_tiles_
+    int tileIndex(int x, int y, int z) {
+        int brick = (y / kBrickSize) * bricks_x_ + x / kBrickSize;
+        int column = brick * kBrickSize * kBrickSize
+            + (y % kBrickSize) * kBrickSize + x % kBrickSize;
+        return column * max_z_ + z;
+    }
+    //! Computes the value returned by maxZAt() for the given column
+    void updateMaxZAt(int x, int y);
+
 protected:
     /*!  Every map has a unique ID which is used to identify the
     name of the file containing map data.*/
     uint16 id_;
     int max_x_, max_y_, max_z_;
+    /*! All the tiles of the map stored by bricks of columns.*/
     Tile **a_tiles_;
+    /*! Number of bricks along x.*/
+    int bricks_x_;
+    /*! For each column, z of the highest tile that is not transparent.*/
+    int8 *a_max_z_;
     TileManager *tile_manager_;
     int map_width_, map_height_;
 };
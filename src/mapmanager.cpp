@@ -30,12 +30,20 @@
 
 MapManager::MapManager()
 {
+    memoryBudget_ = 0;
+    surfacesMemory_ = 0;
+    memoryUsed_ = 0;
+    nbHits_ = 0;
+    nbMisses_ = 0;
+    nbEvictions_ = 0;
 }
 
 MapManager::~MapManager()
 {
-    for (unsigned int i = 0; i < maps_.size(); i++)
-        delete maps_[i];
+    for (std::map<int, Map *>::iterator it = maps_.begin();
+        it != maps_.end(); it++) {
+        delete it->second;
+    }
 }
 
 /*!
@@ -63,6 +71,9 @@ Map * MapManager::loadMap(uint16 i_mapNum)
     // First look in cache
     if (maps_.find(i_mapNum) != maps_.end()) {
         LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("Map is already in cache"));
+        nbHits_++;
+        lru_.remove(i_mapNum);
+        lru_.push_front(i_mapNum);
         return maps_[i_mapNum];
     }
     
@@ -104,9 +115,106 @@ Map * MapManager::loadMap(uint16 i_mapNum)
 
     delete[] mapData;
 
+    nbMisses_++;
+    memoryUsed_ += maps_[i_mapNum]->memorySize();
+    lru_.push_front(i_mapNum);
+    LOG(Log::k_FLG_MEM, "MapManager", "loadMap()", ("map %i uses %u bytes",
+        i_mapNum, (unsigned int) maps_[i_mapNum]->memorySize()));
+    evictMaps(i_mapNum);
+    logStats();
+
     return maps_[i_mapNum];
 }
 
+/*!
+ * Locks the given map : it won't be released from the cache
+ * until unlockMap() is called the same number of times.
+ * \param i_mapNum Map id.
+ */
+void MapManager::lockMap(uint16 i_mapNum)
+{
+    locks_[i_mapNum]++;
+}
+
+/*!
+ * Unlocks the given map so it can be released when memory is needed.
+ * \param i_mapNum Map id.
+ */
+void MapManager::unlockMap(uint16 i_mapNum)
+{
+    std::map<int, int>::iterator it = locks_.find(i_mapNum);
+    if (it != locks_.end()) {
+        it->second--;
+        if (it->second <= 0) {
+            locks_.erase(it);
+        }
+    }
+}
+
+/*!
+ * Releases least recently used maps until the memory used is
+ * under the budget. Locked maps are kept.
+ * \param i_keepNum Id of a map that must be kept (the one just loaded)
+ */
+void MapManager::evictMaps(uint16 i_keepNum)
+{
+    if (memoryBudget_ == 0) {
+        return;
+    }
+
+    std::list<int>::iterator it = lru_.end();
+    while (memoryUsed_ + surfacesMemory_ > memoryBudget_ && it != lru_.begin()) {
+        --it;
+        int mapNum = *it;
+        if (mapNum == i_keepNum || locks_.find(mapNum) != locks_.end()) {
+            continue;
+        }
+
+        Map *pMap = maps_[mapNum];
+        LOG(Log::k_FLG_MEM, "MapManager", "evictMaps()", ("releasing map %i (%u bytes)",
+            mapNum, (unsigned int) pMap->memorySize()));
+        memoryUsed_ -= pMap->memorySize();
+        delete pMap;
+        maps_.erase(mapNum);
+        it = lru_.erase(it);
+        nbEvictions_++;
+    }
+}
+
+/*!
+ * Sets the memory used by the surfaces and flood points of the mission
+ * played on the given map.
+ * \param i_mapNum Map id.
+ * \param bytes Memory used or 0 when the mission is destroyed
+ */
+void MapManager::setSurfacesMemory(uint16 i_mapNum, size_t bytes)
+{
+    std::map<int, size_t>::iterator it = surfaces_.find(i_mapNum);
+    if (it != surfaces_.end()) {
+        surfacesMemory_ -= it->second;
+        surfaces_.erase(it);
+    }
+    if (bytes != 0) {
+        surfaces_[i_mapNum] = bytes;
+        surfacesMemory_ += bytes;
+        LOG(Log::k_FLG_MEM, "MapManager", "setSurfacesMemory()", ("surfaces of map %i use %u bytes",
+            i_mapNum, (unsigned int) bytes));
+        logStats();
+    }
+}
+
+/*!
+ * Logs the memory used by the cache and its statistics.
+ */
+void MapManager::logStats()
+{
+    LOG(Log::k_FLG_MEM, "MapManager", "logStats()",
+        ("%u maps cached, %u + %u surfaces/%u bytes used, %d hits, %d misses, %d evictions",
+        (unsigned int) maps_.size(), (unsigned int) memoryUsed_,
+        (unsigned int) surfacesMemory_, (unsigned int) memoryBudget_,
+        nbHits_, nbMisses_, nbEvictions_));
+}
+
 /*!
  * Returns the map if found in cache.
  * The map must have been loaded first.
@@ -27,12 +27,17 @@
 #define MAPMANAGER_H
 
 #include <map>
+#include <list>
 #include "common.h"
 #include "map.h"
 #include "gfx/tilemanager.h"
 
 /*!
  * Map manager class.
+ * Loaded maps are kept in a cache. When the memory used by the cache
+ * is above the budget, least recently used maps are released unless
+ * they are locked (ie used by a mission). The surfaces computed by a
+ * mission live as long as its map so they are counted in the budget.
  */
 class MapManager {
 public:
@@ -46,9 +51,44 @@ public:
     //! Look in the cache for the map with the given id
     Map *map(int mapNum);
 
+    //! Sets the maximum memory in bytes used by cached maps (0 means no limit)
+    void setMemoryBudget(size_t budget) { memoryBudget_ = budget; }
+    //! Returns the memory in bytes used by cached maps
+    size_t memoryUsed() { return memoryUsed_; }
+    //! Sets the memory used by the surfaces of the mission on the map
+    void setSurfacesMemory(uint16 i_mapNum, size_t bytes);
+    //! Prevents the map from being released
+    void lockMap(uint16 i_mapNum);
+    //! Allows the map to be released
+    void unlockMap(uint16 i_mapNum);
+
+protected:
+    //! Releases least recently used maps until memory is under budget
+    void evictMaps(uint16 i_keepNum);
+    //! Logs the cache content
+    void logStats();
+
 protected:
     std::map<int, Map *> maps_;
+    /*! Map ids ordered from most recently to least recently used.*/
+    std::list<int> lru_;
+    /*! For each map id, number of users preventing the release.*/
+    std::map<int, int> locks_;
     TileManager tileManager_;
+    /*! Maximum memory for cached maps. 0 means no limit.*/
+    size_t memoryBudget_;
+    /*! Current memory used by cached maps.*/
+    size_t memoryUsed_;
+    /*! For each map id, memory used by the surfaces of its mission.*/
+    std::map<int, size_t> surfaces_;
+    /*! Memory used by the surfaces of all missions.*/
+    size_t surfacesMemory_;
+    /*! Number of loadMap() calls served by the cache.*/
+    int nbHits_;
+    /*! Number of loadMap() calls that read a map file.*/
+    int nbMisses_;
+    /*! Number of maps released.*/
+    int nbEvictions_;
 };
 
 #endif
@@ -31,6 +31,9 @@
 #include "model/vehicle.h"
 #include "core/gamesession.h"
 #include "mission.h"
+#include "model/objectivedesc.h"
+#include "missionarena.h"
+#include "utils/blockpool.h"
 
 uint16 SFXObject::sfxIdCnt = 0;
 const int Static::kStaticOrientation1 = 0;
@@ -442,6 +445,24 @@ void MapObject::offzOnStairs(uint8 twd) {
     }
 }
 
+/*!
+ * Sfx objects are short lived : bullet hits, smoke and fire come and go
+ * at every shot.
+ */
+static fs_utils::BlockPool gSfxPool("SFXObject", 128);
+
+void * SFXObject::operator new(size_t size) {
+    return gSfxPool.allocate(size);
+}
+
+void SFXObject::operator delete(void *pBlock, size_t size) {
+    gSfxPool.release(pBlock, size);
+}
+
+void SFXObject::logPoolStats() {
+    gSfxPool.logStats();
+}
+
 /*!
  * Constructor of the class.
  * \param m Map id
@@ -570,6 +591,25 @@ ShootableMapObject::ShootableMapObject(uint16 anId, int m, ObjectNature aNature)
     MapObject(anId, m, aNature)
 {}
 
+/*!
+ * Remove a certain amount of health. When the object dies, objectives
+ * are warned whatever the cause of the death.
+ * \param amount how much to decrease health
+ */
+void ShootableMapObject::decreaseHealth(int amount) {
+    bool wasAlive = health_ > 0;
+    health_ -= amount;
+    if (health_ <= 0) {
+        health_ = 0;
+        if (wasAlive) {
+            Mission *pMission = g_Session.getMission();
+            pMission->signalObjectiveTrigger(kObjTrigDeath);
+            // dead objects don't block lines of sight
+            pMission->invalidateLosAt(position());
+        }
+    }
+}
+
 ShootableMovableMapObject::ShootableMovableMapObject(uint16 anId, int m, ObjectNature aNature):
         ShootableMapObject(anId, m, aNature) {
     speed_ = 0;
@@ -614,7 +654,7 @@ bool ShootableMovableMapObject::addOffsetToPosition(int nOffX, int nOffY)
     return changed;
 }
 
-Static *Static::loadInstance(uint8 * data, uint16 id, int m)
+Static *Static::loadInstance(uint8 * data, uint16 id, int m, MissionArena &arena)
 {
     LevelData::Statics * gamdata =
         (LevelData::Statics *) data;
@@ -631,14 +671,14 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
     switch(gamdata->sub_type) {
         case 0x01:
             // phone booth
-            s = new EtcObj(id, m, curanim, curanim, curanim);
+            s = new (arena, MissionArena::kGroupStatics) EtcObj(id, m, curanim, curanim, curanim);
             s->setSizeX(128);
             s->setSizeY(128);
             s->setSizeZ(128);
             break;
         case 0x05:// 1040-1043, 1044 - damaged
             // crossroad things
-            s = new Semaphore(id, m, 1040, 1044);
+            s = new (arena, MissionArena::kGroupStatics) Semaphore(id, m, 1040, 1044);
             s->setSizeX(48);
             s->setSizeY(48);
             s->setSizeZ(48);
@@ -648,7 +688,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x06:
             // crossroad things
-            s = new Semaphore(id, m, 1040, 1044);
+            s = new (arena, MissionArena::kGroupStatics) Semaphore(id, m, 1040, 1044);
             s->setSizeX(48);
             s->setSizeY(48);
             s->setSizeZ(48);
@@ -658,7 +698,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x07:
             // crossroad things
-            s = new Semaphore(id, m, 1040, 1044);
+            s = new (arena, MissionArena::kGroupStatics) Semaphore(id, m, 1040, 1044);
             s->setSizeX(48);
             s->setSizeY(48);
             s->setSizeZ(48);
@@ -668,7 +708,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x08:
             // crossroad things
-            s = new Semaphore(id, m, 1040, 1044);
+            s = new (arena, MissionArena::kGroupStatics) Semaphore(id, m, 1040, 1044);
             s->setSizeX(48);
             s->setSizeY(48);
             s->setSizeZ(48);
@@ -682,7 +722,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             //printf("0x0B anim %X\n", curanim);
             break;
         case 0x0A:
-            s = new NeonSign(id, m, curanim);
+            s = new (arena, MissionArena::kGroupStatics) NeonSign(id, m, curanim);
             s->setFrame(g_App.gameSprites().getFrameFromFrameIndx(curframe));
             s->setExcludedFromBlockers(true);
             s->setSizeX(32);
@@ -692,14 +732,14 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
         case 0x0C: // closed door
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80
                 || gamdata->orientation == 0x7E || gamdata->orientation == 0xFE) {
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(256);
                 s->setSizeY(1);
                 s->setSizeZ(196);
             } else {
                 baseanim++;
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation2);
                 s->setSizeX(1);
                 s->setSizeY(256);
@@ -709,14 +749,14 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
         case 0x0D: // closed door
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80
                 || gamdata->orientation == 0x7E || gamdata->orientation == 0xFE) {
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(256);
                 s->setSizeY(1);
                 s->setSizeZ(196);
             } else {
                 baseanim++;
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation2);
                 s->setSizeX(1);
                 s->setSizeY(256);
@@ -726,14 +766,14 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
         case 0x0E: // opening doors, not open
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80
                 || gamdata->orientation == 0x7E || gamdata->orientation == 0xFE) {
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(256);
                 s->setSizeY(1);
                 s->setSizeZ(196);
             } else {
                 baseanim++;
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation2);
                 s->setSizeX(1);
                 s->setSizeY(256);
@@ -744,14 +784,14 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
         case 0x0F: // opening doors, not open
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80
                 || gamdata->orientation == 0x7E || gamdata->orientation == 0xFE) {
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(256);
                 s->setSizeY(1);
                 s->setSizeZ(196);
             } else {
                 baseanim++;
-                s = new Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
+                s = new (arena, MissionArena::kGroupStatics) Door(id, m, baseanim, baseanim + 2, baseanim + 4, baseanim + 6);
                 s->setOrientation(kStaticOrientation2);
                 s->setSizeX(1);
                 s->setSizeY(256);
@@ -766,7 +806,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x12:
             // open window
-            s = new WindowObj(id, m, curanim - 2, curanim, curanim + 2, curanim + 4);
+            s = new (arena, MissionArena::kGroupStatics) WindowObj(id, m, curanim - 2, curanim, curanim + 2, curanim + 4);
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80) {
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(96);
@@ -784,7 +824,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x13:
             // closed window
-            s = new WindowObj(id, m, curanim, curanim + 2, curanim + 4, curanim + 6);
+            s = new (arena, MissionArena::kGroupStatics) WindowObj(id, m, curanim, curanim + 2, curanim + 4, curanim + 6);
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80) {
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(96);
@@ -802,7 +842,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x15:
             // damaged window
-            s = new WindowObj(id, m, curanim - 6, curanim - 4, curanim - 2, curanim);
+            s = new (arena, MissionArena::kGroupStatics) WindowObj(id, m, curanim - 6, curanim - 4, curanim - 2, curanim);
             s->setExcludedFromBlockers(true);
             s->setHealth(0);
             s->setStartHealth(1);
@@ -810,7 +850,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x16:
             // TODO: set state if damaged trees exist
-            s = new Tree(id, m, curanim, curanim + 1, curanim + 2);
+            s = new (arena, MissionArena::kGroupStatics) Tree(id, m, curanim, curanim + 1, curanim + 2);
             s->setSizeX(64);
             s->setSizeY(64);
             s->setSizeZ(256);
@@ -819,14 +859,14 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x19:
             // trash bin
-            s = new EtcObj(id, m, curanim, curanim, curanim);
+            s = new (arena, MissionArena::kGroupStatics) EtcObj(id, m, curanim, curanim, curanim);
             s->setSizeX(64);
             s->setSizeY(64);
             s->setSizeZ(96);
             break;
         case 0x1A:
             // mail box
-            s = new EtcObj(id, m, curanim, curanim, curanim);
+            s = new (arena, MissionArena::kGroupStatics) EtcObj(id, m, curanim, curanim, curanim);
             s->setSizeX(64);
             s->setSizeY(64);
             s->setSizeZ(96);
@@ -838,19 +878,19 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
             break;
         case 0x1F:
             // advertisement on wall
-            s = new EtcObj(id, m, curanim, curanim, curanim, smt_Advertisement);
+            s = new (arena, MissionArena::kGroupStatics) EtcObj(id, m, curanim, curanim, curanim, smt_Advertisement);
             s->setExcludedFromBlockers(true);
             break;
 
         case 0x20:
             // window without light
-            s = new AnimWindow(id, m, curanim);
+            s = new (arena, MissionArena::kGroupStatics) AnimWindow(id, m, curanim);
             s->setStateMasks(sttawnd_LightOff);
             s->setTimeShowAnim(30000 + (rand() % 30000));
             break;
         case 0x21:
             // window light turns on
-            s = new AnimWindow(id, m, curanim - 2);
+            s = new (arena, MissionArena::kGroupStatics) AnimWindow(id, m, curanim - 2);
             s->setTimeShowAnim(1000 + (rand() % 1000));
             s->setStateMasks(sttawnd_LightSwitching);
 
@@ -859,18 +899,18 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
         case 0x23:
             // window with person's shadow non animated,
             // even though on 1 map person appears I will ignore it
-            s = new AnimWindow(id, m, 1959 + ((gamdata->orientation & 0x40) >> 5));
+            s = new (arena, MissionArena::kGroupStatics) AnimWindow(id, m, 1959 + ((gamdata->orientation & 0x40) >> 5));
             s->setStateMasks(sttawnd_ShowPed);
             s->setTimeShowAnim(15000 + (rand() % 5000));
             break;
         case 0x24:
             // window with person's shadow, hides, actually animation
             // is of ped standing, but I will ignore it
-            s = new AnimWindow(id, m, 1959 + 8 + ((gamdata->orientation & 0x40) >> 5));
+            s = new (arena, MissionArena::kGroupStatics) AnimWindow(id, m, 1959 + 8 + ((gamdata->orientation & 0x40) >> 5));
             s->setStateMasks(sttawnd_PedDisappears);
             break;
         case 0x25:
-            s = new AnimWindow(id, m, curanim);
+            s = new (arena, MissionArena::kGroupStatics) AnimWindow(id, m, curanim);
 
             // NOTE : orientation, I assume, plays role of hidding object,
             // orientation 0x40, 0x80 are drawn (gamdata->desc always 7)
@@ -886,7 +926,7 @@ Static *Static::loadInstance(uint8 * data, uint16 id, int m)
         case 0x26:
             // 0x00,0x80 south - north = 0
             // 0x40,0xC0 weast - east = 2
-            s = new LargeDoor(id, m, curanim, curanim + 1, curanim + 2);
+            s = new (arena, MissionArena::kGroupStatics) LargeDoor(id, m, curanim, curanim + 1, curanim + 2);
             if (gamdata->orientation == 0x00 || gamdata->orientation == 0x80) {
                 s->setOrientation(kStaticOrientation1);
                 s->setSizeX(384);
@@ -949,6 +989,7 @@ void Door::draw(int x, int y)
 
 bool Door::animate(int elapsed, Mission *obj)
 {
+    bool wasExcluded = isExcludedFromBlockers();
     PedInstance *p = NULL;
     int x = tileX();
     int y = tileY();
@@ -1055,6 +1096,10 @@ bool Door::animate(int elapsed, Mission *obj)
             }
             break;
     }
+    if (wasExcluded != isExcludedFromBlockers()) {
+        // door has opened or closed : lines of sight have changed
+        obj->invalidateLosAt(position());
+    }
     return changed;
 }
 
@@ -1090,6 +1135,7 @@ void LargeDoor::draw(int x, int y)
 
 bool LargeDoor::animate(int elapsed, Mission *obj)
 {
+    bool wasExcluded = isExcludedFromBlockers();
     // TODO: there must be somewhere locked door
     GenericCar *v = NULL;
     PedInstance *p = NULL;
@@ -1414,6 +1460,10 @@ bool LargeDoor::animate(int elapsed, Mission *obj)
     }
     if (cur_state != state_)
         frame_ = 0;
+    if (wasExcluded != isExcludedFromBlockers()) {
+        // door has opened or closed : lines of sight have changed
+        obj->invalidateLosAt(position());
+    }
     return changed;
 }
 
@@ -1511,6 +1561,8 @@ void WindowObj::handleHit(fs_dmg::DamageToInflict &d) {
             setExcludedFromBlockers(true);
             frame_ = 0;
             setFramesPerSec(6);
+            // shots can now go through the window
+            g_Session.getMission()->invalidateLosAt(position());
         }
     }
 }
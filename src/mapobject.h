@@ -36,6 +36,7 @@
 #include "pathsurfaces.h"
 
 class Mission;
+class MissionArena;
 class WeaponInstance;
 
 /*!
@@ -245,6 +246,8 @@ public:
     void setDirectionTowardPosition(const WorldPoint &pos);
 
     int direction() { return dir_;}
+    //! Returns the current frame of the animation
+    int frame() { return frame_; }
     int getDirection(int snum = 8);
 
     void setTimeShowAnim(int t) {
@@ -336,6 +339,13 @@ public:
     SFXObject(int m, SfxTypeEnum type, int t_show = 0, bool managed = false);
     virtual ~SFXObject() {}
 
+    //! Sfx objects are allocated from a pool of recycled blocks
+    static void * operator new(size_t size);
+    //! Gives the block back to the pool
+    static void operator delete(void *pBlock, size_t size);
+    //! Logs allocation counters of the pool
+    static void logPoolStats();
+
     bool sfxLifeOver() { return sfx_life_over_; }
     //! Return true if object is managed by another object
     bool isManaged() { return managed_; }
@@ -416,15 +426,8 @@ public:
         return health_ == start_health_;
     }
 
-    /*!
-     * Remove a certain amount of health.
-     */
-    void decreaseHealth(int amount) {
-        health_ -= amount;
-        if (health_ <= 0) {
-            health_ = 0;
-        }
-    }
+    //! Remove a certain amount of health
+    void decreaseHealth(int amount);
     /*!
      * Reset current ped's health to starting health.
      */
@@ -572,7 +575,7 @@ public:
         sttawnd_LightOn
     };
 public:
-    static Static *loadInstance(uint8 *data, uint16 id, int m);
+    static Static *loadInstance(uint8 *data, uint16 id, int m, MissionArena &arena);
     virtual ~Static() {}
 
     //! Return the type of statics
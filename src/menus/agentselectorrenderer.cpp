@@ -134,6 +134,19 @@ void AgentSelectorRenderer::drawIPABar(int agent, IPAStim *stim)
  */
 void AgentSelectorRenderer::drawSelectorForAgent(size_t agentSlot,
     PedInstance *pAgent, bool isSelected)
+{
+    renderSelector(agentSlot, pAgent, isSelected);
+    renderIpaMeters(agentSlot, pAgent, isSelected);
+}
+
+/*!
+ * Draw the part of the selector with the agent's animation and health.
+ * \param agentSlot
+ * \param pAgent
+ * \param isSelected
+ */
+void AgentSelectorRenderer::renderSelector(size_t agentSlot,
+    PedInstance *pAgent, bool isSelected)
 {
     // parity check
     int topX = (agentSlot & 0x01) * 64;
@@ -145,8 +158,6 @@ void AgentSelectorRenderer::drawSelectorForAgent(size_t agentSlot,
     // Draw the background of selector
     g_App.gameSprites().sprite(isSelected ? spriteSelected : springUnselected)->draw(
             topX, topY, 0);
-    g_App.gameSprites().sprite(isSelected ? 1778 : 1754)->draw(
-            topX, topY + 46, 0);
 
     if (pAgent) {
         // draw health bar
@@ -156,12 +167,70 @@ void AgentSelectorRenderer::drawSelectorForAgent(size_t agentSlot,
 
         //draw animation within selectors
         pAgent->drawSelectorAnim(topX + 32, topY + 38);
+    }
+}
 
-        // draw IPA, for alive only agents
-        if (pAgent->isAlive()) {
-            drawIPABar(agentSlot, pAgent->adrenaline_);
-            drawIPABar(agentSlot, pAgent->perception_);
-            drawIPABar(agentSlot, pAgent->intelligence_);
+/*!
+ * Draw the part of the selector below the agent with the IPA meters.
+ * \param agentSlot
+ * \param pAgent
+ * \param isSelected
+ */
+void AgentSelectorRenderer::renderIpaMeters(size_t agentSlot,
+    PedInstance *pAgent, bool isSelected)
+{
+    int topX = (agentSlot & 0x01) * 64;
+    int topY = (agentSlot >> 1) * (46 + 44 + 10);
+
+    g_App.gameSprites().sprite(isSelected ? 1778 : 1754)->draw(
+            topX, topY + 46, 0);
+
+    // draw IPA, for alive only agents
+    if (pAgent && pAgent->isAlive()) {
+        drawIPABar(agentSlot, pAgent->adrenaline_);
+        drawIPABar(agentSlot, pAgent->perception_);
+        drawIPABar(agentSlot, pAgent->intelligence_);
+    }
+}
+
+/*!
+ * The selector shows the animation of the agent, so the state holds
+ * everything used to choose the frame.
+ * \param pAgent Agent in the slot (can be NULL)
+ * \param isSelected True if agent is selected
+ * \param state Cleared and filled with the displayed values
+ */
+void AgentSelectorRenderer::selectorState(PedInstance *pAgent,
+    bool isSelected, std::vector<int> &state)
+{
+    state.clear();
+    state.push_back(isSelected ? 1 : 0);
+    if (pAgent) {
+        state.push_back(36 * pAgent->health() / pAgent->startHealth());
+        state.push_back(pAgent->drawnAnim());
+        state.push_back(pAgent->frame());
+        state.push_back(pAgent->getDirection());
+        state.push_back(pAgent->selectedWeapon() ?
+            pAgent->selectedWeapon()->index() : Weapon::Unarmed_Anim);
+    }
+}
+
+/*!
+ * \param pAgent Agent in the slot (can be NULL)
+ * \param isSelected True if agent is selected
+ * \param state Cleared and filled with the displayed values
+ */
+void AgentSelectorRenderer::ipaMetersState(PedInstance *pAgent,
+    bool isSelected, std::vector<int> &state)
+{
+    state.clear();
+    state.push_back(isSelected ? 1 : 0);
+    if (pAgent && pAgent->isAlive()) {
+        IPAStim *stims[] = {pAgent->adrenaline_, pAgent->perception_, pAgent->intelligence_};
+        for (int i = 0; i < 3; ++i) {
+            state.push_back(stims[i]->getAmount());
+            state.push_back(stims[i]->getEffect());
+            state.push_back(stims[i]->getDependency());
         }
     }
 }
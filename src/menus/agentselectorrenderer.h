@@ -23,6 +23,8 @@
 #ifndef MENUS_AGENTSELECTORRENDERER_H_
 #define MENUS_AGENTSELECTORRENDERER_H_
 
+#include <vector>
+
 #include "ipastim.h"
 #include "menus/squadselection.h"
 
@@ -62,6 +64,14 @@ public:
     bool hasClickedOnAgentSelector(int x, int y, SelectorEvent & evt);
     //! Renders the agent's selectors
     void render(SquadSelection & selection, Squad * pSquad);
+    //! Renders the upper part of the selector of one agent
+    void renderSelector(size_t agentSlot, PedInstance *pAgent, bool isSelected);
+    //! Renders the IPA meters of one agent
+    void renderIpaMeters(size_t agentSlot, PedInstance *pAgent, bool isSelected);
+    //! Fills state with what renderSelector() would display
+    void selectorState(PedInstance *pAgent, bool isSelected, std::vector<int> &state);
+    //! Fills state with what renderIpaMeters() would display
+    void ipaMetersState(PedInstance *pAgent, bool isSelected, std::vector<int> &state);
 
 private:
     static const int kIpaBarWidth;
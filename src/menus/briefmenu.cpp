@@ -130,6 +130,8 @@ void BriefMenu::handleShow() {
     // Loads mission briefing
     p_briefing_ = g_gameCtrl.missions().loadBriefing(cur_miss);
     assert(p_briefing_ != NULL);
+    // Prepare the mission while the player reads the briefing
+    g_gameCtrl.missions().preloadMission(cur_miss);
 
     start_line_ = 0;
     getOption(prevButId_)->setVisible(false);
@@ -192,7 +192,7 @@ void DebriefMenu::handleLeave() {
 void DebriefMenu::handleGameEvent(GameEvent evt) {
     if (evt.type == GameEvent::kResearch) {
         // A research has ended, so check which type
-        Research *pRes = static_cast<Research *> (evt.pCtxt);
+        Research *pRes = evt.pResearch;
          // Is it equipment or mods research?
          if (pRes->getType() == Research::EQUIPS) {
              // Get researched weapon type
@@ -27,6 +27,7 @@
  ************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include "app.h"
 #include "gameplaymenu.h"
@@ -63,9 +64,117 @@ mm_renderer_(), warningTimer_(20000)
     scroll_y_ = 0;
     ipa_chng_.ipa_chng = -1;
     canPlayPoliceWarnSound_ = true;
+    hintColor_ = 0;
+    hintBar_ = false;
+    initRegions();
     g_gameCtrl.addListener(this, GameEvent::kMission);
 }
 
+/*!
+ * The control panel is on the left of the screen and the map fills the
+ * rest. The regions of the panel follow the layout of its sprites.
+ */
+void GameplayMenu::initRegions() {
+    ScreenRegion *r = &regions_[kRegionMap];
+    r->x = Screen::kScreenPanelWidth;
+    r->y = 0;
+    r->width = GAME_SCREEN_WIDTH - Screen::kScreenPanelWidth;
+    r->height = GAME_SCREEN_HEIGHT;
+
+    for (int a = 0; a < 4; a++) {
+        r = &regions_[kRegionSelector + a];
+        r->x = (a % 2) * 64;
+        r->y = (a / 2) * (46 + 44 + 10);
+        r->width = 64;
+        r->height = 46;
+
+        r = &regions_[kRegionIpa + a];
+        r->x = (a % 2) * 64;
+        r->y = (a / 2) * (46 + 44 + 10) + 46;
+        r->width = 64;
+        r->height = 44;
+    }
+
+    r = &regions_[kRegionSelectAll];
+    r->x = 0;
+    r->y = 46 + 44;
+    r->width = 128;
+    r->height = 10;
+
+    // hint background starts one line over the lower IPA meters
+    r = &regions_[kRegionHint];
+    r->x = 0;
+    r->y = 46 + 44 + 10 + 46 + 44 - 1;
+    r->width = 128;
+    r->height = 18;
+
+    r = &regions_[kRegionWeapons];
+    r->x = 0;
+    r->y = 2 + 46 + 44 + 10 + 46 + 44 + 15;
+    r->width = 128;
+    r->height = 64;
+
+    r = &regions_[kRegionMinimap];
+    r->x = kMiniMapScreenX;
+    r->y = kMiniMapScreenY;
+    r->width = 128;
+    r->height = 128;
+
+    panelCache_.assign(Screen::kScreenPanelWidth * GAME_SCREEN_HEIGHT, 0);
+}
+
+void GameplayMenu::invalidateRegion(int region) {
+    ScreenRegion &r = regions_[region];
+    addDirtyRect(r.x, r.y, r.width, r.height);
+}
+
+void GameplayMenu::invalidateRegionIfChanged(int region,
+    const std::vector<int> &state) {
+    ScreenRegion &r = regions_[region];
+    if (r.state != state) {
+        r.state = state;
+        addDirtyRect(r.x, r.y, r.width, r.height);
+    }
+}
+
+/*!
+ * Compares what each region of the panel displays with what the game
+ * state would make it display now.
+ */
+void GameplayMenu::invalidateChangedPanelRegions() {
+    for (size_t a = 0; a < AgentManager::kMaxSlot; a++) {
+        PedInstance *pAgent = mission_->getSquad()->member(a);
+        bool isSelected = selection_.isAgentSelected(a);
+
+        agt_sel_renderer_.selectorState(pAgent, isSelected, regionState_);
+        invalidateRegionIfChanged(kRegionSelector + a, regionState_);
+        agt_sel_renderer_.ipaMetersState(pAgent, isSelected, regionState_);
+        invalidateRegionIfChanged(kRegionIpa + a, regionState_);
+    }
+
+    regionState_.clear();
+    regionState_.push_back(isButtonSelectAllPressed_ ? 1 : 0);
+    invalidateRegionIfChanged(kRegionSelectAll, regionState_);
+
+    weaponSelectorsState(regionState_);
+    invalidateRegionIfChanged(kRegionWeapons, regionState_);
+}
+
+/*!
+ * DirtyList::intersectsList() also matches rects that only touch, so the
+ * test is made on the inside of the region not to redraw its neighbours.
+ * \return True if the region must be drawn.
+ */
+bool GameplayMenu::prepareRegion(DirtyList &dirtyList, int region) {
+    ScreenRegion &r = regions_[region];
+    if (!dirtyList.intersectsList(r.x + 1, r.y + 1, r.width - 2, r.height - 2)) {
+        return false;
+    }
+
+    g_Screen.drawRect(r.x, r.y, r.width, r.height, 0);
+    return true;
+}
+
 /*!
  * Scroll the map horizontally.
  * Each map has a min and max value for the world origin coords and this
@@ -307,6 +416,10 @@ void GameplayMenu::handleShow() {
     centerMinimapOnLeader();
     isPlayerShooting_ = false;
 
+    ai_scheduler_.reset();
+    ai_scheduler_.setBudget(g_Ctx.getAiBudget());
+    behaviour_runner_.start(g_Ctx.getAiThreads());
+
     // Change cursor to game cursor
     g_System.usePointerCursor();
     g_System.showCursor();
@@ -354,22 +467,34 @@ void GameplayMenu::handleTick(int elapsed)
     if (tick_count_ - last_animate_tick_ > 33) {
         int diff = tick_count_ - last_animate_tick_;
         last_animate_tick_ = tick_count_;
+        // objects will move so previous line of sight checks are obsolete
+        mission_->clearLosCache();
+        // behaviours will look at this snapshot instead of scanning peds
+        mission_->sensors().update(mission_);
+        ai_scheduler_.schedule(mission_, displayOriginPt_.x, displayOriginPt_.y);
+        // peds evaluate their behaviour, in parallel if possible, then
+        // apply it in peds order before anyone moves
+        behaviour_runner_.run(mission_, diff);
 
         for (size_t i = 0; i < mission_->numSfxObjects(); i++) {
-            SFXObject *pSfx = mission_->sfxObjects(i);
-            change |= pSfx->animate(diff);
-            if (pSfx->sfxLifeOver()) {
-                mission_->delSfxObject(i);
-                i--;
-            }
+            change |= mission_->sfxObjects(i)->animate(diff);
         }
+        mission_->removeDeadSfxObjects();
 
-        for (size_t i = 0; i < mission_->numPeds(); i++)
-            change |= mission_->ped(i)->animate(diff, mission_);
-
+        // peds and vehicles are blockers for the next lines of sight
+        for (size_t i = 0; i < mission_->numPeds(); i++) {
+            PedInstance *pPed = mission_->ped(i);
+            TilePoint before(pPed->position());
+            change |= pPed->animate(diff, mission_);
+            invalidateLosIfMoved(before, pPed);
+        }
 
-        for (size_t i = 0; i < mission_->numVehicles(); i++)
-            change |= mission_->vehicle(i)->animate(diff);
+        for (size_t i = 0; i < mission_->numVehicles(); i++) {
+            Vehicle *pVehicle = mission_->vehicle(i);
+            TilePoint before(pVehicle->position());
+            change |= pVehicle->animate(diff);
+            invalidateLosIfMoved(before, pVehicle);
+        }
 
         for (size_t i = 0; i < mission_->numWeaponsOnGround(); i++)
             change |= mission_->weaponOnGround(i)->animate(diff);
@@ -379,38 +504,82 @@ void GameplayMenu::handleTick(int elapsed)
 
         for (size_t i = 0; i < mission_->numPrjShots(); i++) {
             change |= mission_->prjShots(i)->animate(diff, mission_);
-            if (mission_->prjShots(i)->isLifeOver()) {
-                mission_->delPrjShot(i);
-                i--;
-            }
         }
+        mission_->removeDeadPrjShots();
+        mission_->clearLosCache();
 
         updateMarkersPosition();
     }
 
-    updateMinimap(elapsed);
+    // listeners react once everything has moved
+    g_gameCtrl.dispatchMissionEvents();
+    // play the sounds emitted during this tick
+    g_App.gameSounds().flushQueue(displayOriginPt_.x, displayOriginPt_.y);
+
+    bool minimapChange = updateMinimap(elapsed);
 
     updateIPALevelMeters(elapsed);
 
     if (change) {
-        needRendering();
+        invalidateRegion(kRegionMap);
         // force target to update
         handleMouseMotion(last_motion_x_, last_motion_y_, 0, KMD_NONE);
     }
 
-    drawMissionHint(elapsed);
+    if (change || minimapChange) {
+        invalidateRegion(kRegionMinimap);
+    }
+
+    updateMissionHint(elapsed);
+    invalidateChangedPanelRegions();
 }
 
 void GameplayMenu::handleRender(DirtyList &dirtyList)
 {
-    g_Screen.clear(0);
-    map_renderer_.render(displayOriginPt_);
-    g_Screen.drawRect(0,0, 129, GAME_SCREEN_HEIGHT);
-    agt_sel_renderer_.render(selection_, mission_->getSquad());
-    drawSelectAllButton();
-    drawMissionHint(0);
-    drawWeaponSelectors();
-    mm_renderer_.render(kMiniMapScreenX, kMiniMapScreenY);
+    if (prepareRegion(dirtyList, kRegionMap)) {
+        map_renderer_.render(displayOriginPt_);
+        g_Screen.copyRect(0, 0, Screen::kScreenPanelWidth, GAME_SCREEN_HEIGHT,
+            &panelCache_[0]);
+    }
+
+    bool panelChanged = false;
+    for (size_t a = 0; a < AgentManager::kMaxSlot; a++) {
+        PedInstance *pAgent = mission_->getSquad()->member(a);
+        bool isSelected = selection_.isAgentSelected(a);
+
+        if (prepareRegion(dirtyList, kRegionSelector + a)) {
+            agt_sel_renderer_.renderSelector(a, pAgent, isSelected);
+            panelChanged = true;
+        }
+        if (prepareRegion(dirtyList, kRegionIpa + a)) {
+            agt_sel_renderer_.renderIpaMeters(a, pAgent, isSelected);
+            panelChanged = true;
+        }
+    }
+    if (prepareRegion(dirtyList, kRegionSelectAll)) {
+        drawSelectAllButton();
+        panelChanged = true;
+    }
+    if (prepareRegion(dirtyList, kRegionHint)) {
+        drawMissionHint();
+        panelChanged = true;
+    }
+    if (prepareRegion(dirtyList, kRegionWeapons)) {
+        drawWeaponSelectors();
+        panelChanged = true;
+    }
+    if (prepareRegion(dirtyList, kRegionMinimap)) {
+        mm_renderer_.render(kMiniMapScreenX, kMiniMapScreenY);
+        panelChanged = true;
+    }
+
+    if (panelChanged) {
+        const uint8 *pixels = g_Screen.pixels();
+        for (int j = 0; j < GAME_SCREEN_HEIGHT; j++) {
+            memcpy(&panelCache_[j * Screen::kScreenPanelWidth],
+                pixels + j * g_Screen.gameScreenWidth(), Screen::kScreenPanelWidth);
+        }
+    }
 
 #ifdef _DEBUG
     // drawing of different sprites
@@ -477,7 +646,15 @@ void GameplayMenu::handleLeave()
     g_System.hideCursor();
     menu_manager_->setDefaultPalette();
     mission_->end();
+    // events refer to peds and objectives of the mission
+    g_gameCtrl.clearPendingEvents();
+    g_App.gameSounds().clearQueue();
     selection_.clear();
+    ai_scheduler_.logStats();
+    Action::logPoolStats();
+    SFXObject::logPoolStats();
+    ProjectileShot::logPoolStats();
+    behaviour_runner_.stop();
 
     tick_count_ = 0;
     last_animate_tick_ = 0;
@@ -1149,22 +1326,23 @@ void GameplayMenu::drawSelectAllButton() {
     }
 }
 
-void GameplayMenu::drawMissionHint(int elapsed) {
+/*!
+ * The hint alternates between the squad activity and the mission
+ * objective. Only a change of text or color invalidates its region.
+ * \param elapsed Time since last tick
+ */
+void GameplayMenu::updateMissionHint(int elapsed) {
 
     elapsed += mission_hint_ticks_;
     int inc = elapsed / 45;
     mission_hint_ticks_ = elapsed % 45;
 
-    g_App.gameSprites().sprite(1798)->draw(
-        0, 46 + 44 + 10 + 46 + 44 - 1, 0);
-    g_App.gameSprites().sprite(1799)->draw(
-        64, 46 + 44 + 10 + 46 + 44 - 1, 0);
-
     mission_hint_ += inc;
 
     bool inversed = false;
     bool text_pw = (target_ && target_->nature() == MapObject::kNatureWeapon
         && target_->map() != -1);
+    bool bar = false;
 
     std::string str;
 
@@ -1191,7 +1369,7 @@ void GameplayMenu::drawMissionHint(int elapsed) {
 
         if (mission_hint_ > 79) {
             mission_hint_ = 0;
-            return;
+            str.clear();
         }
     } else {
 
@@ -1218,7 +1396,7 @@ void GameplayMenu::drawMissionHint(int elapsed) {
         }
 
         if (inversed && !text_pw) {
-            g_Screen.drawRect(0, 46 + 44 + 10 + 46 + 44, 128, 12, 11);
+            bar = true;
         } else {
             if (text_pw) {
                 str = ((WeaponInstance *)target_)->name();
@@ -1227,77 +1405,103 @@ void GameplayMenu::drawMissionHint(int elapsed) {
         }
     }
 
-    int width = gameFont()->textWidth(str.c_str(), false, false);
-    int x = 64 - width / 2;
-    gameFont()->drawText(x, 46 + 44 + 10 + 46 + 44 + 2 - 1, str.c_str(), txtColor);
+    if (str != hintText_ || txtColor != hintColor_ || bar != hintBar_) {
+        hintText_ = str;
+        hintColor_ = txtColor;
+        hintBar_ = bar;
+        invalidateRegion(kRegionHint);
+    }
 }
 
-void GameplayMenu::drawWeaponSelectors() {
-    PedInstance *p = NULL;
-
-    p = selection_.leader();
-
-    if (p) {
-        bool draw_pw = true;
-        for (int j = 0; j < 2; j++) {
-            for (int i = 0; i < 4; i++) {
-                WeaponInstance *wi = NULL;
-                int s = 1601;
-                // NOTE: weapon selectors can be drawn by drawFrame instead
-                // of using current draw(), animations are folowing:
-                // 285,286 empty selector :: 287 persuadatron 289
-                // 291 pistol 293 :: 295 gauss gun 297 :: 299 shotgun 301
-                // 303 uzi 305 :: 307 minigun 309 :: 311 laser gun 313
-                // 315 flamer 317 :: 319 long range 321 :: 323 scanner 325
-                // 327 medikit 329 :: 331 time bomb 333 :: 343 access card 345
-                // 351 energy shield 353
-
-                if (i + j * 4 < p->numWeapons()) {
-                    wi = p->weapon(i + j * 4);
-                    s = wi->getClass()->selector();
-                    if (p->selectedWeapon() && p->selectedWeapon() == wi)
-                        s += 40;
-                } else if (draw_pw) {
-                    if (target_ && target_->nature() == MapObject::kNatureWeapon
-                        && (mission_hint_ % 20) < 10
-                        && target_->map() != -1)
-                    {
-                        // player is pointing a weapon on the ground and there's space
-                        // in the inventory to display its icon
-                        wi = (WeaponInstance *)target_;
-                        draw_pw = false;
-                        s = wi->getClass()->selector() + 40;
-                    }
-                }
+void GameplayMenu::drawMissionHint() {
+    g_App.gameSprites().sprite(1798)->draw(
+        0, 46 + 44 + 10 + 46 + 44 - 1, 0);
+    g_App.gameSprites().sprite(1799)->draw(
+        64, 46 + 44 + 10 + 46 + 44 - 1, 0);
 
-                g_App.gameSprites().sprite(s)->draw(
-                        32 * i, 2 + 46 + 44 + 10 + 46 + 44 + 15 + j * 32, 0);
+    if (hintBar_) {
+        g_Screen.drawRect(0, 46 + 44 + 10 + 46 + 44, 128, 12, 11);
+    }
 
-                // draw ammo bars
-                if (wi) {
-                    int n;
+    if (hintText_.empty()) {
+        return;
+    }
 
-                    if (wi->ammo() == -1)
-                        continue;
-                    if (wi->ammo() == 0)
-                        n = 25;
-                    else
-                        n = 25 * wi->ammoRemaining() / wi->ammo();
+    int width = gameFont()->textWidth(hintText_.c_str(), false, false);
+    int x = 64 - width / 2;
+    gameFont()->drawText(x, 46 + 44 + 10 + 46 + 44 + 2 - 1, hintText_.c_str(), hintColor_);
+}
 
-                    g_Screen.drawRect(32 * i + 3, 46 + 44 + 10 + 46 + 44 + 15 + j * 32 + 23 + 2,
-                        n, 5, 12);
+/*!
+ * For each of the 8 selectors, the state holds the sprite to draw and the
+ * length of the ammo bar (-1 if no bar).
+ * \param state Cleared and filled with the selectors
+ */
+void GameplayMenu::weaponSelectorsState(std::vector<int> &state) {
+    PedInstance *p = selection_.leader();
+    bool draw_pw = true;
+
+    state.clear();
+    for (int n = 0; n < 8; n++) {
+        WeaponInstance *wi = NULL;
+        int s = 1601;
+        int bar = -1;
+
+        if (p) {
+            if (n < p->numWeapons()) {
+                wi = p->weapon(n);
+                s = wi->getClass()->selector();
+                if (p->selectedWeapon() && p->selectedWeapon() == wi)
+                    s += 40;
+            } else if (draw_pw) {
+                if (target_ && target_->nature() == MapObject::kNatureWeapon
+                    && (mission_hint_ % 20) < 10
+                    && target_->map() != -1)
+                {
+                    // player is pointing a weapon on the ground and there's space
+                    // in the inventory to display its icon
+                    wi = (WeaponInstance *)target_;
+                    draw_pw = false;
+                    s = wi->getClass()->selector() + 40;
                 }
             }
-        }
-    } else {
-        for (int j = 0; j < 2; j++)
-            for (int i = 0; i < 4; i++) {
-                int s = 1601;
 
-                g_App.gameSprites().sprite(s)->draw(
-                        32 * i, 2 + 46 + 44 + 10 + 46 + 44 + 15 + j * 32, 0);
+            // ammo bars
+            if (wi && wi->ammo() != -1) {
+                if (wi->ammo() == 0)
+                    bar = 25;
+                else
+                    bar = 25 * wi->ammoRemaining() / wi->ammo();
             }
+        }
 
+        state.push_back(s);
+        state.push_back(bar);
+    }
+}
+
+void GameplayMenu::drawWeaponSelectors() {
+    // NOTE: weapon selectors can be drawn by drawFrame instead
+    // of using current draw(), animations are folowing:
+    // 285,286 empty selector :: 287 persuadatron 289
+    // 291 pistol 293 :: 295 gauss gun 297 :: 299 shotgun 301
+    // 303 uzi 305 :: 307 minigun 309 :: 311 laser gun 313
+    // 315 flamer 317 :: 319 long range 321 :: 323 scanner 325
+    // 327 medikit 329 :: 331 time bomb 333 :: 343 access card 345
+    // 351 energy shield 353
+    weaponSelectorsState(regionState_);
+
+    for (int n = 0; n < 8; n++) {
+        int i = n % 4;
+        int j = n / 4;
+
+        g_App.gameSprites().sprite(regionState_[2 * n])->draw(
+                32 * i, 2 + 46 + 44 + 10 + 46 + 44 + 15 + j * 32, 0);
+
+        if (regionState_[2 * n + 1] != -1) {
+            g_Screen.drawRect(32 * i + 3, 46 + 44 + 10 + 46 + 44 + 15 + j * 32 + 23 + 2,
+                regionState_[2 * n + 1], 5, 12);
+        }
     }
 }
 
@@ -1349,6 +1553,22 @@ void GameplayMenu::highlightLeaderMarker()
     }
 }
 
+/*!
+ * Makes cached lines of sight around the old and new positions obsolete
+ * if the given object has moved since its position was saved, as it may
+ * block or free some of them.
+ * \param before Position of the object before it was animated
+ * \param pObject The object
+ */
+void GameplayMenu::invalidateLosIfMoved(const TilePoint &before, MapObject *pObject) {
+    const TilePoint &after = pObject->position();
+    if (before.tx != after.tx || before.ty != after.ty || before.tz != after.tz
+            || before.ox != after.ox || before.oy != after.oy || before.oz != after.oz) {
+        mission_->invalidateLosAt(before);
+        mission_->invalidateLosAt(after);
+    }
+}
+
 /**
  * Updating position for visual markers for all agents.
  * \return void
@@ -1408,9 +1628,9 @@ void GameplayMenu::centerMinimapOnLeader() {
 /*!
  * Updates the minimap.
  */
-void GameplayMenu::updateMinimap(int elapsed) {
+bool GameplayMenu::updateMinimap(int elapsed) {
     centerMinimapOnLeader();
-    mm_renderer_.handleTick(elapsed);
+    return mm_renderer_.handleTick(elapsed);
 }
 
 /*!
@@ -1459,30 +1679,25 @@ void GameplayMenu::handleGameEvent(GameEvent evt) {
         if (mission_->getSquad()->isAllDead()) {
             mission_->endWithStatus(Mission::kMissionStatusFailed);
             // clear signal on minimap
-            GameEvent sigEvt;
-            sigEvt.type = GameEvent::kObjFailed;
+            GameEvent sigEvt(GameEvent::kMission, GameEvent::kObjFailed);
             mm_renderer_.handleGameEvent(sigEvt);
         }
 
         // Anyway update selection
-        PedInstance *p_ped = static_cast<PedInstance *> (evt.pCtxt);
+        PedInstance *p_ped = evt.pPed;
         updateSelectionForDeadAgent(p_ped);
-    } else if (evt.type == GameEvent::kEvtShootingWeaponSelected) {
-        PedInstance *pPedSource = static_cast<PedInstance *> (evt.pCtxt);
-        mission_->addArmedPed(pPedSource);
+    } else if (evt.type == GameEvent::kEvtArmedPedsChanged) {
+        // peds have already been added to or removed from the armed peds.
+        // Each ped is told once whatever the number of peds in the list.
+        const ArmedPedsChanges *pChanges = evt.pArmedChanges;
+        void *pCtxt = const_cast<ArmedPedsChanges *> (pChanges);
         for (size_t i = 0; i < mission_->numPeds(); i++) {
             PedInstance *pPed = mission_->ped(i);
-            if (pPed != pPedSource) {
-                pPed->behaviour().handleBehaviourEvent(Behaviour::kBehvEvtWeaponOut, pPedSource);
+            if (pChanges->hasChange(true, pPed)) {
+                pPed->behaviour().handleBehaviourEvent(Behaviour::kBehvEvtWeaponOut, pCtxt);
             }
-        }
-    } else if (evt.type == GameEvent::kEvtShootingWeaponDeselected) {
-        PedInstance *pPedSource = static_cast<PedInstance *> (evt.pCtxt);
-        mission_->removeArmedPed(pPedSource);
-        for (size_t i = 0; i < mission_->numPeds(); i++) {
-            PedInstance *pPed = mission_->ped(i);
-            if (pPed != pPedSource) {
-                pPed->behaviour().handleBehaviourEvent(Behaviour::kBehvEvtWeaponCleared, pPedSource);
+            if (pChanges->hasChange(false, pPed)) {
+                pPed->behaviour().handleBehaviourEvent(Behaviour::kBehvEvtWeaponCleared, pCtxt);
             }
         }
     } else if (evt.type == GameEvent::kEvtWarnAgent) {
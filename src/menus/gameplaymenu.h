@@ -27,11 +27,16 @@
 #ifndef GAMEPLAYMENU_H
 #define GAMEPLAYMENU_H
 
+#include <string>
+#include <vector>
+
 #include "agentselectorrenderer.h"
 #include "maprenderer.h"
 #include "minimaprenderer.h"
 #include "squadselection.h"
 #include "core/gameevent.h"
+#include "ia/aischeduler.h"
+#include "ia/behaviourrunner.h"
 
 class Mission;
 class IPAStim;
@@ -67,8 +72,22 @@ protected:
     void handleClickOnMinimap(int x, int y);
 
     void drawSelectAllButton();
-    void drawMissionHint(int elapsed);
+    //! Updates the mission hint text and invalidates it if it changed
+    void updateMissionHint(int elapsed);
+    void drawMissionHint();
+    //! Fills state with the sprites and ammo bars of the weapon selectors
+    void weaponSelectorsState(std::vector<int> &state);
     void drawWeaponSelectors();
+    //! Sets the position of all the regions of the screen
+    void initRegions();
+    //! Marks the region as needing to be drawn
+    void invalidateRegion(int region);
+    //! Invalidates the region if the given state is not the one displayed
+    void invalidateRegionIfChanged(int region, const std::vector<int> &state);
+    //! Invalidates the regions of the panel whose content has changed
+    void invalidateChangedPanelRegions();
+    //! Returns true if the region must be drawn and clears it
+    bool prepareRegion(DirtyList &dirtyList, int region);
     //! Scroll the map horizontally.
     bool scrollOnX();
     //! Scroll the map vertically.
@@ -92,13 +111,15 @@ protected:
     //! Centers the minimap on the selection leader
     void centerMinimapOnLeader();
     //! Animate the minimap
-    void updateMinimap(int elapsed);
+    bool updateMinimap(int elapsed);
     //! Update the select all button state
     void updateSelectAll();
     //! Update the target value for adrenaline etc for an agent
     void updateIPALevelMeters(int elapsed);
 
     void updateMarkersPosition();
+    //! Invalidates the line of sight cache if the object has moved
+    void invalidateLosIfMoved(const TilePoint &before, MapObject *pObject);
 
 protected:
     /*! Origin of the minimap on the screen.*/
@@ -106,6 +127,36 @@ protected:
     /*! Origin of the minimap on the screen.*/
     static const int kMiniMapScreenY;
 
+    /*!
+     * The screen is split in regions that are drawn only when what
+     * they display has changed.
+     */
+    enum ERegion {
+        //! The map viewport
+        kRegionMap = 0,
+        //! Upper part of the selector of each agent (4 regions)
+        kRegionSelector = 1,
+        //! IPA meters of each agent (4 regions)
+        kRegionIpa = 5,
+        kRegionSelectAll = 9,
+        kRegionHint,
+        kRegionWeapons,
+        kRegionMinimap,
+        kRegionCount
+    };
+
+    /*!
+     * A rectangle on the screen and the values it displayed when it
+     * was last invalidated.
+     */
+    struct ScreenRegion {
+        int x;
+        int y;
+        int width;
+        int height;
+        std::vector<int> state;
+    };
+
     int tick_count_, last_animate_tick_;
     int last_motion_tick_, last_motion_x_, last_motion_y_;
     int mission_hint_ticks_, mission_hint_;
@@ -126,6 +177,10 @@ protected:
     MapRenderer map_renderer_;
     /*! This renderer is in charge of drawing the minimap.*/
     GamePlayMinimapRenderer mm_renderer_;
+    /*! Decides which peds execute their behaviour at each step.*/
+    AiScheduler ai_scheduler_;
+    /*! Evaluates behaviours of peds in parallel.*/
+    BehaviourRunner behaviour_runner_;
     /*! This renderer is in charge of drawing the IPA meters.*/
     AgentSelectorRenderer agt_sel_renderer_;
     //! A flag to keep track of the state of the select all button
@@ -137,6 +192,22 @@ protected:
     /*! Delay between 2 police warnings.*/
     fs_utils::Timer warningTimer_;
 
+    /*! All regions of the screen, indexed by ERegion.*/
+    ScreenRegion regions_[kRegionCount];
+    /*! Used to compute the state of a region without allocating.*/
+    std::vector<int> regionState_;
+    /*!
+     * Copy of the control panel. The map is also drawn under the panel
+     * so the panel is restored from this copy after drawing the map.
+     */
+    std::vector<uint8> panelCache_;
+    /*! Text displayed in the mission hint area.*/
+    std::string hintText_;
+    /*! Color of the mission hint text.*/
+    uint8 hintColor_;
+    /*! True if the hint is displayed on a colored bar.*/
+    bool hintBar_;
+
     // when ipa is manipulated this represents
     struct IPA_manipulation {
         // ipa that is manipulated
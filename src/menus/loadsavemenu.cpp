@@ -41,6 +41,8 @@ LoadSaveMenu::LoadSaveMenu(MenuManager * m):Menu(m, fs_game_menus::kMenuIdLdSave
     isCachable_ = false;
     // Title
     addStatic(0, 40, g_Screen.gameScreenWidth(), "#LS_TITLE", FontManager::SIZE_4, false);
+    // Save progress
+    txtStatusId_ = addStatic(X_ORIGIN, 76, 370, "", FontManager::SIZE_2, false);
 
     // Load button
     loadButId_ = addOption(46, 346, 99, 25, "#LS_LOAD_BUT", FontManager::SIZE_2);
@@ -75,12 +77,35 @@ void LoadSaveMenu::handleShow()
     for (int i=0; i<10; i++) {
         pTextFields_[i]->setText(files[i].c_str());
     }
+    getStatic(txtStatusId_)->setText("");
 
     menu_manager_->saveBackground();
     g_System.showCursor();
 }
 
+/*!
+ * Follows the writing of the saved game and returns to the main
+ * menu when it's done.
+ */
+void LoadSaveMenu::handleTick(int elapsed) {
+    SaveGameWriter &writer = g_App.saveWriter();
+    if (!writer.isStarted()) {
+        return;
+    }
+
+    if (writer.isWriting()) {
+        getStatic(txtStatusId_)->setTextFormated("#LS_SAVING", writer.progress());
+    } else if (writer.finish()) {
+        editNameId_ = -1;
+        menu_manager_->gotoMenu(fs_game_menus::kMenuIdMain);
+    } else {
+        getStatic(txtStatusId_)->setText("#LS_SAVE_ERROR");
+    }
+}
+
 void LoadSaveMenu::handleLeave() {
+    // the player may leave before the end of the save
+    g_App.saveWriter().finish();
     g_System.hideCursor();
     if (editNameId_ != -1) {
         pTextFields_[editNameId_]->setHighlighted(false);
@@ -89,6 +114,11 @@ void LoadSaveMenu::handleLeave() {
 }
 
 void LoadSaveMenu::handleAction(const int actionId, void *ctx, const int modKeys) {
+    if (g_App.saveWriter().isStarted()) {
+        // wait for the current save to end
+        return;
+    }
+
     if (actionId == loadButId_) {
         if (editNameId_ != -1) {
             if (g_App.loadGameFromFile(editNameId_)) {
@@ -99,8 +129,10 @@ void LoadSaveMenu::handleAction(const int actionId, void *ctx, const int modKeys
     } else if (actionId == saveButId_) {
         if (editNameId_ != -1 && pTextFields_[editNameId_]->getText().size() != 0) {
             if (g_App.saveGameToFile(editNameId_, pTextFields_[editNameId_]->getText())) {
-                editNameId_ = -1;
-                menu_manager_->gotoMenu(fs_game_menus::kMenuIdMain);
+                // handleTick() returns to main menu when file is written
+                getStatic(txtStatusId_)->setTextFormated("#LS_SAVING", 0);
+            } else {
+                getStatic(txtStatusId_)->setText("#LS_SAVE_ERROR");
             }
         }
     }
@@ -34,6 +34,7 @@ public:
     LoadSaveMenu(MenuManager *m);
 
     void handleShow();
+    void handleTick(int elapsed);
     void handleLeave();
 
     void handleAction(const int actionId, void *ctx, const int modKeys);
@@ -49,6 +50,8 @@ protected:
     int loadButId_;
     /*! Id of the save button.*/
     int saveButId_;
+    /*! Id of the text showing the save progress.*/
+    int txtStatusId_;
     /*! The id of the line currently being edited. -1 if no line selected.*/
     short editNameId_;
     /*! There are 10 text fields in the menu to enter file names.*/
@@ -53,6 +53,9 @@ void MainMenu::handleShow()
     // otherwise, it does no harm
     g_System.useMenuCursor();
     g_System.showCursor();
+
+    // Player may come from the briefing or selection menu
+    g_gameCtrl.missions().cancelPreload();
 }
 
 void MainMenu::handleLeave() {
@@ -31,6 +31,7 @@
 #include "menus/mapmenu.h"
 #include "menus/gamemenuid.h"
 #include "core/gamesession.h"
+#include "core/gamecontroller.h"
 #include "gfx/screen.h"
 #include "system.h"
 #include "menus/menumanager.h"
@@ -327,6 +328,9 @@ void MapMenu::handleShow() {
     // save a background without country colour
     menu_manager_->saveBackground();
 
+    // Player is back on the map so mission is abandoned
+    g_gameCtrl.missions().cancelPreload();
+
     // Show the mouse
     g_System.showCursor();
 
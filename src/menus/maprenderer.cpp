@@ -92,8 +92,8 @@ void MapRenderer::render(const Point2D &viewport) {
                     if (z > 2)
                         continue;
 #endif
-                    // draw a tile
-                    if (tile_z < pMap_->maxZ()) {
+                    // draw a tile (tiles above the column height are transparent)
+                    if (tile_z <= pMap_->maxZAt(tile_x, tile_y)) {
                         Tile *p_tile = pMap_->getTileAt(tile_x, tile_y, tile_z);
                         if (p_tile->notTransparent()) {
                             int dx = 0, dy = 0;
@@ -20,6 +20,9 @@
  *                                                                      *
  ************************************************************************/
 
+#include <stdlib.h>
+#include <algorithm>
+
 #include "app.h"
 #include "menus/minimaprenderer.h"
 #include "core/missionbriefing.h"
@@ -218,6 +221,7 @@ GamePlayMinimapRenderer::GamePlayMinimapRenderer() :
     mm_timer_weap(300, false), mm_timer_ped(260, false),
     mm_timer_signal(250) {
     p_mission_ = NULL;
+    floorValid_ = false;
     handleClearSignal();
     g_gameCtrl.addListener(this, GameEvent::kMission);
 }
@@ -237,6 +241,8 @@ void GamePlayMinimapRenderer::init(Mission *pMission, bool b_scannerEnabled) {
     offset_y_ = 0;
     cross_x_ = 64;
     cross_y_ = 64;
+    floorValid_ = false;
+    overlayRects_.clear();
     mm_timer_weap.reset();
     mm_timer_signal.reset();
     handleClearSignal();
@@ -253,6 +259,7 @@ void GamePlayMinimapRenderer::updateRenderingInfos() {
  */
 void GamePlayMinimapRenderer::setScannerEnabled(bool b_enabled) {
     setZoom(b_enabled ? ZOOM_X1 : ZOOM_X3);
+    changed_ = true;
 }
 
 /*!
@@ -266,6 +273,8 @@ void GamePlayMinimapRenderer::setScannerEnabled(bool b_enabled) {
  */
 void GamePlayMinimapRenderer::centerOn(uint16 tileX, uint16 tileY, int offX, int offY) {
     uint16 halfSize = mm_maxtile_ / 2;
+    uint16 prev_tx = world_tx_, prev_ty = world_ty_;
+    int prev_cross_x = cross_x_, prev_cross_y = cross_y_;
 
     if (tileX < halfSize) {
         // we're too close of the top border -> stop moving along X axis
@@ -296,6 +305,11 @@ void GamePlayMinimapRenderer::centerOn(uint16 tileX, uint16 tileY, int offX, int
     // TODO : see if we can remove + 1
     cross_x_ = mapToMiniMapX(tileX + 1, offX);
     cross_y_ = mapToMiniMapY(tileY + 1, offY);
+
+    if (prev_tx != world_tx_ || prev_ty != world_ty_ ||
+        prev_cross_x != cross_x_ || prev_cross_y != cross_y_) {
+        changed_ = true;
+    }
 }
 
 /**
@@ -323,10 +337,9 @@ void GamePlayMinimapRenderer::handleGameEvent(GameEvent evt) {
 
 void GamePlayMinimapRenderer::handleEvacuationSet(GameEvent &evt) {
     handleClearSignal();
-    WorldPoint * pPoint = static_cast<WorldPoint *>(evt.pCtxt);
-    signalSourceLocW_.x = pPoint->x;
-    signalSourceLocW_.y = pPoint->y;
-    signalSourceLocW_.z = pPoint->z;
+    signalSourceLocW_.x = evt.locW.x;
+    signalSourceLocW_.y = evt.locW.y;
+    signalSourceLocW_.z = evt.locW.z;
 
     signalType_ = kEvacuation;
 
@@ -347,6 +360,7 @@ void GamePlayMinimapRenderer::handleClearSignal() {
     signalSourceLocW_.x = 0;
     signalSourceLocW_.y = 0;
     signalSourceLocW_.z = 0;
+    changed_ = true;
 }
 
 /*!
@@ -355,17 +369,25 @@ void GamePlayMinimapRenderer::handleClearSignal() {
 void GamePlayMinimapRenderer::handleTargetSet(GameEvent &evt) {
     handleClearSignal();
     // get the target current position
-    MapObject *pTarget = static_cast<MapObject *>(evt.pCtxt);
+    MapObject *pTarget = evt.pTarget;
     p_minimap_->setTarget(pTarget);
     signalSourceLocW_.convertFromTilePoint(pTarget->position());
     signalType_ = kTarget;
 }
 
+/*!
+ * Updates the blinking and the signal.
+ * \return True if the minimap looks different since last call. Moving
+ * elements are not taken into account.
+ */
 bool GamePlayMinimapRenderer::handleTick(int elapsed) {
-    mm_timer_ped.update(elapsed);
-    mm_timer_weap.update(elapsed);
+    bool changed = changed_;
+    changed_ = false;
+    changed |= mm_timer_ped.update(elapsed);
+    changed |= mm_timer_weap.update(elapsed);
 
     if (signalType_ != kNone &&mm_timer_signal.update(elapsed)) {
+        changed = true;
         // Time hit max -> update radar circle size
         i_signalRadius_ += 16;
         int signal_px = signalXYZToMiniMapX();
@@ -402,7 +424,7 @@ bool GamePlayMinimapRenderer::handleTick(int elapsed) {
         }
     }
 
-    return true;
+    return changed;
 }
 
 /*!
@@ -427,69 +449,158 @@ TilePoint GamePlayMinimapRenderer::minimapToMapPoint(int mm_x, int mm_y) {
 }
 
 /*!
- * Renders the minimap at the given position on the screen.
- * \param screen_x X coord in absolute pixels.
- * \param screen_y Y coord in absolute pixels.
+ * Fills the tile at the given position on the minimap with its floor colour.
+ * \param i X coord of the tile relatively to the minimap corner
+ * \param j Y coord of the tile relatively to the minimap corner
  */
-void GamePlayMinimapRenderer::render(uint16 screen_x, uint16 screen_y) {
-    // A temporary buffer composed of mm_maxtile + 1 columns and rows.
-    // we use a slightly larger rendering buffer not to have
-    // to check borders. At the end we only display  the mm_maxtile x mm_maxtile tiles.
-    // On top of this we use one size for both resolutions as 18*18*8*8 > 34*34*4*4
+void GamePlayMinimapRenderer::drawFloorTile(int i, int j) {
+    const int layerWidth = pixpertile_ * (mm_maxtile_ + 1);
+    uint8 gcolour = p_minimap_->getColourAt(world_tx_ + i, world_ty_ + j);
+    uint8 *drow = floorLayer_ + (j + 1) * pixpertile_ * layerWidth + (i + 1) * pixpertile_;
+    for (uint8 inc = 0; inc < pixpertile_; ++inc) {
+        memset(drow, gcolour, pixpertile_);
+        drow += layerWidth;
+    }
+}
 
-    // NOTE: additional data is added to avoid stack corruption (18 * 8) * 4
-    uint8 minimap_layer[18*18*8*8 + (18 * 8) * 4];
-    // because of reading data from buffer in peds draw, to avoid
-    // conditional on uninitialized value
-    memset(minimap_layer, 0, 18*18*8*8 + (18 * 8) * 4);
+/*!
+ * Moves the content of the floor layer so that tile (i, j) receives the old
+ * tile (i + dx, j + dy). Tiles that were not visible before are drawn.
+ * \param dx Number of tiles the minimap has moved along X axis
+ * \param dy Number of tiles the minimap has moved along Y axis
+ */
+void GamePlayMinimapRenderer::scrollFloorLayer(int dx, int dy) {
+    const int layerWidth = pixpertile_ * (mm_maxtile_ + 1);
+    // columns that are still visible after the move
+    int firstCol = dx < 0 ? -dx : 0;
+    int lastCol = dx > 0 ? mm_maxtile_ - dx : mm_maxtile_;
+
+    // rows are processed in an order that does not overwrite source rows
+    for (int n = 0; n < mm_maxtile_; n++) {
+        int j = dy > 0 ? n : mm_maxtile_ - 1 - n;
+        int srcJ = j + dy;
+        if (srcJ < 0 || srcJ >= mm_maxtile_) {
+            for (int i = 0; i < mm_maxtile_; i++) {
+                drawFloorTile(i, j);
+            }
+            continue;
+        }
 
-    uint8 mm_layer_size = mm_maxtile_ + 1;
-    // The final minimap that will be displayed : the minimap is 128*128 pixels
-    uint8 minimap_final_layer[kMiniMapSizePx*kMiniMapSizePx];
+        for (uint8 inc = 0; inc < pixpertile_; ++inc) {
+            uint8 *drow = floorLayer_ + ((j + 1) * pixpertile_ + inc) * layerWidth + pixpertile_;
+            uint8 *srow = floorLayer_ + ((srcJ + 1) * pixpertile_ + inc) * layerWidth + pixpertile_;
+            memmove(drow + firstCol * pixpertile_, srow + (firstCol + dx) * pixpertile_,
+                (lastCol - firstCol) * pixpertile_);
+        }
+        for (int i = 0; i < firstCol; i++) {
+            drawFloorTile(i, j);
+        }
+        for (int i = lastCol; i < mm_maxtile_; i++) {
+            drawFloorTile(i, j);
+        }
+    }
+}
+
+/*!
+ * The floor only depends on the position of the minimap, so it is kept
+ * between frames and only the tiles that appear are drawn when scrolling.
+ * \return True if the floor layer has changed.
+ */
+bool GamePlayMinimapRenderer::updateFloorLayer() {
+    int dx = world_tx_ - floor_tx_;
+    int dy = world_ty_ - floor_ty_;
 
-    // In this loop, we fill the buffer with floor colour. the first row and column
-    // is not filled
+    if (floorValid_ && floor_pixpertile_ == pixpertile_) {
+        if (dx == 0 && dy == 0) {
+            return false;
+        }
+        if (abs(dx) < mm_maxtile_ && abs(dy) < mm_maxtile_) {
+            scrollFloorLayer(dx, dy);
+            floor_tx_ = world_tx_;
+            floor_ty_ = world_ty_;
+            return true;
+        }
+    }
 
+    // because of reading data from buffer in peds draw, to avoid
+    // conditional on uninitialized value
+    memset(floorLayer_, 0, kLayerSize);
     for (int j = 0; j < mm_maxtile_; ++j) {
-        // pointer to first row
-        uint8* frow = minimap_layer + (j + 1) * pixpertile_ * pixpertile_ * mm_layer_size
-            + pixpertile_;
         for (int i = 0; i < mm_maxtile_; i++) {
-            uint8 gcolour = p_mission_->getMiniMap()->getColourAt(world_tx_ + i, world_ty_ + j);
-            // pointer to row we draw at
-            uint8 *drow = frow + i * pixpertile_;
-            for (uint8 inc = 0; inc < pixpertile_; ++inc)
-                *drow++ = gcolour;
+            drawFloorTile(i, j);
         }
-        for (uint8 inc = 1; inc < pixpertile_; ++inc) {
-            uint8 *drow = frow + inc * pixpertile_ * mm_layer_size;
-            uint8 *local_frow = frow;
-            const uint32 sz = pixpertile_ * mm_maxtile_;
-            for (uint32 i = 0; i < sz; ++i)
-                *drow++ = *local_frow++;
+    }
+    floorValid_ = true;
+    floor_pixpertile_ = pixpertile_;
+    floor_tx_ = world_tx_;
+    floor_ty_ = world_ty_;
+    return true;
+}
+
+/*!
+ * Copies the floor back over every part of the layer that was drawn
+ * during the last rendering.
+ */
+void GamePlayMinimapRenderer::eraseOverlays() {
+    const int layerWidth = pixpertile_ * (mm_maxtile_ + 1);
+    for (size_t n = 0; n < overlayRects_.size(); n++) {
+        const DirtyRect &rect = overlayRects_[n];
+        for (int j = 0; j < rect.height; j++) {
+            int start = (rect.y + j) * layerWidth + rect.x;
+            int end = start + rect.width;
+            if (start < 0) {
+                start = 0;
+            }
+            if (end > kLayerSize) {
+                end = kLayerSize;
+            }
+            if (start < end) {
+                memcpy(layer_ + start, floorLayer_ + start, end - start);
+            }
         }
     }
+    overlayRects_.clear();
+}
+
+/*!
+ * Renders the minimap at the given position on the screen.
+ * When the minimap has not scrolled, only the parts that were covered by
+ * moving elements are restored before drawing them again.
+ * \param screen_x X coord in absolute pixels.
+ * \param screen_y Y coord in absolute pixels.
+ */
+void GamePlayMinimapRenderer::render(uint16 screen_x, uint16 screen_y) {
+    uint8 mm_layer_size = mm_maxtile_ + 1;
+    // The final minimap that will be displayed : the minimap is 128*128 pixels
+    uint8 minimap_final_layer[kMiniMapSizePx*kMiniMapSizePx];
+
+    if (updateFloorLayer()) {
+        memcpy(layer_, floorLayer_, kLayerSize);
+        overlayRects_.clear();
+    } else {
+        eraseOverlays();
+    }
 
     // Draw the minimap cross
-    drawFillRect(minimap_layer, cross_x_, 0, 1, (mm_maxtile_ + 1) * pixpertile_, fs_cmn::kColorBlack);
-    drawFillRect(minimap_layer, 0, cross_y_, (mm_maxtile_ + 1) * pixpertile_, 1, fs_cmn::kColorBlack);
+    drawFillRect(layer_, cross_x_, 0, 1, (mm_maxtile_ + 1) * pixpertile_, fs_cmn::kColorBlack);
+    drawFillRect(layer_, 0, cross_y_, (mm_maxtile_ + 1) * pixpertile_, 1, fs_cmn::kColorBlack);
 
     // draw all visible elements on the minimap
-    drawPedestrians(minimap_layer);
-    drawWeapons(minimap_layer);
-    drawVehicles(minimap_layer);
+    drawPedestrians(layer_);
+    drawWeapons(layer_);
+    drawVehicles(layer_);
 
     if (signalType_ != kNone) {
         int signal_px = signalXYZToMiniMapX();
         int signal_py = signalXYZToMiniMapY();
-        drawSignalCircle(minimap_layer, signal_px, signal_py, i_signalRadius_, i_signalColor_);
+        drawSignalCircle(layer_, signal_px, signal_py, i_signalRadius_, i_signalColor_);
     }
 
     // Copy the temp buffer in the final minimap using the tile offset so the minimap movement
     // is smoother
     for (int j = 0; j < kMiniMapSizePx; j++) {
         memcpy(minimap_final_layer + (kMiniMapSizePx * j),
-            minimap_layer + (pixpertile_ * pixpertile_ * mm_layer_size) +
+            layer_ + (pixpertile_ * pixpertile_ * mm_layer_size) +
             (j + offset_y_) * pixpertile_ * mm_layer_size + pixpertile_ + offset_x_, kMiniMapSizePx);
     }
 
@@ -655,6 +766,7 @@ void GamePlayMinimapRenderer::drawPedCircle(uint8 * a_buffer, int mm_x, int mm_y
     // centers the circle on the ped position and add pixels to skip the first row and column
     mm_x -= 3;
     mm_y -= 3;
+    addOverlayRect(mm_x, mm_y, kCircleMaskSize, kCircleMaskSize);
 
     for (uint8 j = 0; j < kCircleMaskSize; j++) {
         for (uint8 i = 0; i < kCircleMaskSize; i++) {
@@ -684,6 +796,16 @@ void GamePlayMinimapRenderer::drawPedCircle(uint8 * a_buffer, int mm_x, int mm_y
 void GamePlayMinimapRenderer::drawSignalCircle(uint8 * a_buffer, int signal_px,
     int signal_py, uint16 radius, uint8 color)
 {
+    // drawPixel() does not draw outside the layer
+    int layerWidth = pixpertile_ * (mm_maxtile_ + 1);
+    int left = std::max(signal_px - radius, 0);
+    int top = std::max(signal_py - radius, 0);
+    int right = std::min(signal_px + radius + 1, layerWidth);
+    int bottom = std::min(signal_py + radius + 1, layerWidth);
+    if (left < right && top < bottom) {
+        addOverlayRect(left, top, right - left, bottom - top);
+    }
+
     if (!radius)
     {
        drawPixel(a_buffer, signal_px, signal_py, color);
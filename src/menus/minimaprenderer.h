@@ -24,12 +24,14 @@
 #define MENUS_MINIMAPRENDERER_H_
 
 #include <map>
+#include <vector>
 
 #include "common.h"
 #include "map.h"
 #include "pathsurfaces.h"
 #include "utils/timer.h"
 #include "core/gameevent.h"
+#include "gfx/dirtylist.h"
 
 class Mission;
 class MissionBriefing;
@@ -183,6 +185,22 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
     };
     //! called when zoom changes
     void updateRenderingInfos();
+    //! Brings the cached floor layer up to date with the minimap position
+    bool updateFloorLayer();
+    //! Moves the cached floor by the given number of tiles
+    void scrollFloorLayer(int dx, int dy);
+    //! Fills one tile of the cached floor layer
+    void drawFloorTile(int i, int j);
+    //! Restores the floor under what was drawn over it last time
+    void eraseOverlays();
+    /*!
+     * Remembers a part of the rendering layer that has been drawn over
+     * the floor so it can be erased next time.
+     */
+    void addOverlayRect(int x, int y, int width, int height) {
+        DirtyRect rect = { x, y, width, height };
+        overlayRects_.push_back(rect);
+    }
     //! Draw all visible cars
     void drawVehicles(uint8 * a_minimap);
     //! Draw all visible dropped weapons
@@ -244,6 +262,7 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
     inline void drawFillRect(uint8 * a_buffer, int mm_x, int mm_y, size_t width,
                         size_t height, uint8 color)
     {
+        addOverlayRect(mm_x, mm_y, width, height);
         uint8 *draw_base = a_buffer + mm_y * pixpertile_ * (mm_maxtile_ + 1) + mm_x;
         for (size_t inc = 0; inc < height; ++inc) {
             uint8 *draw_at = draw_base + inc * pixpertile_ * (mm_maxtile_ + 1);
@@ -284,6 +303,12 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
  private:
      /*! Radius of the red evacuation circle.*/
     static const int kEvacuationRadius;
+    /*!
+     * Size of the rendering layers : mm_maxtile + 1 columns and rows of
+     * tiles. One size is used for both zooms as 18*18*8*8 > 34*34*4*4.
+     * Additional data is added to avoid buffer overrun : (18 * 8) * 4
+     */
+    static const int kLayerSize = 18*18*8*8 + (18 * 8) * 4;
 
     /*! The mission that contains the minimap.*/
     Mission *p_mission_;
@@ -316,6 +341,25 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
     fs_utils::BoolTimer mm_timer_ped;
     /*! Timer for the signal.*/
     fs_utils::Timer mm_timer_signal;
+    /*!
+     * Floor colours of the visible tiles. The first row and column
+     * are not filled. Only rebuilt when the minimap scrolls.
+     */
+    uint8 floorLayer_[kLayerSize];
+    /*! The floor with peds, vehicles, weapons and signal drawn on it.*/
+    uint8 layer_[kLayerSize];
+    /*! False when the floor layer must be completely rebuilt.*/
+    bool floorValid_;
+    /*! Tile coords of the top left corner of the floor layer.*/
+    uint16 floor_tx_;
+    /*! Tile coords of the top left corner of the floor layer.*/
+    uint16 floor_ty_;
+    /*! Zoom used to draw the floor layer.*/
+    uint8 floor_pixpertile_;
+    /*! Parts of layer_ that were drawn over the floor.*/
+    std::vector<DirtyRect> overlayRects_;
+    /*! True when position or signal has changed since last tick.*/
+    bool changed_;
 };
 
 #endif  // MENUS_MINIMAPRENDERER_H_
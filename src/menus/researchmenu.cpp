@@ -394,7 +394,7 @@ void ResearchMenu::handleAction(const int actionId, void *ctx, const int modKeys
 void ResearchMenu::handleGameEvent(GameEvent evt) {
     if (evt.type == GameEvent::kResearch) {
         // A research has ended
-        Research *pRes = static_cast<Research *> (evt.pCtxt);
+        Research *pRes = evt.pResearch;
 
         // If current graph was for this research, make it disappear
         if (pResForGraph_ && pResForGraph_->getId() == pRes->getId()) {
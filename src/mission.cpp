@@ -30,6 +30,8 @@
 #include <assert.h>
 #include <string>
 
+#include <SDL_thread.h>
+
 #include "mission.h"
 #include "gfx/screen.h"
 #include "app.h"
@@ -42,6 +44,9 @@
 const uint8 Mission::kBMaskBlockerTargetOutOfMap = 0x20;
 const uint8 Mission::kBMaskBlockerTargetObjectUpdated = 0x02;
 const uint8 Mission::kBMaskBlockerTargetPosUpdated = 0x04;
+const double Mission::kTileStepBack = 8.0;
+Mission::TileShape Mission::tileShapes_[256];
+const bool Mission::kTileShapesReady = Mission::initTileShapes();
 
 /*!
  * Initialize the statistics.
@@ -75,30 +80,51 @@ Mission::Mission(const LevelData::MapInfos & map_infos)
     max_x_ = READ_LE_UINT16(map_infos.max_x) / 2;
     max_y_ = READ_LE_UINT16(map_infos.max_y) / 2;
     cur_objective_ = 0;
+    pendingObjTriggers_ = kObjTrigNone;
     p_minimap_ = NULL;
     p_squad_ = new Squad();
+    nbLosHits_ = 0;
+    nbLosMisses_ = 0;
+    // entries are created with generation 0 so they are all free
+    losCache_.resize(kLosCacheSize);
+    losGeneration_ = 1;
+    losStamp_ = 0;
+    losCellsX_ = 0;
+    losCellsY_ = 0;
 }
 
 Mission::~Mission()
 {
     for (unsigned int i = 0; i < vehicles_.size(); i++)
-        delete vehicles_[i];
+        MissionArena::destroy(vehicles_[i]);
     for (unsigned int i = 0; i < peds_.size(); i++)
-        delete peds_[i];
+        MissionArena::destroy(peds_[i]);
     for (unsigned int i = 0; i < weaponsOnGround_.size(); i++)
         delete weaponsOnGround_[i];
-    while (sfx_objects_.size() != 0) {
-        delSfxObject(0);
+    for (unsigned int i = 0; i < sfx_objects_.size(); i++) {
+        if (!sfx_objects_[i]->isManaged()) {
+            delete sfx_objects_[i];
+        }
     }
     for (unsigned int i = 0; i < prj_shots_.size(); i++)
         delete prj_shots_[i];
     for (unsigned int i = 0; i < statics_.size(); i++)
-        delete statics_[i];
+        MissionArena::destroy(statics_[i]);
+    // memory is released when arena is destroyed
+    arena_.logStats();
     for (unsigned int i = 0; i < objectives_.size(); i++)
         delete objectives_[i];
     armedPedsVec_.clear();
     clrSurfaces();
 
+    LOG(Log::k_FLG_GAME, "Mission", "~Mission", ("Line of sight cache : %d hits, %d misses",
+        nbLosHits_, nbLosMisses_));
+
+    if (p_map_) {
+        g_App.maps().setSurfacesMemory(p_map_->id(), 0);
+        g_App.maps().unlockMap(p_map_->id());
+    }
+
     if (p_minimap_) {
         delete p_minimap_;
     }
@@ -108,9 +134,33 @@ Mission::~Mission()
     }
 }
 
-void Mission::delPrjShot(size_t i) {
-    delete prj_shots_[i];
-    prj_shots_.erase((prj_shots_.begin() + i));
+void Mission::removeDeadSfxObjects() {
+    size_t nbKept = 0;
+    for (size_t i = 0; i < sfx_objects_.size(); i++) {
+        SFXObject *pSfx = sfx_objects_[i];
+        if (pSfx->sfxLifeOver()) {
+            if (!pSfx->isManaged()) {
+                // object is not managed so delete it
+                delete pSfx;
+            }
+        } else {
+            sfx_objects_[nbKept++] = pSfx;
+        }
+    }
+    sfx_objects_.resize(nbKept);
+}
+
+void Mission::removeDeadPrjShots() {
+    size_t nbKept = 0;
+    for (size_t i = 0; i < prj_shots_.size(); i++) {
+        ProjectileShot *pShot = prj_shots_[i];
+        if (pShot->isLifeOver()) {
+            delete pShot;
+        } else {
+            prj_shots_[nbKept++] = pShot;
+        }
+    }
+    prj_shots_.resize(nbKept);
 }
 
 /*!
@@ -141,11 +191,24 @@ void Mission::objectiveMsg(std::string& msg) {
  * Sets the given map for the mission.
  * Creates a minimap from it.
  * \param p_map The map to set.
+ * \param lock False if the caller has already locked the map for the
+ * mission, so that MapManager is not used (ie from the preload thread).
  */
-void Mission::set_map(Map *p_map) {
+void Mission::set_map(Map *p_map, bool lock) {
     if (p_map) {
+        if (p_map_) {
+            g_App.maps().unlockMap(p_map_->id());
+        }
         p_map_ = p_map;
+        // map must stay in cache as long as the mission uses it
+        if (lock) {
+            g_App.maps().lockMap(p_map_->id());
+        }
         p_map_->mapDimensions(&mmax_x_, &mmax_y_, &mmax_z_);
+        losCellsX_ = (mmax_x_ + kLosCellTiles - 1) / kLosCellTiles;
+        losCellsY_ = (mmax_y_ + kLosCellTiles - 1) / kLosCellTiles;
+        losCellStamps_.assign(losCellsX_ * losCellsY_, 0);
+        clearLosCache();
 
         if (p_minimap_) {
             delete p_minimap_;
@@ -171,6 +234,7 @@ void Mission::start()
     stats_.init(p_squad_->size());
 
     cur_objective_ = 0;
+    pendingObjTriggers_ = kObjTrigNone;
 
     // creating a list of available weapons
     // TODO: consider weight of weapons when adding?
@@ -230,10 +294,22 @@ void Mission::checkObjectives() {
             LOG(Log::k_FLG_GAME, "Mission", "checkObjectives()", ("Start objective : %d", cur_objective_));
             // An objective has just started, warn all listeners
             pObj->start(this);
+            // and evaluate it once whatever happened before
+            pendingObjTriggers_ |= pObj->triggers();
         }
 
-        // Checks if the objective is completed
-        pObj->evaluate(this);
+        // Checks if the objective is completed only if something
+        // it depends on has changed
+        if (pendingObjTriggers_ & pObj->triggers()) {
+            pObj->evaluate(this);
+        } else if (g_Ctx.isCheckObjectives()) {
+            pObj->evaluate(this);
+            if (pObj->isTerminated()) {
+                FSERR(Log::k_FLG_GAME, "Mission", "checkObjectives", ("Objective %d has ended without trigger (mask %x)",
+                    cur_objective_, pObj->triggers()));
+            }
+        }
+        pendingObjTriggers_ = kObjTrigNone;
 
         if (pObj->isTerminated()) {
             if (pObj->status == kFailed) {
@@ -250,6 +326,20 @@ void Mission::checkObjectives() {
     }
 }
 
+/*!
+ * Returns true if the given object is the target of the current
+ * objective or of one of the next objectives.
+ * \param pObject The object
+ */
+bool Mission::isObjectiveTarget(MapObject *pObject) {
+    for (size_t i = cur_objective_; i < objectives_.size(); i++) {
+        if (objectives_[i]->isTarget(pObject)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*!
  * Ends the mission with the given status.
  * \param status The ending status
@@ -352,6 +442,16 @@ void Mission::end()
     p_squad_->clear();
 }
 
+/*!
+ * Used when the mission is built to remove our agents whose slot is not
+ * active. The ped must not be referenced by another object.
+ * \param i Index of the ped
+ */
+void Mission::removePed(size_t i) {
+    MissionArena::destroy(peds_[i]);
+    peds_.erase(peds_.begin() + i);
+}
+
 void Mission::addWeaponToGround(WeaponInstance * w)
 {
     for (unsigned int i = 0; i < weaponsOnGround_.size(); i++) {
@@ -360,12 +460,15 @@ void Mission::addWeaponToGround(WeaponInstance * w)
             return;
     }
     weaponsOnGround_.push_back(w);
+    // weapons on the ground are blockers
+    invalidateLosAt(w->position());
 }
 
 void Mission::removeWeaponOnGround(WeaponInstance *pWeapon) {
     for (unsigned int i = 0; i < weaponsOnGround_.size(); i++) {
         if (weaponsOnGround_[i] == pWeapon) {
             weaponsOnGround_.erase(weaponsOnGround_.begin() + i);
+            invalidateLosAt(pWeapon->position());
         }
     }
 }
@@ -428,1777 +531,1601 @@ bool Mission::isStairs(char thisTile) {
     return thisTile > 0x00 && thisTile < 0x05;
 }
 
-bool Mission::setSurfaces() {
-
-    // Description: creates map of walkable surfaces, also
-    // defines directions where movement is possible
+/*!
+ * Parameters for a thread that classifies a range of z slices of the map.
+ */
+struct TileSlicesJob {
+    /*! The map to read tiles from.*/
+    Map *pMap;
+    /*! Destination of the walkdata : x + y * maxX + z * maxX * maxY.*/
+    uint8 *pSurfaces;
+    int maxX;
+    int maxY;
+    /*! First slice to classify.*/
+    int zStart;
+    /*! Slice after the last one to classify.*/
+    int zEnd;
+};
 
-    // NOTE: tiles walkdata type 0x0D are quiet special, and they
-    // are not handled correctly, these correction and andjustings
-    // can create additional speed drain, as such I didn't
-    // implemented them as needed. To make it possible a patch
-    // required to walkdata and a lot of changes which I don't
-    // want to do.
-    // 0x10 appear above walking tile where train stops
-    clrSurfaces();
-    int mmax_m_all = mmax_x_ * mmax_y_ * mmax_z_;
-    mtsurfaces_ = (uint8 *)malloc(mmax_m_all * sizeof(uint8));
-    mdpoints_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
-    mdpoints_cp_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
-    if(mtsurfaces_ == NULL || mdpoints_ == NULL || mdpoints_cp_ == NULL) {
-        clrSurfaces();
-        FSERR(Log::k_FLG_GAME, "Mission", "setSurfaces", ("Memory allocation error\n"));
-        return false;
-    }
-    mmax_m_xy = mmax_x_ * mmax_y_;
-    memset((void *)mtsurfaces_, 0, mmax_m_all * sizeof(uint8));
-    memset((void *)mdpoints_, 0, mmax_m_all * sizeof(floodPointDesc));
-    for (int ix = 0; ix < mmax_x_; ++ix) {
-        for (int iy = 0; iy < mmax_y_; ++iy) {
-            for (int iz = 0; iz < mmax_z_; ++iz) {
-                mtsurfaces_[ix + iy * mmax_x_ + iz * mmax_m_xy] =
-                    p_map_->getTileAt(ix, iy, iz)->getWalkData();
+/*!
+ * Copies the walkdata of every tile in the job's slices into the surfaces.
+ * Each job writes only its own slices of the destination so jobs
+ * can run concurrently.
+ * \param data A TileSlicesJob
+ * \return always 0
+ */
+static int classifyTileSlices(void *data) {
+    TileSlicesJob *pJob = (TileSlicesJob *) data;
+    int mxy = pJob->maxX * pJob->maxY;
+
+    // map stores tiles by column so z is the inner loop
+    for (int iy = 0; iy < pJob->maxY; ++iy) {
+        for (int ix = 0; ix < pJob->maxX; ++ix) {
+            uint8 *pColumn = pJob->pSurfaces + ix + iy * pJob->maxX;
+            for (int iz = pJob->zStart; iz < pJob->zEnd; ++iz) {
+                pColumn[iz * mxy] =
+                    pJob->pMap->getTileAt(ix, iy, iz)->getWalkData();
             }
         }
     }
+    return 0;
+}
 
-    // to make surfaces where large doors are located walkable
-    for (std::vector<Static *>::iterator it = statics_.begin();
-        it != statics_.end(); ++it)
-    {
-        Static *s = *it;
-        if (s->type() == Static::smt_LargeDoor) {
-            printf("Large door detected\n");
-            int indx = s->tileX() + s->tileY() * mmax_x_
-                + s->tileZ() * mmax_m_xy;
-            mtsurfaces_[indx] = 0x00;
-            if (s->orientation() == Static::kStaticOrientation1) {
-                if (indx - 1 >= 0)
-                    mtsurfaces_[indx - 1] = 0x00;
-                if (indx + 1 < mmax_m_all)
-                    mtsurfaces_[indx + 1] = 0x00;
-            } else if (s->orientation() == Static::kStaticOrientation2) {
-                if (indx - mmax_x_ >= 0)
-                    mtsurfaces_[indx - mmax_x_] = 0x00;
-                if (indx + mmax_x_ < mmax_m_all)
-                    mtsurfaces_[indx + mmax_x_] = 0x00;
+/*!
+ * Fills the given surfaces with the walkdata of all map tiles in a
+ * single thread, like setSurfaces() did before the work was split.
+ * Used as a reference to check classifyTiles().
+ * \param pMap The map to classify
+ * \param pSurfaces Array of maxX * maxY * maxZ elements
+ */
+static void classifyTilesSerial(Map *pMap, uint8 *pSurfaces) {
+    int mmax_x, mmax_y, mmax_z;
+    pMap->mapDimensions(&mmax_x, &mmax_y, &mmax_z);
+    int mmax_m_xy = mmax_x * mmax_y;
+
+    memset((void *)pSurfaces, 0, mmax_m_xy * mmax_z * sizeof(uint8));
+    for (int ix = 0; ix < mmax_x; ++ix) {
+        for (int iy = 0; iy < mmax_y; ++iy) {
+            for (int iz = 0; iz < mmax_z; ++iz) {
+                pSurfaces[ix + iy * mmax_x + iz * mmax_m_xy] =
+                    pMap->getTileAt(ix, iy, iz)->getWalkData();
             }
         }
     }
+}
 
-    //printf("surface data size %i\n", sizeof(surfaceDesc) * mmax_m_all);
-    //printf("flood data size %i\n", sizeof(floodPointDesc) * mmax_m_all);
+/*!
+ * Fills the given surfaces with the walkdata of all map tiles.
+ * Z slices are split between the given number of threads, the calling
+ * thread classifying the first range.
+ * \param pMap The map to classify
+ * \param pSurfaces Array of maxX * maxY * maxZ elements
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void Mission::classifyTiles(Map *pMap, uint8 *pSurfaces, int nbThreads) {
+    int mmax_x, mmax_y, mmax_z;
+    pMap->mapDimensions(&mmax_x, &mmax_y, &mmax_z);
 
-    for (unsigned int i = 0; i < peds_.size(); ++i) {
-        PedInstance *p = peds_[i];
-        int x = p->tileX();
-        int y = p->tileY();
-        int z = p->tileZ();
-        if (z >= mmax_z_ || z < 0 || p->isDead()) {
-            // TODO : check on all maps those peds correct position
-            p->setTileZ(mmax_z_ - 1);
-            continue;
+    if (nbThreads > mmax_z) {
+        nbThreads = mmax_z;
+    }
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+
+    std::vector<TileSlicesJob> jobs(nbThreads);
+    std::vector<SDL_Thread *> threads(nbThreads, (SDL_Thread *) NULL);
+    int zStart = 0;
+    for (int i = 0; i < nbThreads; i++) {
+        TileSlicesJob &job = jobs[i];
+        job.pMap = pMap;
+        job.pSurfaces = pSurfaces;
+        job.maxX = mmax_x;
+        job.maxY = mmax_y;
+        job.zStart = zStart;
+        // distribute remaining slices on the first jobs
+        zStart += mmax_z / nbThreads + (i < mmax_z % nbThreads ? 1 : 0);
+        job.zEnd = zStart;
+    }
+
+    for (int i = 1; i < nbThreads; i++) {
+        threads[i] = SDL_CreateThread(classifyTileSlices, &jobs[i]);
+        if (threads[i] == NULL) {
+            LOG(Log::k_FLG_GAME, "Mission", "classifyTiles",
+                ("Cannot create thread, classifying slices %d-%d inline",
+                jobs[i].zStart, jobs[i].zEnd));
+            classifyTileSlices(&jobs[i]);
         }
-        if (mdpoints_[x + y * mmax_x_ + z * mmax_m_xy].bfNodeDesc == m_fdNotDefined) {
-            WorldPoint stodef;
-            std::vector<WorldPoint> vtodefine;
-            mdpoints_[x + y * mmax_x_ + z * mmax_m_xy].bfNodeDesc = m_fdDefReq;
-            stodef.x = x;
-            stodef.y = y * mmax_x_;
-            stodef.z = z * mmax_m_xy;
-            vtodefine.push_back(stodef);
-            do {
-                stodef = vtodefine.back();
-                vtodefine.pop_back();
-                x = stodef.x;
-                y = stodef.y;
-                z = stodef.z;
-                //if (x == 50 && y / mmax_x_ == 27 && z / mmax_m_xy == 2)
-                    //x = 50;
-                uint8 this_s = mtsurfaces_[x + y + z];
-                uint8 upper_s = 0;
-                floodPointDesc *cfp = &(mdpoints_[x + y + z]);
-                int zm = z - mmax_m_xy;
-                // if current is 0x00 or 0x10 tile we will use lower tile
-                // to define it
-                if (this_s == 0x00 || this_s == 0x10) {
-                    if (zm < 0) {
-                        cfp->bfNodeDesc = m_fdNonWalkable;
-                        continue;
+    }
+
+    classifyTileSlices(&jobs[0]);
+
+    for (int i = 1; i < nbThreads; i++) {
+        if (threads[i]) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+}
+
+/*!
+ * Defines the flood point of the given tile and requests the definition
+ * of the tiles reachable from it.
+ * Flood points are only read to know if a requested tile is already
+ * defined, so the writes done for a tile depend only on the surfaces :
+ * they can be computed for all tiles in parallel and replayed in the
+ * order of the flood.
+ * \param x Tile x
+ * \param y Tile y multiplied by mmax_x_
+ * \param z Tile z multiplied by mmax_m_xy
+ * \param pSurfaces map-tile surfaces
+ * \param ops Receives the writes to the flood points
+ */
+template <class Ops>
+void Mission::floodTile(int x, int y, int z, const uint8 *pSurfaces, Ops &ops) {
+    int mmax_m_all = mmax_m_xy * mmax_z_;
+    uint8 this_s = pSurfaces[x + y + z];
+    uint8 upper_s = 0;
+    int cfp = x + y + z;
+    int zm = z - mmax_m_xy;
+    // if current is 0x00 or 0x10 tile we will use lower tile
+    // to define it
+    if (this_s == 0x00 || this_s == 0x10) {
+        if (zm < 0) {
+            ops.setDesc(cfp, m_fdNonWalkable);
+            return;
+        }
+        z = zm;
+        zm -= mmax_m_xy;
+        upper_s = this_s;
+        this_s = pSurfaces[x + y + z];
+        if (!sWalkable(this_s, upper_s))
+            return;
+    } else if (this_s == 0x11 || this_s == 0x12) {
+        int zp_tmp = z + mmax_m_xy;
+        if (zp_tmp < mmax_m_all) {
+            // we are defining tile above current
+            cfp = x + y + zp_tmp;
+        } else
+            ops.setDesc(cfp, m_fdNonWalkable);
+    }
+    int xm = x - 1;
+    int ym = y - mmax_x_;
+    int xp = x + 1;
+    int yp = y + mmax_x_;
+    int zp = z + mmax_m_xy;
+    int nxtfp;
+    if (zp < mmax_m_all) {
+        upper_s = pSurfaces[x + y + zp];
+        if(!sWalkable(this_s, upper_s)) {
+            ops.setDesc(cfp, m_fdNonWalkable);
+            return;
+        }
+    } else {
+        ops.setDesc(cfp, m_fdNonWalkable);
+        return;
+    }
+    unsigned char sdirm = 0x00;
+    unsigned char sdirh = 0x00;
+    unsigned char sdirl = 0x00;
+    unsigned char sdirmr = 0x00;
+
+    switch (this_s) {
+        case 0x00:
+            ops.setDesc(cfp, m_fdNonWalkable);
+            break;
+        case 0x01:
+            ops.setDesc(cfp, m_fdWalkable);
+            ops.orDesc(cfp, m_fdSafeWalk);
+            if (zm >= 0) {
+                ops.setDesc(x + y + zm, m_fdNonWalkable);
+                if (yp < mmax_m_xy) {
+                    this_s = pSurfaces[x + yp + zm];
+                    upper_s = pSurfaces[x + yp + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x01;
+                        nxtfp = x + yp + z;
+                        ops.request(nxtfp, x, yp, z);
+                    } else if (this_s == 0x01) {
+                        nxtfp = x + yp + zm;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x01;
+                            nxtfp = x + yp + zm;
+                            ops.request(nxtfp, x, yp, zm);
+                        } else
+                            ops.setDesc(nxtfp, m_fdNonWalkable);
                     }
-                    z = zm;
-                    zm -= mmax_m_xy;
-                    upper_s = this_s;
-                    this_s = mtsurfaces_[x + y + z];
-                    if (!sWalkable(this_s, upper_s))
-                        continue;
-                } else if (this_s == 0x11 || this_s == 0x12) {
-                    int zp_tmp = z + mmax_m_xy;
-                    if (zp_tmp < mmax_m_all) {
-                        // we are defining tile above current
-                        cfp = &(mdpoints_[x + y + zp_tmp]);
-                    } else
-                        cfp->bfNodeDesc = m_fdNonWalkable;
-                }
-                int xm = x - 1;
-                int ym = y - mmax_x_;
-                int xp = x + 1;
-                int yp = y + mmax_x_;
-                int zp = z + mmax_m_xy;
-                floodPointDesc *nxtfp;
-                if (zp < mmax_m_all) {
-                    upper_s = mtsurfaces_[x + y + zp];
-                    if(!sWalkable(this_s, upper_s)) {
-                        cfp->bfNodeDesc = m_fdNonWalkable;
-                        continue;
+                }
+                if (xm >= 0) {
+                    this_s = pSurfaces[xm + y + zm];
+                    upper_s = pSurfaces[xm + y + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = xm + y + z;
+                        sdirm |= 0x40;
+                        ops.request(nxtfp, xm, y, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = xm + y + zm;
+                        ops.request(nxtfp, xm, y, zm);
+                    }
+                }
+                if (xp < mmax_x_) {
+                    this_s = pSurfaces[xp + y + zm];
+                    upper_s = pSurfaces[xp + y + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = xp + y + z;
+                        sdirm |= 0x04;
+                        ops.request(nxtfp, xp, y, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = xp + y + zm;
+                        ops.request(nxtfp, xp, y, zm);
                     }
-                } else {
-                    cfp->bfNodeDesc = m_fdNonWalkable;
-                    continue;
                 }
-                unsigned char sdirm = 0x00;
-                unsigned char sdirh = 0x00;
-                unsigned char sdirl = 0x00;
-                unsigned char sdirmr = 0x00;
+            }
 
-                switch (this_s) {
-                    case 0x00:
-                        cfp->bfNodeDesc = m_fdNonWalkable;
-                        break;
-                    case 0x01:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        cfp->bfNodeDesc |= m_fdSafeWalk;
-                        if (zm >= 0) {
-                            mdpoints_[x + y + zm].bfNodeDesc = m_fdNonWalkable;
-                            if (yp < mmax_m_xy) {
-                                this_s = mtsurfaces_[x + yp + zm];
-                                upper_s = mtsurfaces_[x + yp + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x01;
-                                    nxtfp = &(mdpoints_[x + yp + z]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (this_s == 0x01) {
-                                    nxtfp = &(mdpoints_[x + yp + zm]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x01;
-                                        nxtfp = &(mdpoints_[x + yp + zm]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = yp;
-                                            stodef.z = zm;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    } else
-                                        nxtfp->bfNodeDesc = m_fdNonWalkable;
-                                }
-                            }
-                            if (xm >= 0) {
-                                this_s = mtsurfaces_[xm + y + zm];
-                                upper_s = mtsurfaces_[xm + y + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    sdirm |= 0x40;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                            if (xp < mmax_x_) {
-                                this_s = mtsurfaces_[xp + y + zm];
-                                upper_s = mtsurfaces_[xp + y + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[xp + y + z]);
-                                    sdirm |= 0x04;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[xp + y + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                        }
+            if (ym >= 0) {
+                nxtfp = x + ym + zp;
+                this_s = pSurfaces[x + ym + z];
+                upper_s = pSurfaces[x + ym + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    sdirh |= 0x10;
+                    ops.request(nxtfp, x, ym, zp);
+                } else if(upper_s == 0x01 && (zp + mmax_m_xy) < mmax_m_all) {
+                    if(sWalkable(upper_s, pSurfaces[
+                        x + ym + (zp + mmax_m_xy)]))
+                    {
+                        sdirh |= 0x10;
+                        ops.request(nxtfp, x, ym, zp);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (ym >= 0) {
-                            nxtfp = &(mdpoints_[x + ym + zp]);
-                            this_s = mtsurfaces_[x + ym + z];
-                            upper_s = mtsurfaces_[x + ym + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                sdirh |= 0x10;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if(upper_s == 0x01 && (zp + mmax_m_xy) < mmax_m_all) {
-                                if(sWalkable(upper_s, mtsurfaces_[
-                                    x + ym + (zp + mmax_m_xy)]))
-                                {
-                                    sdirh |= 0x10;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = zp;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
+            if (xm >= 0) {
+                this_s = pSurfaces[xm + y + z];
+                upper_s = pSurfaces[xm + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = xm + y + zp;
+                    sdirh |= 0x40;
+                    ops.request(nxtfp, xm, y, zp);
+                } else if (this_s == 0x01) {
+                    nxtfp = xm + y + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x40;
+                        ops.request(nxtfp, xm, y, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (xm >= 0) {
-                            this_s = mtsurfaces_[xm + y + z];
-                            upper_s = mtsurfaces_[xm + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[xm + y + zp]);
-                                sdirh |= 0x40;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x01) {
-                                nxtfp = &(mdpoints_[xm + y + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x40;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
+            if (xp < mmax_x_) {
+                this_s = pSurfaces[xp + y + z];
+                upper_s = pSurfaces[xp + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = xp + y + zp;
+                    sdirh |= 0x04;
+                    ops.request(nxtfp, xp, y, zp);
+                } else if (this_s == 0x01) {
+                    nxtfp = xp + y + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x04;
+                        ops.request(nxtfp, xp, y, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
 
-                        if (xp < mmax_x_) {
-                            this_s = mtsurfaces_[xp + y + z];
-                            upper_s = mtsurfaces_[xp + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[xp + y + zp]);
-                                sdirh |= 0x04;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x01) {
-                                nxtfp = &(mdpoints_[xp + y + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x04;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+            break;
+        case 0x02:
+            ops.setDesc(cfp, m_fdWalkable);
+            ops.orDesc(cfp, m_fdSafeWalk);
+            if (zm >= 0) {
+                ops.setDesc(x + y + zm, m_fdNonWalkable);
+                if (ym >= 0) {
+                    this_s = pSurfaces[x + ym + zm];
+                    upper_s = pSurfaces[x + ym + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = x + ym + z;
+                        sdirm |= 0x10;
+                        ops.request(nxtfp, x, ym, z);
+                    } else if (this_s == 0x02) {
+                        nxtfp = x + ym + zm;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x10;
+                            ops.request(nxtfp, x, ym, zm);
+                        } else
+                            ops.setDesc(nxtfp, m_fdNonWalkable);
+                    }
+                }
+                if (xm >= 0) {
+                    this_s = pSurfaces[xm + y + zm];
+                    upper_s = pSurfaces[xm + y + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = xm + y + z;
+                        sdirm |= 0x40;
+                        ops.request(nxtfp, xm, y, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = xm + y + zm;
+                        ops.request(nxtfp, xm, y, zm);
+                    }
+                }
+                if (xp < mmax_x_) {
+                    this_s = pSurfaces[xp + y + zm];
+                    upper_s = pSurfaces[xp + y + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = xp + y + z;
+                        sdirm |= 0x04;
+                        ops.request(nxtfp, xp, y, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = xp + y + zm;
+                        ops.request(nxtfp, xp, y, zm);
+                    }
+                }
+            }
 
-                        break;
-                    case 0x02:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        cfp->bfNodeDesc |= m_fdSafeWalk;
-                        if (zm >= 0) {
-                            mdpoints_[x + y + zm].bfNodeDesc = m_fdNonWalkable;
-                            if (ym >= 0) {
-                                this_s = mtsurfaces_[x + ym + zm];
-                                upper_s = mtsurfaces_[x + ym + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    sdirm |= 0x10;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (this_s == 0x02) {
-                                    nxtfp = &(mdpoints_[x + ym + zm]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x10;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = zm;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    } else
-                                        nxtfp->bfNodeDesc = m_fdNonWalkable;
-                                }
-                            }
-                            if (xm >= 0) {
-                                this_s = mtsurfaces_[xm + y + zm];
-                                upper_s = mtsurfaces_[xm + y + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    sdirm |= 0x40;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                            if (xp < mmax_x_) {
-                                this_s = mtsurfaces_[xp + y + zm];
-                                upper_s = mtsurfaces_[xp + y + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[xp + y + z]);
-                                    sdirm |= 0x04;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[xp + y + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                        }
+            if (yp < mmax_m_xy) {
+                nxtfp = x + yp + zp;
+                this_s = pSurfaces[x + yp + z];
+                upper_s = pSurfaces[x + yp + zp];
+                if(isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    sdirh |= 0x01;
+                    ops.request(nxtfp, x, yp, zp);
+                } else if(upper_s == 0x02 && (zp + mmax_m_xy) < mmax_m_all) {
+                    if(sWalkable(upper_s,  pSurfaces[
+                        x + yp + (zp + mmax_m_xy)]))
+                    {
+                        sdirh |= 0x01;
+                        ops.request(nxtfp, x, yp, zp);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (yp < mmax_m_xy) {
-                            nxtfp = &(mdpoints_[x + yp + zp]);
-                            this_s = mtsurfaces_[x + yp + z];
-                            upper_s = mtsurfaces_[x + yp + zp];
-                            if(isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                sdirh |= 0x01;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if(upper_s == 0x02 && (zp + mmax_m_xy) < mmax_m_all) {
-                                if(sWalkable(upper_s,  mtsurfaces_[
-                                    x + yp + (zp + mmax_m_xy)]))
-                                {
-                                    sdirh |= 0x01;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = zp;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
+            if (xm >= 0) {
+                this_s = pSurfaces[xm + y + z];
+                upper_s = pSurfaces[xm + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = xm + y + zp;
+                    sdirh |= 0x40;
+                    ops.request(nxtfp, xm, y, zp);
+                } else if (this_s == 0x02) {
+                    nxtfp = xm + y + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x40;
+                        ops.request(nxtfp, xm, y, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (xm >= 0) {
-                            this_s = mtsurfaces_[xm + y + z];
-                            upper_s = mtsurfaces_[xm + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[xm + y + zp]);
-                                sdirh |= 0x40;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x02) {
-                                nxtfp = &(mdpoints_[xm + y + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x40;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
+            if (xp < mmax_x_) {
+                this_s = pSurfaces[xp + y + z];
+                upper_s = pSurfaces[xp + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = xp + y + zp;
+                    sdirh |= 0x04;
+                    ops.request(nxtfp, xp, y, zp);
+                } else if (this_s == 0x02) {
+                    nxtfp = xp + y + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x04;
+                        ops.request(nxtfp, xp, y, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
 
-                        if (xp < mmax_x_) {
-                            this_s = mtsurfaces_[xp + y + z];
-                            upper_s = mtsurfaces_[xp + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[xp + y + zp]);
-                                sdirh |= 0x04;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x02) {
-                                nxtfp = &(mdpoints_[xp + y + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x04;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+            break;
+        case 0x03:
+            ops.setDesc(cfp, m_fdWalkable);
+            ops.orDesc(cfp, m_fdSafeWalk);
+            if (zm >= 0) {
+                ops.setDesc(x + y + zm, m_fdNonWalkable);
+                if (xm >= 0) {
+                    this_s = pSurfaces[xm + y + zm];
+                    upper_s = pSurfaces[xm + y + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = xm + y + z;
+                        sdirm |= 0x40;
+                        ops.request(nxtfp, xm, y, z);
+                    } else if (this_s == 0x03) {
+                        nxtfp = xm + y + zm;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x40;
+                            ops.request(nxtfp, xm, y, zm);
+                        } else
+                            ops.setDesc(nxtfp, m_fdNonWalkable);
+                    }
+                }
+                if (ym >= 0) {
+                    this_s = pSurfaces[x + ym + zm];
+                    upper_s = pSurfaces[x + ym + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = x + ym + z;
+                        sdirm |= 0x10;
+                        ops.request(nxtfp, x, ym, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = x + ym + zm;
+                        ops.request(nxtfp, x, ym, zm);
+                    }
+                }
+                if (yp < mmax_m_xy) {
+                    this_s = pSurfaces[x + yp + zm];
+                    upper_s = pSurfaces[x + yp + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = x + yp + z;
+                        sdirm |= 0x01;
+                        ops.request(nxtfp, x, yp, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = x + yp + zm;
+                        ops.request(nxtfp, x, yp, zm);
+                    }
+                }
+            }
 
-                        break;
-                    case 0x03:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        cfp->bfNodeDesc |= m_fdSafeWalk;
-                        if (zm >= 0) {
-                            mdpoints_[x + y + zm].bfNodeDesc = m_fdNonWalkable;
-                            if (xm >= 0) {
-                                this_s = mtsurfaces_[xm + y + zm];
-                                upper_s = mtsurfaces_[xm + y + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    sdirm |= 0x40;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (this_s == 0x03) {
-                                    nxtfp = &(mdpoints_[xm + y + zm]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x40;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = zm;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    } else
-                                        nxtfp->bfNodeDesc = m_fdNonWalkable;
-                                }
-                            }
-                            if (ym >= 0) {
-                                this_s = mtsurfaces_[x + ym + zm];
-                                upper_s = mtsurfaces_[x + ym + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    sdirm |= 0x10;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                            if (yp < mmax_m_xy) {
-                                this_s = mtsurfaces_[x + yp + zm];
-                                upper_s = mtsurfaces_[x + yp + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[x + yp + z]);
-                                    sdirm |= 0x01;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[x + yp + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                        }
+            if (xp < mmax_x_) {
+                nxtfp = xp + y + zp;
+                this_s = pSurfaces[xp + y + z];
+                upper_s = pSurfaces[xp + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    sdirh |= 0x04;
+                    ops.request(nxtfp, xp, y, zp);
+                } else if(upper_s == 0x03 && (zp + mmax_m_xy) < mmax_m_all) {
+                    if(sWalkable(upper_s,
+                        pSurfaces[xp + y + (zp + mmax_m_xy)]))
+                    {
+                        sdirh |= 0x04;
+                        ops.request(nxtfp, xp, y, zp);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (xp < mmax_x_) {
-                            nxtfp = &(mdpoints_[xp + y + zp]);
-                            this_s = mtsurfaces_[xp + y + z];
-                            upper_s = mtsurfaces_[xp + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                sdirh |= 0x04;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if(upper_s == 0x03 && (zp + mmax_m_xy) < mmax_m_all) {
-                                if(sWalkable(upper_s,
-                                    mtsurfaces_[xp + y + (zp + mmax_m_xy)]))
-                                {
-                                    sdirh |= 0x04;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = zp;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
+            if (ym >= 0) {
+                this_s = pSurfaces[x + ym + z];
+                upper_s = pSurfaces[x + ym + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = x + ym + zp;
+                    sdirh |= 0x10;
+                    ops.request(nxtfp, x, ym, zp);
+                } else if (this_s == 0x03) {
+                    nxtfp = x + ym + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x10;
+                        ops.request(nxtfp, x, ym, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (ym >= 0) {
-                            this_s = mtsurfaces_[x + ym + z];
-                            upper_s = mtsurfaces_[x + ym + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[x + ym + zp]);
-                                sdirh |= 0x10;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x03) {
-                                nxtfp = &(mdpoints_[x + ym + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x10;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
+            if (yp < mmax_m_xy) {
+                this_s = pSurfaces[x + yp + z];
+                upper_s = pSurfaces[x + yp + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = x + yp + zp;
+                    sdirh |= 0x01;
+                    ops.request(nxtfp, x, yp, zp);
+                } else if (this_s == 0x03) {
+                    nxtfp = x + yp + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x01;
+                        ops.request(nxtfp, x, yp, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
 
-                        if (yp < mmax_m_xy) {
-                            this_s = mtsurfaces_[x + yp + z];
-                            upper_s = mtsurfaces_[x + yp + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[x + yp + zp]);
-                                sdirh |= 0x01;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x03) {
-                                nxtfp = &(mdpoints_[x + yp + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x01;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
-                        }
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+            break;
+        case 0x04:
+            ops.setDesc(cfp, m_fdWalkable);
+            ops.orDesc(cfp, m_fdSafeWalk);
+            if (zm >= 0) {
+                ops.setDesc(x + y + zm, m_fdNonWalkable);
+                if (xp < mmax_x_) {
+                    this_s = pSurfaces[xp + y + zm];
+                    upper_s = pSurfaces[xp + y + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = xp + y + z;
+                        sdirm |= 0x04;
+                        ops.request(nxtfp, xp, y, z);
+                    } else if (this_s == 0x04) {
+                        nxtfp = xp + y + zm;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x04;
+                            ops.request(nxtfp, xp, y, zm);
+                        } else
+                            ops.setDesc(nxtfp, m_fdNonWalkable);
+                    }
+                }
+                if (ym >= 0) {
+                    this_s = pSurfaces[x + ym + zm];
+                    upper_s = pSurfaces[x + ym + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = x + ym + z;
+                        sdirm |= 0x10;
+                        ops.request(nxtfp, x, ym, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = x + ym + zm;
+                        ops.request(nxtfp, x, ym, zm);
+                    }
+                }
+                if (yp < mmax_m_xy) {
+                    this_s = pSurfaces[x + yp + zm];
+                    upper_s = pSurfaces[x + yp + z];
+                    if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                        nxtfp = x + yp + z;
+                        sdirm |= 0x01;
+                        ops.request(nxtfp, x, yp, z);
+                    } else if (isStairs(this_s)) {
+                        nxtfp = x + yp + zm;
+                        ops.request(nxtfp, x, yp, zm);
+                    }
+                }
+            }
 
-                        break;
-                    case 0x04:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        cfp->bfNodeDesc |= m_fdSafeWalk;
-                        if (zm >= 0) {
-                            mdpoints_[x + y + zm].bfNodeDesc = m_fdNonWalkable;
-                            if (xp < mmax_x_) {
-                                this_s = mtsurfaces_[xp + y + zm];
-                                upper_s = mtsurfaces_[xp + y + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[xp + y + z]);
-                                    sdirm |= 0x04;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xp;
-                                        stodef.y = y;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (this_s == 0x04) {
-                                    nxtfp = &(mdpoints_[xp + y + zm]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x04;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xp;
-                                            stodef.y = y;
-                                            stodef.z = zm;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    } else
-                                        nxtfp->bfNodeDesc = m_fdNonWalkable;
-                                }
-                            }
-                            if (ym >= 0) {
-                                this_s = mtsurfaces_[x + ym + zm];
-                                upper_s = mtsurfaces_[x + ym + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    sdirm |= 0x10;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                            if (yp < mmax_m_xy) {
-                                this_s = mtsurfaces_[x + yp + zm];
-                                upper_s = mtsurfaces_[x + yp + z];
-                                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                    nxtfp = &(mdpoints_[x + yp + z]);
-                                    sdirm |= 0x01;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else if (isStairs(this_s)) {
-                                    nxtfp = &(mdpoints_[x + yp + zm]);
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = zm;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                }
-                            }
-                        }
+            if (xm >= 0) {
+                nxtfp = xm + y + zp;
+                this_s = pSurfaces[xm + y + z];
+                upper_s = pSurfaces[xm + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    sdirh |= 0x40;
+                    ops.request(nxtfp, xm, y, zp);
+                } else if(upper_s == 0x04 && (zp + mmax_m_xy) < mmax_m_all) {
+                    if(sWalkable(upper_s, pSurfaces[
+                        xm + y + (zp + mmax_m_xy)]))
+                    {
+                        sdirh |= 0x40;
+                        ops.request(nxtfp, xm, y, zp);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
 
-                        if (xm >= 0) {
-                            nxtfp = &(mdpoints_[xm + y + zp]);
-                            this_s = mtsurfaces_[xm + y + z];
-                            upper_s = mtsurfaces_[xm + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                sdirh |= 0x40;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if(upper_s == 0x04 && (zp + mmax_m_xy) < mmax_m_all) {
-                                if(sWalkable(upper_s, mtsurfaces_[
-                                    xm + y + (zp + mmax_m_xy)]))
-                                {
-                                    sdirh |= 0x40;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = xm;
-                                        stodef.y = y;
-                                        stodef.z = zp;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
+            if (ym >= 0) {
+                this_s = pSurfaces[x + ym + z];
+                upper_s = pSurfaces[x + ym + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = x + ym + zp;
+                    sdirh |= 0x10;
+                    ops.request(nxtfp, x, ym, zp);
+                } else if (this_s == 0x04) {
+                    nxtfp = x + ym + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x10;
+                        ops.request(nxtfp, x, ym, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
+
+            if (yp < mmax_m_xy) {
+                this_s = pSurfaces[x + yp + z];
+                upper_s = pSurfaces[x + yp + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
+                    nxtfp = x + yp + zp;
+                    sdirh |= 0x01;
+                    ops.request(nxtfp, x, yp, zp);
+                } else if (this_s == 0x04) {
+                    nxtfp = x + yp + z;
+                    if (sWalkable(this_s, upper_s)) {
+                        sdirm |= 0x01;
+                        ops.request(nxtfp, x, yp, z);
+                    } else
+                        ops.setDesc(nxtfp, m_fdNonWalkable);
+                }
+            }
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
+
+            break;
+        case 0x05:
+        case 0x06:
+        case 0x07:
+        case 0x08:
+        case 0x09:
+        case 0x0B:
+        case 0x0D:
+        case 0x0E:
+        case 0x0F:
+            ops.setDesc(cfp, m_fdWalkable);
+            if (!((this_s > 0x05 && this_s < 0x0A) || this_s == 0x0B
+                || this_s == 0x0F))
+            {
+                ops.orDesc(cfp, m_fdSafeWalk);
+            }
+            if (xm >= 0) {
+                this_s = pSurfaces[xm + y + z];
+                upper_s = pSurfaces[xm + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x20 | 0x40 | 0x80);
+                    nxtfp = xm + y + zp;
+                    ops.request(nxtfp, xm, y, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x20 | 0x80);
+                    if (this_s == 0x01 || this_s == 0x02
+                        || this_s == 0x03)
+                    {
+                        sdirl |= 0x40;
+                    }
+                    nxtfp = xm + y + z;
+                    ops.request(nxtfp, xm, y, z);
+                } else {
+                    sdirmr |= (0x20 | 0x80);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x02 || upper_s == 0x04
+                        || upper_s == 0x12)) {
+                        if (sWalkable(upper_s,
+                            pSurfaces[xm + y + (zp + mmax_m_xy)]))
+                        {
+                            if (upper_s == 0x12)
+                                sdirh |= 0x40;
+                            else
+                                sdirm |= 0x40;
+                            nxtfp = xm + y + zp;
+                            ops.request(nxtfp, xm, y, zp);
                         }
+                    }
+                }
+            } else
+                sdirmr |= (0x20 | 0x80);
+
+            if (xp < mmax_x_) {
+                this_s = pSurfaces[xp + y + z];
+                upper_s = pSurfaces[xp + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x02 | 0x04 | 0x08);
+                    nxtfp = xp + y + zp;
+                    ops.request(nxtfp, xp, y, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x02 | 0x08);
+                    if (this_s == 0x01 || this_s == 0x02
+                        || this_s == 0x04)
+                    {
+                        sdirl |= 0x04;
+                    }
+                    nxtfp = xp + y + z;
+                    ops.request(nxtfp, xp, y, z);
+                } else {
+                    sdirmr |= (0x02 | 0x08);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x02
+                        || upper_s == 0x03 || upper_s == 0x11))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[xp + y + (zp + mmax_m_xy)]))
+                        {
+                            if (upper_s == 0x11)
+                                sdirh |= 0x04;
+                            else
+                                sdirm |= 0x04;
+                            nxtfp = xp + y + zp;
+                            ops.request(nxtfp, xp, y, zp);
+                        }
+                    }
+                }
+            } else
+                sdirmr |= (0x02 | 0x08);
 
-                        if (ym >= 0) {
-                            this_s = mtsurfaces_[x + ym + z];
-                            upper_s = mtsurfaces_[x + ym + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[x + ym + zp]);
+            if(ym >= 0) {
+                this_s = pSurfaces[x + ym + z];
+                upper_s = pSurfaces[x + ym + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x08 | 0x10 | 0x20);
+                    nxtfp = x + ym + zp;
+                    ops.request(nxtfp, x, ym, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x08 | 0x20);
+                    if (this_s == 0x02 || this_s == 0x03 || this_s == 0x04){
+                        sdirl |= 0x10;
+                    }
+                    nxtfp = x + ym + z;
+                    ops.request(nxtfp, x, ym, z);
+                } else {
+                    sdirmr |= (0x08 | 0x20);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x03
+                        || upper_s == 0x04 || upper_s == 0x11))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[x + ym + (zp + mmax_m_xy)]))
+                        {
+                            if (upper_s == 0x11)
                                 sdirh |= 0x10;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x04) {
-                                nxtfp = &(mdpoints_[x + ym + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x10;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = ym;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
+                            else
+                                sdirm |= 0x10;
+                            nxtfp = x + ym + zp;
+                            ops.request(nxtfp, x, ym, zp);
                         }
+                    }
+                }
+            } else
+                sdirmr |= (0x08 | 0x20);
 
-                        if (yp < mmax_m_xy) {
-                            this_s = mtsurfaces_[x + yp + z];
-                            upper_s = mtsurfaces_[x + yp + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s)) {
-                                nxtfp = &(mdpoints_[x + yp + zp]);
+            if (yp < mmax_m_xy) {
+                this_s = pSurfaces[x + yp + z];
+                upper_s = pSurfaces[x + yp + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x80 | 0x01 | 0x02);
+                    nxtfp = x + yp + zp;
+                    ops.request(nxtfp, x, yp, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x80 | 0x02);
+                    if (this_s == 0x01 || this_s == 0x03
+                        || this_s == 0x04)
+                    {
+                        sdirl |= 0x01;
+                    }
+                    nxtfp = x + yp + z;
+                    ops.request(nxtfp, x, yp, z);
+                } else {
+                    sdirmr |= (0x80 | 0x02);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x02 || upper_s == 0x03
+                        || upper_s == 0x04 || upper_s == 0x12))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[x + yp + (zp + mmax_m_xy)]))
+                        {
+                            if (upper_s == 0x12)
                                 sdirh |= 0x01;
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (this_s == 0x04) {
-                                nxtfp = &(mdpoints_[x + yp + z]);
-                                if (sWalkable(this_s, upper_s)) {
-                                    sdirm |= 0x01;
-                                    if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                        nxtfp->bfNodeDesc = m_fdDefReq;
-                                        stodef.x = x;
-                                        stodef.y = yp;
-                                        stodef.z = z;
-                                        vtodefine.push_back(stodef);
-                                    }
-                                } else
-                                    nxtfp->bfNodeDesc = m_fdNonWalkable;
-                            }
+                            else
+                                sdirm |= 0x01;
+                            nxtfp = x + yp + zp;
+                            ops.request(nxtfp, x, yp, zp);
                         }
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+                    }
+                }
+            } else
+                sdirmr |= (0x80 | 0x02);
+            sdirm &= (0xFF ^ sdirmr);
+
+            // edges
+
+            if (xm >= 0) {
+                if (ym >= 0 && (sdirm & 0x20) != 0) {
+                    nxtfp = xm + ym + zp;
+                    this_s = pSurfaces[xm + ym + z];
+                    upper_s = pSurfaces[xm + ym + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x20);
+                    } else {
+                        ops.request(nxtfp, xm, ym, zp);
+                    }
+                }
 
-                        break;
-                    case 0x05:
-                    case 0x06:
-                    case 0x07:
-                    case 0x08:
-                    case 0x09:
-                    case 0x0B:
-                    case 0x0D:
-                    case 0x0E:
-                    case 0x0F:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        if (!((this_s > 0x05 && this_s < 0x0A) || this_s == 0x0B
-                            || this_s == 0x0F))
+                if (yp < mmax_m_xy && (sdirm & 0x80) != 0) {
+                    nxtfp = xm + yp + zp;
+                    this_s = pSurfaces[xm + yp + z];
+                    upper_s = pSurfaces[xm + yp + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x80);
+                    } else {
+                        ops.request(nxtfp, xm, yp, zp);
+                    }
+                }
+            }
+
+            if (xp < mmax_x_) {
+                if (ym >= 0 && (sdirm & 0x08) != 0) {
+                    nxtfp = xp + ym + zp;
+                    this_s = pSurfaces[xp + ym + z];
+                    upper_s = pSurfaces[xp + ym + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x08);
+                    } else {
+                        ops.request(nxtfp, xp, ym, zp);
+                    }
+                }
+
+                if (yp < mmax_m_xy && (sdirm & 0x02) != 0) {
+                    nxtfp = xp + yp + zp;
+                    this_s = pSurfaces[xp + yp + z];
+                    upper_s = pSurfaces[xp + yp + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x02);
+                    } else {
+                        ops.request(nxtfp, xp, yp, zp);
+                    }
+                }
+            }
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
+
+            break;
+        case 0x0A:
+        case 0x0C:
+        case 0x10:
+            ops.setDesc(cfp, m_fdNonWalkable);
+            break;
+        case 0x11:
+            ops.setDesc(cfp, m_fdWalkable);
+            ops.orDesc(cfp, m_fdSafeWalk);
+            if (zm >= 0) {
+                ops.setDesc(x + y + zm, m_fdNonWalkable);
+                if (xm >= 0) {
+                    this_s = pSurfaces[xm + y + zm];
+                    upper_s = pSurfaces[xm + y + z];
+                    if (isSurface(this_s)) {
+                        nxtfp = xm + y + z;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x40;
+                            ops.request(nxtfp, xm, y, z);
+                        }
+                    } else if (isStairs(upper_s) && upper_s != 0x04) {
+                        nxtfp = xm + y + z;
+                        this_s = upper_s;
+                        upper_s = pSurfaces[xm + y + zp];
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x40;
+                            ops.request(nxtfp, xm, y, z);
+                        }
+                    }
+                }
+                if (ym >= 0) {
+                    this_s = pSurfaces[x + ym + zm];
+                    upper_s = pSurfaces[x + ym + z];
+                    if (isSurface(this_s)) {
+                        nxtfp = x + ym + z;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x10;
+                            ops.request(nxtfp, x, ym, z);
+                        }
+                    } else if (isStairs(upper_s) && upper_s != 0x01) {
+                        nxtfp = x + ym + z;
+                        this_s = upper_s;
+                        upper_s = pSurfaces[x + ym + zp];
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x10;
+                            ops.request(nxtfp, x, ym, z);
+                        }
+                    }
+                }
+                if (yp < mmax_m_xy) {
+                    this_s = pSurfaces[x + yp + zm];
+                    upper_s = pSurfaces[x + yp + z];
+                    if (isSurface(this_s)) {
+                        nxtfp = x + yp + z;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x01;
+                            ops.request(nxtfp, x, yp, z);
+                        }
+                    } else if (isStairs(upper_s) && upper_s != 0x02) {
+                        nxtfp = x + yp + z;
+                        this_s = upper_s;
+                        upper_s = pSurfaces[x + yp + zp];
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x01;
+                            ops.request(nxtfp, x, yp, z);
+                        }
+                    }
+                }
+            }
+
+            if (xp < mmax_x_) {
+                this_s = pSurfaces[xp + y + z];
+                upper_s = pSurfaces[xp + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x02 | 0x04 | 0x08);
+                    nxtfp = xp + y + zp;
+                    ops.request(nxtfp, xp, y, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x02 | 0x08);
+                    if (this_s == 0x01 || this_s == 0x02 || this_s == 0x04){
+                        sdirl |= 0x04;
+                    }
+                    nxtfp = xp + y + z;
+                    ops.request(nxtfp, xp, y, z);
+                } else {
+                    sdirmr |= (0x02 | 0x08);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x02
+                        || upper_s == 0x03))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[xp + y + (zp + mmax_m_xy)]))
                         {
-                            cfp->bfNodeDesc |= m_fdSafeWalk;
+                            sdirm |= 0x04;
+                            nxtfp = xp + y + zp;
+                            ops.request(nxtfp, xp, y, zp);
                         }
-                        if (xm >= 0) {
-                            this_s = mtsurfaces_[xm + y + z];
-                            upper_s = mtsurfaces_[xm + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x20 | 0x40 | 0x80);
-                                nxtfp = &(mdpoints_[xm + y + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x20 | 0x80);
-                                if (this_s == 0x01 || this_s == 0x02
-                                    || this_s == 0x03)
-                                {
-                                    sdirl |= 0x40;
-                                }
-                                nxtfp = &(mdpoints_[xm + y + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x20 | 0x80);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x02 || upper_s == 0x04
-                                    || upper_s == 0x12)) {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[xm + y + (zp + mmax_m_xy)]))
-                                    {
-                                        if (upper_s == 0x12)
-                                            sdirh |= 0x40;
-                                        else
-                                            sdirm |= 0x40;
-                                        nxtfp = &(mdpoints_[xm + y + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x20 | 0x80);
+                    }
+                }
+            } else
+                sdirmr |= (0x02 | 0x08);
 
-                        if (xp < mmax_x_) {
-                            this_s = mtsurfaces_[xp + y + z];
-                            upper_s = mtsurfaces_[xp + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x02 | 0x04 | 0x08);
-                                nxtfp = &(mdpoints_[xp + y + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x02 | 0x08);
-                                if (this_s == 0x01 || this_s == 0x02
-                                    || this_s == 0x04)
-                                {
-                                    sdirl |= 0x04;
-                                }
-                                nxtfp = &(mdpoints_[xp + y + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x02 | 0x08);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x02
-                                    || upper_s == 0x03 || upper_s == 0x11))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[xp + y + (zp + mmax_m_xy)]))
-                                    {
-                                        if (upper_s == 0x11)
-                                            sdirh |= 0x04;
-                                        else
-                                            sdirm |= 0x04;
-                                        nxtfp = &(mdpoints_[xp + y + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xp;
-                                            stodef.y = y;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x02 | 0x08);
+            if(ym >= 0) {
+                this_s = pSurfaces[x + ym + z];
+                upper_s = pSurfaces[x + ym + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x08 | 0x10);
+                    nxtfp = x + ym + zp;
+                    ops.request(nxtfp, x, ym, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x08 | 0x20);
+                    if (this_s == 0x02 || this_s == 0x03 || this_s == 0x04) {
+                        sdirl |= 0x10;
+                    }
+                    nxtfp = x + ym + z;
+                    ops.request(nxtfp, x, ym, z);
+                } else {
+                    sdirmr |= (0x08 | 0x20);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x03 || upper_s == 0x04)) {
+                        if (sWalkable(upper_s,
+                            pSurfaces[x + ym + (zp + mmax_m_xy)]))
+                        {
+                            sdirm |= 0x10;
+                            nxtfp = x + ym + zp;
+                            ops.request(nxtfp, x, ym, zp);
+                        }
+                    }
+                }
+            } else
+                sdirmr |= (0x08);
 
-                        if(ym >= 0) {
-                            this_s = mtsurfaces_[x + ym + z];
-                            upper_s = mtsurfaces_[x + ym + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x08 | 0x10 | 0x20);
-                                nxtfp = &(mdpoints_[x + ym + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x08 | 0x20);
-                                if (this_s == 0x02 || this_s == 0x03 || this_s == 0x04){
-                                    sdirl |= 0x10;
-                                }
-                                nxtfp = &(mdpoints_[x + ym + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x08 | 0x20);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x03
-                                    || upper_s == 0x04 || upper_s == 0x11))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[x + ym + (zp + mmax_m_xy)]))
-                                    {
-                                        if (upper_s == 0x11)
-                                            sdirh |= 0x10;
-                                        else
-                                            sdirm |= 0x10;
-                                        nxtfp = &(mdpoints_[x + ym + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x08 | 0x20);
+            if (yp < mmax_m_xy) {
+                this_s = pSurfaces[x + yp + z];
+                upper_s = pSurfaces[x + yp + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x01 | 0x02);
+                    nxtfp = x + yp + zp;
+                    ops.request(nxtfp, x, yp, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x80 | 0x02);
+                    if (this_s == 0x01 || this_s == 0x03 || this_s == 0x04) {
+                        sdirl |= 0x01;
+                    }
+                    nxtfp = x + yp + z;
+                    ops.request(nxtfp, x, yp, z);
+                } else {
+                    sdirmr |= (0x80 | 0x02);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x02 || upper_s == 0x03
+                        || upper_s == 0x04))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[x + yp + (zp + mmax_m_xy)]))
+                        {
+                            sdirm |= 0x01;
+                            nxtfp = x + yp + zp;
+                            ops.request(nxtfp, x, yp, zp);
+                        }
+                    }
+                }
+            } else
+                sdirmr |= (0x80 | 0x02);
+            sdirm &= (0xFF ^ sdirmr);
+
+            // edges
+            if (xp < mmax_x_) {
+                if (ym >= 0 && (sdirm & 0x08) != 0) {
+                    nxtfp = xp + ym + zp;
+                    this_s = pSurfaces[xp + ym + z];
+                    upper_s = pSurfaces[xp + ym + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x08);
+                    } else {
+                        ops.request(nxtfp, xp, ym, zp);
+                    }
+                }
 
-                        if (yp < mmax_m_xy) {
-                            this_s = mtsurfaces_[x + yp + z];
-                            upper_s = mtsurfaces_[x + yp + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x80 | 0x01 | 0x02);
-                                nxtfp = &(mdpoints_[x + yp + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x80 | 0x02);
-                                if (this_s == 0x01 || this_s == 0x03
-                                    || this_s == 0x04)
-                                {
-                                    sdirl |= 0x01;
-                                }
-                                nxtfp = &(mdpoints_[x + yp + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x80 | 0x02);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x02 || upper_s == 0x03
-                                    || upper_s == 0x04 || upper_s == 0x12))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[x + yp + (zp + mmax_m_xy)]))
-                                    {
-                                        if (upper_s == 0x12)
-                                            sdirh |= 0x01;
-                                        else
-                                            sdirm |= 0x01;
-                                        nxtfp = &(mdpoints_[x + yp + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = yp;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x80 | 0x02);
-                        sdirm &= (0xFF ^ sdirmr);
-
-                        // edges
-
-                        if (xm >= 0) {
-                            if (ym >= 0 && (sdirm & 0x20) != 0) {
-                                nxtfp = &(mdpoints_[xm + ym + zp]);
-                                this_s = mtsurfaces_[xm + ym + z];
-                                upper_s = mtsurfaces_[xm + ym + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x20);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
+                if (yp < mmax_m_xy && (sdirm & 0x02) != 0) {
+                    nxtfp = xp + yp + zp;
+                    this_s = pSurfaces[xp + yp + z];
+                    upper_s = pSurfaces[xp + yp + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x02);
+                    } else {
+                        ops.request(nxtfp, xp, yp, z);
+                    }
+                }
+            }
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
 
-                            if (yp < mmax_m_xy && (sdirm & 0x80) != 0) {
-                                nxtfp = &(mdpoints_[xm + yp + zp]);
-                                this_s = mtsurfaces_[xm + yp + z];
-                                upper_s = mtsurfaces_[xm + yp + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x80);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
+            break;
+        case 0x12:
+            ops.setDesc(cfp, m_fdWalkable);
+            ops.orDesc(cfp, m_fdSafeWalk);
+            if (zm >= 0) {
+                ops.setDesc(x + y + zm, m_fdNonWalkable);
+                if (ym >= 0) {
+                    this_s = pSurfaces[x + ym + zm];
+                    upper_s = pSurfaces[x + ym + z];
+                    if (isSurface(this_s)) {
+                        nxtfp = x + ym + z;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x10;
+                            ops.request(nxtfp, x, ym, z);
+                        }
+                    } else if (isStairs(upper_s) && upper_s != 0x01) {
+                        nxtfp = x + ym + z;
+                        this_s = upper_s;
+                        upper_s = pSurfaces[x + ym + zp];
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x10;
+                            ops.request(nxtfp, x, ym, z);
                         }
+                    }
+                }
+                if (xm >= 0) {
+                    this_s = pSurfaces[xm + y + zm];
+                    upper_s = pSurfaces[xm + y + z];
+                    if (isSurface(this_s)) {
+                        nxtfp = xm + y + z;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x40;
+                            ops.request(nxtfp, xm, y, z);
+                        }
+                    } else if (isStairs(upper_s) && upper_s != 0x04) {
+                        nxtfp = xm + y + z;
+                        this_s = upper_s;
+                        upper_s = pSurfaces[xm + y + zp];
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x40;
+                            ops.request(nxtfp, xm, y, z);
+                        }
+                    }
+                }
+                if (xp < mmax_x_) {
+                    this_s = pSurfaces[xp + y + zm];
+                    upper_s = pSurfaces[xp + y + z];
+                    if (isSurface(this_s)) {
+                        nxtfp = xp + y + z;
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x04;
+                            ops.request(nxtfp, xp, y, z);
+                        }
+                    } else if (isStairs(upper_s) && upper_s != 0x03) {
+                        nxtfp = xp + y + z;
+                        this_s = upper_s;
+                        upper_s = pSurfaces[xp + y + zp];
+                        if (sWalkable(this_s, upper_s)) {
+                            sdirl |= 0x04;
+                            ops.request(nxtfp, xp, y, z);
+                        }
+                    }
+                }
+            }
 
-                        if (xp < mmax_x_) {
-                            if (ym >= 0 && (sdirm & 0x08) != 0) {
-                                nxtfp = &(mdpoints_[xp + ym + zp]);
-                                this_s = mtsurfaces_[xp + ym + z];
-                                upper_s = mtsurfaces_[xp + ym + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x08);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
+            if (xm >=0) {
+                this_s = pSurfaces[xm + y + z];
+                upper_s = pSurfaces[xm + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x40 | 0x80);
+                    nxtfp = xm + y + zp;
+                    ops.request(nxtfp, xm, y, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x20 | 0x80);
+                    if (this_s == 0x01 || this_s == 0x02 || this_s == 0x03){
+                        sdirl |= 0x40;
+                    }
+                    nxtfp = xm + y + z;
+                    ops.request(nxtfp, xm, y, z);
+                } else {
+                    sdirmr |= (0x20 | 0x80);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x02
+                        || upper_s == 0x04))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[xm + y + (zp + mmax_m_xy)]))
+                        {
+                            sdirm |= 0x40;
+                            nxtfp = xm + y + zp;
+                            ops.request(nxtfp, xm, y, zp);
+                        }
+                    }
+                }
+            } else
+                sdirmr |= (0x20 | 0x80);
 
-                            if (yp < mmax_m_xy && (sdirm & 0x02) != 0) {
-                                nxtfp = &(mdpoints_[xp + yp + zp]);
-                                this_s = mtsurfaces_[xp + yp + z];
-                                upper_s = mtsurfaces_[xp + yp + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x02);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
+            if (xp < mmax_x_) {
+                this_s = pSurfaces[xp + y + z];
+                upper_s = pSurfaces[xp + y + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x02 | 0x04);
+                    nxtfp = xp + y + zp;
+                    ops.request(nxtfp, xp, y, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x02 | 0x08);
+                    if (this_s == 0x01 || this_s == 0x02
+                        || this_s == 0x04)
+                    {
+                        sdirl |= 0x04;
+                    }
+                    nxtfp = xp + y + z;
+                    ops.request(nxtfp, xp, y, z);
+                } else {
+                    sdirmr |= (0x02 | 0x08);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x01 || upper_s == 0x02
+                        || upper_s == 0x03))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[xp + y + (zp + mmax_m_xy)]))
+                        {
+                            sdirm |= 0x04;
+                            nxtfp = xp + y + zp;
+                            ops.request(nxtfp, xp, y, zp);
                         }
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+                    }
+                }
+            } else
+                sdirmr |= (0x02 | 0x08);
 
-                        break;
-                    case 0x0A:
-                    case 0x0C:
-                    case 0x10:
-                        cfp->bfNodeDesc = m_fdNonWalkable;
-                        break;
-                    case 0x11:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        cfp->bfNodeDesc |= m_fdSafeWalk;
-                        if (zm >= 0) {
-                            mdpoints_[x + y + zm].bfNodeDesc = m_fdNonWalkable;
-                            if (xm >= 0) {
-                                this_s = mtsurfaces_[xm + y + zm];
-                                upper_s = mtsurfaces_[xm + y + z];
-                                if (isSurface(this_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x40;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                } else if (isStairs(upper_s) && upper_s != 0x04) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    this_s = upper_s;
-                                    upper_s = mtsurfaces_[xm + y + zp];
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x40;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                            if (ym >= 0) {
-                                this_s = mtsurfaces_[x + ym + zm];
-                                upper_s = mtsurfaces_[x + ym + z];
-                                if (isSurface(this_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x10;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                } else if (isStairs(upper_s) && upper_s != 0x01) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    this_s = upper_s;
-                                    upper_s = mtsurfaces_[x + ym + zp];
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x10;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                            if (yp < mmax_m_xy) {
-                                this_s = mtsurfaces_[x + yp + zm];
-                                upper_s = mtsurfaces_[x + yp + z];
-                                if (isSurface(this_s)) {
-                                    nxtfp = &(mdpoints_[x + yp + z]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x01;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = yp;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                } else if (isStairs(upper_s) && upper_s != 0x02) {
-                                    nxtfp = &(mdpoints_[x + yp + z]);
-                                    this_s = upper_s;
-                                    upper_s = mtsurfaces_[x + yp + zp];
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x01;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = yp;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
+            if (yp < mmax_m_xy) {
+                this_s = pSurfaces[x + yp + z];
+                upper_s = pSurfaces[x + yp + zp];
+                if (isSurface(this_s) && sWalkable(this_s, upper_s))
+                {
+                    sdirm |= (0x80 | 0x01 | 0x02);
+                    nxtfp = x + yp + zp;
+                    ops.request(nxtfp, x, yp, zp);
+                } else if (isStairs(this_s) && sWalkable(this_s,
+                    upper_s))
+                {
+                    sdirmr |= (0x80 | 0x02);
+                    if (this_s == 0x01 || this_s == 0x03 || this_s == 0x04) {
+                        sdirl |= 0x01;
+                    }
+                    nxtfp = x + yp + z;
+                    ops.request(nxtfp, x, yp, z);
+                } else {
+                    sdirmr |= (0x80 | 0x02);
+                    if ((zp + mmax_m_xy) < mmax_m_all
+                        && (upper_s == 0x02 || upper_s == 0x03
+                        || upper_s == 0x04))
+                    {
+                        if (sWalkable(upper_s,
+                            pSurfaces[x + yp + (zp + mmax_m_xy)]))
+                        {
+                            sdirm |= 0x01;
+                            nxtfp = x + yp + zp;
+                            ops.request(nxtfp, x, yp, zp);
                         }
+                    }
+                }
+            } else
+                sdirmr |= (0x80 | 0x02);
+            sdirm &= (0xFF ^ sdirmr);
+
+            // edges
+            if (yp < mmax_m_xy) {
+                if (xm >= 0 && (sdirm & 0x80) != 0) {
+                    nxtfp = xm + yp + zp;
+                    this_s = pSurfaces[xm + yp + z];
+                    upper_s = pSurfaces[xm + yp + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x80);
+                    } else {
+                        ops.request(nxtfp, xm, yp, zp);
+                    }
+                }
+                if (xp < mmax_x_ && (sdirm & 0x02) != 0) {
+                    nxtfp = xp + yp + zp;
+                    this_s = pSurfaces[xp + yp + z];
+                    upper_s = pSurfaces[xp + yp + zp];
+                    if (!(isSurface(this_s) && sWalkable(this_s,
+                        upper_s)))
+                    {
+                        sdirm &= (0xFF ^ 0x02);
+                    } else {
+                        ops.request(nxtfp, xp, yp, zp);
+                    }
+                }
+            }
 
-                        if (xp < mmax_x_) {
-                            this_s = mtsurfaces_[xp + y + z];
-                            upper_s = mtsurfaces_[xp + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x02 | 0x04 | 0x08);
-                                nxtfp = &(mdpoints_[xp + y + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x02 | 0x08);
-                                if (this_s == 0x01 || this_s == 0x02 || this_s == 0x04){
-                                    sdirl |= 0x04;
-                                }
-                                nxtfp = &(mdpoints_[xp + y + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x02 | 0x08);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x02
-                                    || upper_s == 0x03))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[xp + y + (zp + mmax_m_xy)]))
-                                    {
-                                        sdirm |= 0x04;
-                                        nxtfp = &(mdpoints_[xp + y + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xp;
-                                            stodef.y = y;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x02 | 0x08);
+            ops.setDirs(cfp, sdirm, sdirh, sdirl);
 
-                        if(ym >= 0) {
-                            this_s = mtsurfaces_[x + ym + z];
-                            upper_s = mtsurfaces_[x + ym + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x08 | 0x10);
-                                nxtfp = &(mdpoints_[x + ym + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x08 | 0x20);
-                                if (this_s == 0x02 || this_s == 0x03 || this_s == 0x04) {
-                                    sdirl |= 0x10;
-                                }
-                                nxtfp = &(mdpoints_[x + ym + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = ym;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x08 | 0x20);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x03 || upper_s == 0x04)) {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[x + ym + (zp + mmax_m_xy)]))
-                                    {
-                                        sdirm |= 0x10;
-                                        nxtfp = &(mdpoints_[x + ym + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x08);
+            break;
+    }
+}
 
-                        if (yp < mmax_m_xy) {
-                            this_s = mtsurfaces_[x + yp + z];
-                            upper_s = mtsurfaces_[x + yp + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x01 | 0x02);
-                                nxtfp = &(mdpoints_[x + yp + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x80 | 0x02);
-                                if (this_s == 0x01 || this_s == 0x03 || this_s == 0x04) {
-                                    sdirl |= 0x01;
-                                }
-                                nxtfp = &(mdpoints_[x + yp + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x80 | 0x02);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x02 || upper_s == 0x03
-                                    || upper_s == 0x04))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[x + yp + (zp + mmax_m_xy)]))
-                                    {
-                                        sdirm |= 0x01;
-                                        nxtfp = &(mdpoints_[x + yp + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = yp;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x80 | 0x02);
-                        sdirm &= (0xFF ^ sdirmr);
-
-                        // edges
-                        if (xp < mmax_x_) {
-                            if (ym >= 0 && (sdirm & 0x08) != 0) {
-                                nxtfp = &(mdpoints_[xp + ym + zp]);
-                                this_s = mtsurfaces_[xp + ym + z];
-                                upper_s = mtsurfaces_[xp + ym + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x08);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = ym;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
+/*!
+ * Applies the flood writes directly on flood points, visiting tiles
+ * in the order setSurfaces() always used.
+ */
+class FloodWriter {
+public:
+    FloodWriter(floodPointDesc *pPoints) : pPoints_(pPoints) {}
+
+    void setDesc(int indx, uint8 desc) { pPoints_[indx].bfNodeDesc = desc; }
+    void orDesc(int indx, uint8 desc) { pPoints_[indx].bfNodeDesc |= desc; }
+    void setDirs(int indx, uint8 dirm, uint8 dirh, uint8 dirl) {
+        pPoints_[indx].dirm = dirm;
+        pPoints_[indx].dirh = dirh;
+        pPoints_[indx].dirl = dirl;
+    }
+    void request(int indx, int x, int y, int z) {
+        if (pPoints_[indx].bfNodeDesc == m_fdNotDefined) {
+            pPoints_[indx].bfNodeDesc = m_fdDefReq;
+            WorldPoint stodef;
+            stodef.x = x;
+            stodef.y = y;
+            stodef.z = z;
+            toDefine_.push_back(stodef);
+        }
+    }
 
-                            if (yp < mmax_m_xy && (sdirm & 0x02) != 0) {
-                                nxtfp = &(mdpoints_[xp + yp + zp]);
-                                this_s = mtsurfaces_[xp + yp + z];
-                                upper_s = mtsurfaces_[xp + yp + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x02);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = yp;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
-                        }
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+    bool hasNext() { return !toDefine_.empty(); }
+    WorldPoint next() {
+        WorldPoint stodef = toDefine_.back();
+        toDefine_.pop_back();
+        return stodef;
+    }
+
+private:
+    floodPointDesc *pPoints_;
+    std::vector<WorldPoint> toDefine_;
+};
+
+/*!
+ * A flood write recorded by FloodRecorder.
+ */
+struct FloodOp {
+    enum OpType {
+        kSetDesc,
+        kOrDesc,
+        kSetDirs,
+        kRequest
+    };
+
+    /*! Index of the flood point to write.*/
+    int indx;
+    /*! For kRequest, index of the tile to define next.*/
+    int next;
+    uint8 type;
+    /*! Descriptor for kSetDesc and kOrDesc, dirm for kSetDirs.*/
+    uint8 desc;
+    uint8 dirh;
+    uint8 dirl;
+};
 
+/*!
+ * Records the flood writes so they can be replayed by replayFlood().
+ */
+class FloodRecorder {
+public:
+    FloodRecorder(std::vector<FloodOp> &ops) : ops_(ops) {}
+
+    void setDesc(int indx, uint8 desc) { add(FloodOp::kSetDesc, indx, 0, desc, 0, 0); }
+    void orDesc(int indx, uint8 desc) { add(FloodOp::kOrDesc, indx, 0, desc, 0, 0); }
+    void setDirs(int indx, uint8 dirm, uint8 dirh, uint8 dirl) {
+        add(FloodOp::kSetDirs, indx, 0, dirm, dirh, dirl);
+    }
+    void request(int indx, int x, int y, int z) {
+        add(FloodOp::kRequest, indx, x + y + z, 0, 0, 0);
+    }
+
+private:
+    void add(uint8 type, int indx, int next, uint8 desc, uint8 dirh, uint8 dirl) {
+        FloodOp op;
+        op.indx = indx;
+        op.next = next;
+        op.type = type;
+        op.desc = desc;
+        op.dirh = dirh;
+        op.dirl = dirl;
+        ops_.push_back(op);
+    }
+
+    std::vector<FloodOp> &ops_;
+};
+
+/*!
+ * Parameters for a thread that records the flood writes of a range
+ * of z slices.
+ */
+struct FloodSlicesJob {
+    Mission *pMission;
+    const uint8 *pSurfaces;
+    /*! First slice to record.*/
+    int zStart;
+    /*! Slice after the last one to record.*/
+    int zEnd;
+    /*! Writes of all tiles in the slices, tile after tile.*/
+    std::vector<FloodOp> ops;
+    /*! Index in ops of the first write of each tile, plus the end.*/
+    std::vector<int> firstOp;
+};
+
+/*!
+ * Records the flood writes of every tile in the job's slices.
+ * \param data A FloodSlicesJob
+ * \return always 0
+ */
+static int recordFloodSlices(void *data) {
+    FloodSlicesJob *pJob = (FloodSlicesJob *) data;
+    Mission *pMission = pJob->pMission;
+    FloodRecorder recorder(pJob->ops);
+
+    pJob->firstOp.reserve((pJob->zEnd - pJob->zStart) * pMission->mmax_m_xy + 1);
+    for (int iz = pJob->zStart; iz < pJob->zEnd; ++iz) {
+        for (int iy = 0; iy < pMission->mmax_y_; ++iy) {
+            for (int ix = 0; ix < pMission->mmax_x_; ++ix) {
+                pJob->firstOp.push_back(pJob->ops.size());
+                pMission->floodTile(ix, iy * pMission->mmax_x_,
+                    iz * pMission->mmax_m_xy, pJob->pSurfaces, recorder);
+            }
+        }
+    }
+    pJob->firstOp.push_back(pJob->ops.size());
+    return 0;
+}
+
+/*!
+ * Floods the given points from the seeds in a single thread.
+ * This is the order setSurfaces() always used, floodSurfaces()
+ * must give the same result.
+ * \param pSurfaces map-tile surfaces
+ * \param pPoints flood points, all set to m_fdNotDefined
+ * \param seeds Tiles where the flood starts (y and z multiplied)
+ */
+void Mission::floodSurfacesSerial(const uint8 *pSurfaces,
+        floodPointDesc *pPoints, const std::vector<WorldPoint> &seeds) {
+    FloodWriter writer(pPoints);
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        const WorldPoint &seed = seeds[i];
+        writer.request(seed.x + seed.y + seed.z, seed.x, seed.y, seed.z);
+        while (writer.hasNext()) {
+            WorldPoint stodef = writer.next();
+            floodTile(stodef.x, stodef.y, stodef.z, pSurfaces, writer);
+        }
+    }
+}
+
+/*!
+ * Floods mdpoints_ from the seeds.
+ * The writes of every tile are recorded by z slices in nbThreads
+ * threads, then the flood replays the writes of the tiles it reaches,
+ * in the same order as floodSurfacesSerial().
+ * \param seeds Tiles where the flood starts (y and z multiplied)
+ * \param nbThreads Number of threads to use (1 means no threading)
+ */
+void Mission::floodSurfaces(const std::vector<WorldPoint> &seeds, int nbThreads) {
+    if (nbThreads > mmax_z_) {
+        nbThreads = mmax_z_;
+    }
+    if (nbThreads <= 1) {
+        floodSurfacesSerial(mtsurfaces_, mdpoints_, seeds);
+        return;
+    }
+
+    std::vector<FloodSlicesJob> jobs(nbThreads);
+    std::vector<SDL_Thread *> threads(nbThreads, (SDL_Thread *) NULL);
+    // job that recorded each slice
+    std::vector<int> sliceJob(mmax_z_);
+    int zStart = 0;
+    for (int i = 0; i < nbThreads; i++) {
+        FloodSlicesJob &job = jobs[i];
+        job.pMission = this;
+        job.pSurfaces = mtsurfaces_;
+        job.zStart = zStart;
+        zStart += mmax_z_ / nbThreads + (i < mmax_z_ % nbThreads ? 1 : 0);
+        job.zEnd = zStart;
+        for (int iz = job.zStart; iz < job.zEnd; iz++) {
+            sliceJob[iz] = i;
+        }
+    }
+
+    for (int i = 1; i < nbThreads; i++) {
+        threads[i] = SDL_CreateThread(recordFloodSlices, &jobs[i]);
+        if (threads[i] == NULL) {
+            LOG(Log::k_FLG_GAME, "Mission", "floodSurfaces",
+                ("Cannot create thread, recording slices %d-%d inline",
+                jobs[i].zStart, jobs[i].zEnd));
+            recordFloodSlices(&jobs[i]);
+        }
+    }
+
+    recordFloodSlices(&jobs[0]);
+
+    for (int i = 1; i < nbThreads; i++) {
+        if (threads[i]) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+
+    // slices are stitched together by replaying the writes in flood order
+    std::vector<int> toDefine;
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        int indx = seeds[i].x + seeds[i].y + seeds[i].z;
+        if (mdpoints_[indx].bfNodeDesc != m_fdNotDefined) {
+            continue;
+        }
+        mdpoints_[indx].bfNodeDesc = m_fdDefReq;
+        toDefine.push_back(indx);
+        while (!toDefine.empty()) {
+            indx = toDefine.back();
+            toDefine.pop_back();
+            const FloodSlicesJob &job = jobs[sliceJob[indx / mmax_m_xy]];
+            int tile = indx - job.zStart * mmax_m_xy;
+            for (int op = job.firstOp[tile]; op < job.firstOp[tile + 1]; ++op) {
+                const FloodOp &fop = job.ops[op];
+                floodPointDesc &point = mdpoints_[fop.indx];
+                switch (fop.type) {
+                    case FloodOp::kSetDesc:
+                        point.bfNodeDesc = fop.desc;
+                        break;
+                    case FloodOp::kOrDesc:
+                        point.bfNodeDesc |= fop.desc;
                         break;
-                    case 0x12:
-                        cfp->bfNodeDesc = m_fdWalkable;
-                        cfp->bfNodeDesc |= m_fdSafeWalk;
-                        if (zm >= 0) {
-                            mdpoints_[x + y + zm].bfNodeDesc = m_fdNonWalkable;
-                            if (ym >= 0) {
-                                this_s = mtsurfaces_[x + ym + zm];
-                                upper_s = mtsurfaces_[x + ym + z];
-                                if (isSurface(this_s)) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x10;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                } else if (isStairs(upper_s) && upper_s != 0x01) {
-                                    nxtfp = &(mdpoints_[x + ym + z]);
-                                    this_s = upper_s;
-                                    upper_s = mtsurfaces_[x + ym + zp];
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x10;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = ym;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                            if (xm >= 0) {
-                                this_s = mtsurfaces_[xm + y + zm];
-                                upper_s = mtsurfaces_[xm + y + z];
-                                if (isSurface(this_s)) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x40;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                } else if (isStairs(upper_s) && upper_s != 0x04) {
-                                    nxtfp = &(mdpoints_[xm + y + z]);
-                                    this_s = upper_s;
-                                    upper_s = mtsurfaces_[xm + y + zp];
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x40;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                            if (xp < mmax_x_) {
-                                this_s = mtsurfaces_[xp + y + zm];
-                                upper_s = mtsurfaces_[xp + y + z];
-                                if (isSurface(this_s)) {
-                                    nxtfp = &(mdpoints_[xp + y + z]);
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x04;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xp;
-                                            stodef.y = y;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                } else if (isStairs(upper_s) && upper_s != 0x03) {
-                                    nxtfp = &(mdpoints_[xp + y + z]);
-                                    this_s = upper_s;
-                                    upper_s = mtsurfaces_[xp + y + zp];
-                                    if (sWalkable(this_s, upper_s)) {
-                                        sdirl |= 0x04;
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xp;
-                                            stodef.y = y;
-                                            stodef.z = z;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
+                    case FloodOp::kSetDirs:
+                        point.dirm = fop.desc;
+                        point.dirh = fop.dirh;
+                        point.dirl = fop.dirl;
+                        break;
+                    case FloodOp::kRequest:
+                        if (point.bfNodeDesc == m_fdNotDefined) {
+                            point.bfNodeDesc = m_fdDefReq;
+                            toDefine.push_back(fop.next);
                         }
+                        break;
+                }
+            }
+        }
+    }
+}
 
-                        if (xm >=0) {
-                            this_s = mtsurfaces_[xm + y + z];
-                            upper_s = mtsurfaces_[xm + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x40 | 0x80);
-                                nxtfp = &(mdpoints_[xm + y + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x20 | 0x80);
-                                if (this_s == 0x01 || this_s == 0x02 || this_s == 0x03){
-                                    sdirl |= 0x40;
-                                }
-                                nxtfp = &(mdpoints_[xm + y + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = y;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x20 | 0x80);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x02
-                                    || upper_s == 0x04))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[xm + y + (zp + mmax_m_xy)]))
-                                    {
-                                        sdirm |= 0x40;
-                                        nxtfp = &(mdpoints_[xm + y + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xm;
-                                            stodef.y = y;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x20 | 0x80);
+/*!
+ * Makes surfaces where large doors are located walkable.
+ * \param pSurfaces map-tile surfaces
+ */
+void Mission::clearLargeDoorSurfaces(uint8 *pSurfaces) {
+    int mmax_m_all = mmax_m_xy * mmax_z_;
+    for (std::vector<Static *>::iterator it = statics_.begin();
+        it != statics_.end(); ++it)
+    {
+        Static *s = *it;
+        if (s->type() == Static::smt_LargeDoor) {
+            printf("Large door detected\n");
+            int indx = s->tileX() + s->tileY() * mmax_x_
+                + s->tileZ() * mmax_m_xy;
+            pSurfaces[indx] = 0x00;
+            if (s->orientation() == Static::kStaticOrientation1) {
+                if (indx - 1 >= 0)
+                    pSurfaces[indx - 1] = 0x00;
+                if (indx + 1 < mmax_m_all)
+                    pSurfaces[indx + 1] = 0x00;
+            } else if (s->orientation() == Static::kStaticOrientation2) {
+                if (indx - mmax_x_ >= 0)
+                    pSurfaces[indx - mmax_x_] = 0x00;
+                if (indx + mmax_x_ < mmax_m_all)
+                    pSurfaces[indx + mmax_x_] = 0x00;
+            }
+        }
+    }
+}
 
-                        if (xp < mmax_x_) {
-                            this_s = mtsurfaces_[xp + y + z];
-                            upper_s = mtsurfaces_[xp + y + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x02 | 0x04);
-                                nxtfp = &(mdpoints_[xp + y + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x02 | 0x08);
-                                if (this_s == 0x01 || this_s == 0x02
-                                    || this_s == 0x04)
-                                {
-                                    sdirl |= 0x04;
-                                }
-                                nxtfp = &(mdpoints_[xp + y + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = y;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x02 | 0x08);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x01 || upper_s == 0x02
-                                    || upper_s == 0x03))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[xp + y + (zp + mmax_m_xy)]))
-                                    {
-                                        sdirm |= 0x04;
-                                        nxtfp = &(mdpoints_[xp + y + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = xp;
-                                            stodef.y = y;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x02 | 0x08);
+/*!
+ * Computes the surfaces and flood points again with the serial
+ * algorithm and compares them with mtsurfaces_ and mdpoints_.
+ * \param seeds Tiles where the flood started
+ */
+void Mission::checkSurfaces(const std::vector<WorldPoint> &seeds) {
+    int mmax_m_all = mmax_m_xy * mmax_z_;
+    uint8 *ref_surfaces = (uint8 *)malloc(mmax_m_all * sizeof(uint8));
+    floodPointDesc *ref_points =
+        (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
+    if (ref_surfaces == NULL || ref_points == NULL) {
+        FSERR(Log::k_FLG_GAME, "Mission", "checkSurfaces", ("Memory allocation error\n"));
+    } else {
+        classifyTilesSerial(p_map_, ref_surfaces);
+        clearLargeDoorSurfaces(ref_surfaces);
+        memset((void *)ref_points, 0, mmax_m_all * sizeof(floodPointDesc));
+        floodSurfacesSerial(ref_surfaces, ref_points, seeds);
+
+        if (memcmp(ref_surfaces, mtsurfaces_, mmax_m_all * sizeof(uint8)) != 0) {
+            FSERR(Log::k_FLG_GAME, "Mission", "checkSurfaces",
+                ("Surfaces differ from serial ones\n"));
+        } else if (memcmp(ref_points, mdpoints_,
+            mmax_m_all * sizeof(floodPointDesc)) != 0) {
+            FSERR(Log::k_FLG_GAME, "Mission", "checkSurfaces",
+                ("Flood points differ from serial ones\n"));
+        } else {
+            LOG(Log::k_FLG_GAME, "Mission", "checkSurfaces",
+                ("Threaded surfaces checked"));
+        }
+    }
+    free(ref_surfaces);
+    free(ref_points);
+}
 
-                        if (yp < mmax_m_xy) {
-                            this_s = mtsurfaces_[x + yp + z];
-                            upper_s = mtsurfaces_[x + yp + zp];
-                            if (isSurface(this_s) && sWalkable(this_s, upper_s))
-                            {
-                                sdirm |= (0x80 | 0x01 | 0x02);
-                                nxtfp = &(mdpoints_[x + yp + zp]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else if (isStairs(this_s) && sWalkable(this_s,
-                                upper_s))
-                            {
-                                sdirmr |= (0x80 | 0x02);
-                                if (this_s == 0x01 || this_s == 0x03 || this_s == 0x04) {
-                                    sdirl |= 0x01;
-                                }
-                                nxtfp = &(mdpoints_[x + yp + z]);
-                                if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = x;
-                                    stodef.y = yp;
-                                    stodef.z = z;
-                                    vtodefine.push_back(stodef);
-                                }
-                            } else {
-                                sdirmr |= (0x80 | 0x02);
-                                if ((zp + mmax_m_xy) < mmax_m_all
-                                    && (upper_s == 0x02 || upper_s == 0x03
-                                    || upper_s == 0x04))
-                                {
-                                    if (sWalkable(upper_s,
-                                        mtsurfaces_[x + yp + (zp + mmax_m_xy)]))
-                                    {
-                                        sdirm |= 0x01;
-                                        nxtfp = &(mdpoints_[x + yp + zp]);
-                                        if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                            nxtfp->bfNodeDesc = m_fdDefReq;
-                                            stodef.x = x;
-                                            stodef.y = yp;
-                                            stodef.z = zp;
-                                            vtodefine.push_back(stodef);
-                                        }
-                                    }
-                                }
-                            }
-                        } else
-                            sdirmr |= (0x80 | 0x02);
-                        sdirm &= (0xFF ^ sdirmr);
-
-                        // edges
-                        if (yp < mmax_m_xy) {
-                            if (xm >= 0 && (sdirm & 0x80) != 0) {
-                                nxtfp = &(mdpoints_[xm + yp + zp]);
-                                this_s = mtsurfaces_[xm + yp + z];
-                                upper_s = mtsurfaces_[xm + yp + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x80);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xm;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
-                            if (xp < mmax_x_ && (sdirm & 0x02) != 0) {
-                                nxtfp = &(mdpoints_[xp + yp + zp]);
-                                this_s = mtsurfaces_[xp + yp + z];
-                                upper_s = mtsurfaces_[xp + yp + zp];
-                                if (!(isSurface(this_s) && sWalkable(this_s,
-                                    upper_s)))
-                                {
-                                    sdirm &= (0xFF ^ 0x02);
-                                } else if (nxtfp->bfNodeDesc == m_fdNotDefined) {
-                                    nxtfp->bfNodeDesc = m_fdDefReq;
-                                    stodef.x = xp;
-                                    stodef.y = yp;
-                                    stodef.z = zp;
-                                    vtodefine.push_back(stodef);
-                                }
-                            }
-                        }
+/*!
+ * Creates map of walkable surfaces.
+ * \return false if memory could not be allocated
+ */
+bool Mission::setSurfaces() {
+
+    // Description: creates map of walkable surfaces, also
+    // defines directions where movement is possible
 
-                        cfp->dirm = sdirm;
-                        cfp->dirh = sdirh;
-                        cfp->dirl = sdirl;
+    // NOTE: tiles walkdata type 0x0D are quiet special, and they
+    // are not handled correctly, these correction and andjustings
+    // can create additional speed drain, as such I didn't
+    // implemented them as needed. To make it possible a patch
+    // required to walkdata and a lot of changes which I don't
+    // want to do.
+    // 0x10 appear above walking tile where train stops
+    DEBUG_SPEED_INIT
 
-                        break;
-                }
-            } while (vtodefine.size());
+    clrSurfaces();
+    int mmax_m_all = mmax_x_ * mmax_y_ * mmax_z_;
+    mtsurfaces_ = (uint8 *)malloc(mmax_m_all * sizeof(uint8));
+    mdpoints_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
+    mdpoints_cp_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
+    if(mtsurfaces_ == NULL || mdpoints_ == NULL || mdpoints_cp_ == NULL) {
+        clrSurfaces();
+        FSERR(Log::k_FLG_GAME, "Mission", "setSurfaces", ("Memory allocation error\n"));
+        return false;
+    }
+    mmax_m_xy = mmax_x_ * mmax_y_;
+    memset((void *)mdpoints_, 0, mmax_m_all * sizeof(floodPointDesc));
+    classifyTiles(p_map_, mtsurfaces_, g_Ctx.getSurfacesThreads());
+    clearLargeDoorSurfaces(mtsurfaces_);
+
+    //printf("surface data size %i\n", sizeof(surfaceDesc) * mmax_m_all);
+    //printf("flood data size %i\n", sizeof(floodPointDesc) * mmax_m_all);
+
+    std::vector<WorldPoint> seeds;
+    for (unsigned int i = 0; i < peds_.size(); ++i) {
+        PedInstance *p = peds_[i];
+        int z = p->tileZ();
+        if (z >= mmax_z_ || z < 0 || p->isDead()) {
+            // TODO : check on all maps those peds correct position
+            p->setTileZ(mmax_z_ - 1);
+            continue;
         }
+        WorldPoint seed;
+        seed.x = p->tileX();
+        seed.y = p->tileY() * mmax_x_;
+        seed.z = z * mmax_m_xy;
+        seeds.push_back(seed);
+    }
+    floodSurfaces(seeds, g_Ctx.getSurfacesThreads());
+
+    if (g_Ctx.isCheckSurfaces()) {
+        checkSurfaces(seeds);
     }
 #if 0
     unsigned int cw = 0;
@@ -2215,9 +2142,22 @@ bool Mission::setSurfaces() {
 
     printf("flood walkables %i\n", cw);
 #endif
+    DEBUG_SPEED_LOG("Mission::setSurfaces")
     return true;
 }
 
+/*!
+ * Returns the memory used by mtsurfaces_, mdpoints_ and mdpoints_cp_.
+ * \return 0 if surfaces are not set
+ */
+size_t Mission::surfacesMemorySize() {
+    if (mtsurfaces_ == NULL) {
+        return 0;
+    }
+    size_t nbTiles = mmax_x_ * mmax_y_ * mmax_z_;
+    return nbTiles * (sizeof(uint8) + 2 * sizeof(floodPointDesc));
+}
+
 void Mission::clrSurfaces() {
 
     if(mtsurfaces_ != NULL) {
@@ -2589,6 +2529,244 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
     // TODO: some objects mid point is higher then map z
     assert(distanceMax >= 0);
 
+    // keep initial target for comparison with the sampled version
+    WorldPoint initialTargetW = *pTargetPosW;
+
+    int cx = originPosW.x;
+    int cy = originPosW.y;
+    int cz = originPosW.z;
+    if (cz > (mmax_z_ - 1) * 128)
+        return kBMaskBlockerTargetOutOfMap;
+
+    // This variable will store the target location as it may moves if
+    // a tile blocks the path.
+    WorldPoint tmpTargetWLoc = *pTargetPosW;
+
+    if (tmpTargetWLoc.z > (mmax_z_ - 1) * 128)
+        return kBMaskBlockerTargetOutOfMap;
+
+    // This is the distance between the origin and the target
+    double distanceToTarget = 0;
+    distanceToTarget = sqrt((double)((tmpTargetWLoc.x - cx) * (tmpTargetWLoc.x - cx) + (tmpTargetWLoc.y - cy) * (tmpTargetWLoc.y - cy)
+        + (tmpTargetWLoc.z - cz) * (tmpTargetWLoc.z - cz)));
+    uint8 block_mask = 1;
+
+    if (pInitialDistance)
+        *pInitialDistance = distanceToTarget;
+    if (distanceToTarget == 0)
+        return block_mask;
+
+    if (distanceToTarget >= distanceMax) {
+        // the distance we have to cross (distanceToTarget) is higher than the maximum
+        // distance we are allowed to cross (distanceMax)
+
+        // update target position according to distanceMax
+        double dist_k = (double)distanceMax / distanceToTarget;
+        tmpTargetWLoc.x = cx + (int)((tmpTargetWLoc.x - cx) * dist_k);
+        tmpTargetWLoc.y = cy + (int)((tmpTargetWLoc.y - cy) * dist_k);
+        tmpTargetWLoc.z = cz + (int)((tmpTargetWLoc.z - cz) * dist_k);
+        // set mask to indicate distanceMax is reached
+        block_mask = 8;
+        if (updateLoc) {
+            *pTargetPosW = tmpTargetWLoc;
+        }
+        distanceToTarget = distanceMax;
+    }
+
+    double t_hit;
+    if (traverseTiles(originPosW, tmpTargetWLoc, distanceToTarget, &t_hit)) {
+        // position just before the blocking point
+        t_hit -= kTileStepBack / distanceToTarget;
+        if (t_hit < 0.0)
+            t_hit = 0.0;
+        // set mask to indicate path is blocked by a tile
+        if (block_mask == 1)
+            block_mask = 16;
+        else
+            block_mask |= 16;
+        if (updateLoc) {
+            pTargetPosW->x = cx + (int)((tmpTargetWLoc.x - cx) * t_hit);
+            pTargetPosW->y = cy + (int)((tmpTargetWLoc.y - cy) * t_hit);
+            pTargetPosW->z = cz + (int)((tmpTargetWLoc.z - cz) * t_hit);
+        }
+    }
+
+    if (g_Ctx.isCheckLosTiles()) {
+        WorldPoint sampledTargetW = initialTargetW;
+        uint8 sampled_mask = checkBlockedByTileSampled(originPosW,
+            &sampledTargetW, true, distanceMax);
+        if (sampled_mask != block_mask) {
+            FSERR(Log::k_FLG_GAME, "Mission", "checkBlockedByTile",
+                ("traversal differs from sampling : (%d, %d, %d) -> (%d, %d, %d) mask %d, sampled %d\n",
+                cx, cy, cz, initialTargetW.x, initialTargetW.y, initialTargetW.z,
+                block_mask, sampled_mask));
+        }
+    }
+
+    return block_mask;
+}
+
+/*!
+ * Visits every tile crossed by the segment from originPosW to targetPosW
+ * (Amanatides-Woo traversal) and tests it against its collision shape.
+ * Like the sampled version, the starting tile is tested only if it is
+ * partially solid and the last kTileStepBack units before the target
+ * are not tested.
+ * \param originPosW Segment starting point
+ * \param targetPosW Segment end point
+ * \param length Length of the segment
+ * \param pHit Set with the position of the blocking point as a fraction
+ * of the segment, if any
+ * \return true if a tile blocks the segment
+ */
+bool Mission::traverseTiles(const WorldPoint & originPosW, const WorldPoint & targetPosW,
+                            double length, double *pHit) {
+    if (length <= kTileStepBack) {
+        return false;
+    }
+    // limit of the check on the segment
+    double t_end = (length - kTileStepBack) / length;
+
+    const int kTileSize[3] = {256, 256, 128};
+    const int kMaxTile[3] = {mmax_x_, mmax_y_, mmax_z_};
+    double origin[3] = {(double) originPosW.x, (double) originPosW.y, (double) originPosW.z};
+    double delta[3] = {(double) (targetPosW.x - originPosW.x),
+        (double) (targetPosW.y - originPosW.y),
+        (double) (targetPosW.z - originPosW.z)};
+
+    int tile[3];
+    int step[3];
+    double t_max[3];
+    double t_delta[3];
+    for (int a = 0; a < 3; a++) {
+        tile[a] = (int) origin[a] / kTileSize[a];
+        if (delta[a] > 0) {
+            step[a] = 1;
+            t_max[a] = ((tile[a] + 1) * kTileSize[a] - origin[a]) / delta[a];
+            t_delta[a] = kTileSize[a] / delta[a];
+        } else if (delta[a] < 0) {
+            step[a] = -1;
+            t_max[a] = (tile[a] * kTileSize[a] - origin[a]) / delta[a];
+            t_delta[a] = -kTileSize[a] / delta[a];
+        } else {
+            step[a] = 0;
+            t_max[a] = 2.0;
+            t_delta[a] = 2.0;
+        }
+    }
+
+    double t_enter = 0.0;
+    bool origin_tile = true;
+    while (t_enter < t_end) {
+        if (tile[0] < 0 || tile[0] >= kMaxTile[0] || tile[1] < 0 || tile[1] >= kMaxTile[1]
+            || tile[2] < 0 || tile[2] >= kMaxTile[2]) {
+            // left the map
+            return false;
+        }
+
+        // the axis whose boundary is crossed first
+        int next = 0;
+        if (t_max[1] < t_max[next])
+            next = 1;
+        if (t_max[2] < t_max[next])
+            next = 2;
+        double t_exit = t_max[next] < t_end ? t_max[next] : t_end;
+
+        const TileShape & shape = tileShape(mtsurfaces_[tile[0]
+            + tile[1] * mmax_x_ + tile[2] * mmax_m_xy]);
+        if (shape.type == TileShape::kShapeSolid && !origin_tile) {
+            *pHit = t_enter;
+            return true;
+        } else if (shape.type == TileShape::kShapeSlope) {
+            // offsets in the tile of entry and exit points
+            double f_enter = shape.d;
+            double f_exit = shape.d;
+            for (int a = 0; a < 3; a++) {
+                double base = origin[a] - tile[a] * kTileSize[a];
+                f_enter -= shape.coef[a] * (base + delta[a] * t_enter);
+                f_exit -= shape.coef[a] * (base + delta[a] * t_exit);
+            }
+            // point is solid when coef . offset <= d, ie f >= 0
+            if (f_enter >= 0) {
+                *pHit = t_enter;
+                return true;
+            } else if (f_exit >= 0) {
+                *pHit = t_enter + (t_exit - t_enter) * f_enter / (f_enter - f_exit);
+                return true;
+            }
+        }
+
+        origin_tile = false;
+        t_enter = t_max[next];
+        tile[next] += step[next];
+        t_max[next] += t_delta[next];
+    }
+
+    return false;
+}
+
+/*!
+ * Fills the collision shape of every walkdata.
+ * \return always true
+ */
+bool Mission::initTileShapes() {
+    for (int i = 0; i < 256; i++) {
+        TileShape & shape = tileShapes_[i];
+        shape.coef[0] = 0.0;
+        shape.coef[1] = 0.0;
+        shape.coef[2] = 0.0;
+        shape.d = 0.0;
+        switch (i) {
+            case 0x00:
+            case 0x0C:
+            case 0x10:
+                shape.type = TileShape::kShapeEmpty;
+                break;
+            // stairs : solid under a plane
+            case 0x01:
+                // oz <= 127 - oy / 2
+                shape.type = TileShape::kShapeSlope;
+                shape.coef[1] = 0.5;
+                shape.coef[2] = 1.0;
+                shape.d = 127.0;
+                break;
+            case 0x02:
+                // oz <= oy / 2
+                shape.type = TileShape::kShapeSlope;
+                shape.coef[1] = -0.5;
+                shape.coef[2] = 1.0;
+                break;
+            case 0x03:
+                // oz <= ox / 2
+                shape.type = TileShape::kShapeSlope;
+                shape.coef[0] = -0.5;
+                shape.coef[2] = 1.0;
+                break;
+            case 0x04:
+                // oz <= 127 - ox / 2
+                shape.type = TileShape::kShapeSlope;
+                shape.coef[0] = 0.5;
+                shape.coef[2] = 1.0;
+                shape.d = 127.0;
+                break;
+            default:
+                shape.type = TileShape::kShapeSolid;
+                break;
+        }
+    }
+    return true;
+}
+
+/*!
+ * Previous version of checkBlockedByTile() that walks along the path
+ * by fixed increments. It is kept to check the results of the traversal.
+ * \see checkBlockedByTile()
+ */
+uint8 Mission::checkBlockedByTileSampled(const WorldPoint & originPosW, WorldPoint *pTargetPosW,
+                                  bool updateLoc, double distanceMax, double *pInitialDistance) {
+    // TODO: some objects mid point is higher then map z
+    assert(distanceMax >= 0);
+
     int cx = originPosW.x;
     int cy = originPosW.y;
     int cz = originPosW.z;
@@ -2740,6 +2918,145 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
 uint8 Mission::checkIfBlockersInShootingLine(const WorldPoint & originLoc, ShootableMapObject ** pTarget,
     WorldPoint *pTargetPosW, bool setBlocker, bool checkTileOnly, double maxr,
     double * distTo, const ShootableMapObject *pOrigin)
+{
+    if (setBlocker) {
+        // arguments are modified so result cannot be reused
+        return computeBlockersInShootingLine(originLoc, pTarget, pTargetPosW,
+            setBlocker, checkTileOnly, maxr, distTo, pOrigin);
+    }
+
+    LosKey key;
+    key.ox = originLoc.x;
+    key.oy = originLoc.y;
+    key.oz = originLoc.z;
+    key.pTarget = pTarget ? *pTarget : NULL;
+    if (key.pTarget) {
+        WorldPoint targetPosW(key.pTarget->position());
+        key.tx = targetPosW.x;
+        key.ty = targetPosW.y;
+        key.tz = targetPosW.z;
+    } else {
+        key.tx = pTargetPosW->x;
+        key.ty = pTargetPosW->y;
+        key.tz = pTargetPosW->z;
+    }
+    key.pOrigin = pOrigin;
+    key.maxr = maxr;
+    key.checkTileOnly = checkTileOnly;
+
+    uint32 h = key.hash();
+    LosEntry *pEntry = NULL;
+    for (int i = 0; i < kLosCacheProbes; i++) {
+        LosEntry &entry = losCache_[(h + i) & (kLosCacheSize - 1)];
+        if (entry.generation != losGeneration_) {
+            // free entry
+            if (pEntry == NULL) {
+                pEntry = &entry;
+            }
+            continue;
+        }
+        if (entry.key == key) {
+            if (isLosEntryValid(entry)) {
+                nbLosHits_++;
+                if (distTo) {
+                    *distTo = entry.distTo;
+                }
+                return entry.mask;
+            }
+            // obsolete result is replaced
+            pEntry = &entry;
+            break;
+        }
+    }
+    if (pEntry == NULL) {
+        // all entries are used so the first one is replaced
+        pEntry = &losCache_[h & (kLosCacheSize - 1)];
+    }
+
+    nbLosMisses_++;
+    pEntry->key = key;
+    pEntry->distTo = 0;
+    pEntry->generation = losGeneration_;
+    pEntry->stamp = losStamp_;
+    // a blocker is at most one tile away from the line
+    int minTileX = std::max(std::min(key.ox, key.tx) / 256 - 1, 0);
+    int minTileY = std::max(std::min(key.oy, key.ty) / 256 - 1, 0);
+    int maxTileX = std::min(std::max(key.ox, key.tx) / 256 + 1, mmax_x_ - 1);
+    int maxTileY = std::min(std::max(key.oy, key.ty) / 256 + 1, mmax_y_ - 1);
+    pEntry->minCellX = minTileX / kLosCellTiles;
+    pEntry->minCellY = minTileY / kLosCellTiles;
+    pEntry->maxCellX = maxTileX / kLosCellTiles;
+    pEntry->maxCellY = maxTileY / kLosCellTiles;
+    pEntry->mask = computeBlockersInShootingLine(originLoc, pTarget, pTargetPosW,
+        setBlocker, checkTileOnly, maxr, &pEntry->distTo, pOrigin);
+    if (distTo) {
+        *distTo = pEntry->distTo;
+    }
+
+    return pEntry->mask;
+}
+
+/*!
+ * An entry is obsolete if the cache has been cleared or if a blocker has
+ * changed in one of the cells around the line since it was computed.
+ * \param entry The entry
+ */
+bool Mission::isLosEntryValid(const LosEntry &entry) {
+    if (entry.generation != losGeneration_) {
+        return false;
+    }
+    for (int cy = entry.minCellY; cy <= entry.maxCellY; cy++) {
+        for (int cx = entry.minCellX; cx <= entry.maxCellX; cx++) {
+            if (losCellStamps_[cx + cy * losCellsX_] > entry.stamp) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+ * Makes obsolete the results of checkIfBlockersInShootingLine() whose
+ * line passes in the cell of the given tile. Must be called each time
+ * a blocker moves, appears or disappears on that tile.
+ * \param tile Position of the blocker
+ */
+void Mission::invalidateLosAt(const TilePoint &tile) {
+    if (losCellStamps_.empty()) {
+        return;
+    }
+    int cx = std::min(std::max(tile.tx / kLosCellTiles, 0), losCellsX_ - 1);
+    int cy = std::min(std::max(tile.ty / kLosCellTiles, 0), losCellsY_ - 1);
+    losStamp_++;
+    losCellStamps_[cx + cy * losCellsX_] = losStamp_;
+}
+
+bool Mission::LosKey::operator==(const LosKey &other) const {
+    return ox == other.ox && oy == other.oy && oz == other.oz
+        && tx == other.tx && ty == other.ty && tz == other.tz
+        && pTarget == other.pTarget && pOrigin == other.pOrigin
+        && maxr == other.maxr && checkTileOnly == other.checkTileOnly;
+}
+
+uint32 Mission::LosKey::hash() const {
+    uint32 h = (uint32) ox;
+    h = h * 31 + (uint32) oy;
+    h = h * 31 + (uint32) oz;
+    h = h * 31 + (uint32) tx;
+    h = h * 31 + (uint32) ty;
+    h = h * 31 + (uint32) tz;
+    h = h * 31 + (uint32) (size_t) pTarget;
+    h = h * 31 + (uint32) (size_t) pOrigin;
+    // mix high bits in the low ones used as index
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+}
+
+uint8 Mission::computeBlockersInShootingLine(const WorldPoint & originLoc, ShootableMapObject ** pTarget,
+    WorldPoint *pTargetPosW, bool setBlocker, bool checkTileOnly, double maxr,
+    double * distTo, const ShootableMapObject *pOrigin)
 {
     // search for a tile blocking the path towards the target
     // tmp will hold the updated position after that search
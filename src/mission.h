@@ -30,12 +30,15 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
 
 #include "common.h"
 #include "mapobject.h"
 #include "map.h"
 #include "model/leveldata.h"
 #include "core/gameevent.h"
+#include "ia/sensors.h"
+#include "missionarena.h"
 
 class Vehicle;
 class PedInstance;
@@ -156,6 +159,13 @@ public:
     void addObjective(ObjectiveDesc *pObjective) { objectives_.push_back(pObjective); }
     //! Check if objectives are completed or failed
     void checkObjectives();
+    //! Returns true if the object is the target of an unfinished objective
+    bool isObjectiveTarget(MapObject *pObject);
+    /*!
+     * Records a state change that may end the current objective.
+     * \param trigger One or more EObjectiveTrigger
+     */
+    void signalObjectiveTrigger(uint32 trigger) { pendingObjTriggers_ |= trigger; }
     void objectiveMsg(std::string& msg);
 
     //*************************************
@@ -166,7 +176,7 @@ public:
      * If p_map is not null, creates a minimap from it.
      * \param p_map The map to set.
      */
-    void set_map(Map *p_map);
+    void set_map(Map *p_map, bool lock = true);
 
     /*!
      * Returns the map used for the mission.
@@ -193,6 +203,8 @@ public:
     size_t numPeds() { return peds_.size(); }
     PedInstance *ped(size_t i) { return peds_[i]; }
     void addPed(PedInstance *p) { peds_.push_back(p); }
+    //! Removes and destroys the ped at the given index before the mission starts
+    void removePed(size_t i);
 
     size_t numVehicles() { return vehicles_.size(); }
     Vehicle *vehicle(size_t i) { return vehicles_[i]; }
@@ -214,17 +226,12 @@ public:
         sfx_objects_.push_back(so);
     }
     /*!
-     * Removes SfxObject at given position in the list of sfxobjects.
+     * Removes all SfxObjects whose life is over in one pass.
+     * Remaining objects keep their relative order so they are drawn
+     * in the same order.
      * Object is freed only if not managed by another object.
-     * \param i position of object in the list.
      */
-    void delSfxObject(size_t i) {
-        if (!sfx_objects_[i]->isManaged()) {
-            // object is not managed so delete it
-            delete sfx_objects_[i];
-        }
-        sfx_objects_.erase((sfx_objects_.begin() + i));
-    }
+    void removeDeadSfxObjects();
 
     /*!
      * Adds the given ProjectileShot to the list of animated shots.
@@ -244,10 +251,10 @@ public:
      */
     ProjectileShot *prjShots(size_t i) { return prj_shots_[i]; }
     /*!
-     * Destroy the projectile at given index.
-     * \param i Index of the projectile
+     * Destroys all projectiles whose life is over in one pass.
+     * Remaining projectiles keep their relative order.
      */
-    void delPrjShot(size_t i);
+    void removeDeadPrjShots();
 
     /*!
      * Adds the given PedInstance to the list of armed peds.
@@ -266,6 +273,10 @@ public:
      * \return The ped found.
      */
     PedInstance *armedPedAtIndex(size_t i) { return armedPedsVec_[i]; }
+    /*!
+     * Returns the sensors computed at the beginning of the tick.
+     */
+    PedSensors & sensors() { return sensors_; }
     /*!
      * Removes given ped from the list of armed peds.
      * \param pPed The ped to remove
@@ -279,7 +290,14 @@ public:
     MissionStats *stats() { return &stats_; }
 
     bool setSurfaces();
+    //! Fills the given surfaces with tiles walkdata using nbThreads threads
+    static void classifyTiles(Map *pMap, uint8 *pSurfaces, int nbThreads);
+    //! Gives the writes to flood points done when visiting a tile
+    template <class Ops>
+    void floodTile(int x, int y, int z, const uint8 *pSurfaces, Ops &ops);
     void clrSurfaces();
+    //! Returns the memory in bytes used by surfaces and flood points
+    size_t surfacesMemorySize();
     bool getWalkable(TilePoint &mtp);
     bool getWalkableClosestByZ(TilePoint &mtp);
     bool getShootableTile(TilePoint *pLocT);
@@ -290,6 +308,8 @@ public:
     //*************************************
     //! Check if a tile is blocking the line between originLoc and pTargetPosW
     uint8 checkBlockedByTile(const WorldPoint & originLoc, WorldPoint *pTargetPosW, bool updateLoc, double distanceMax, double *pFinalDest = NULL);
+    //! Same as checkBlockedByTile but walks the line by fixed increments
+    uint8 checkBlockedByTileSampled(const WorldPoint & originLoc, WorldPoint *pTargetPosW, bool updateLoc, double distanceMax, double *pFinalDest = NULL);
     //! Check if an object is blocking the line between originLoc and pTargetPosW
     MapObject * checkBlockedByObject(WorldPoint * originLoc, WorldPoint * pTargetPosW,
         double *dist, const ShootableMapObject *pOrigin);
@@ -297,6 +317,14 @@ public:
     uint8 checkIfBlockersInShootingLine(const WorldPoint & originLoc, ShootableMapObject **pTarget,
         WorldPoint *pTargetPosW = NULL, bool setBlocker = false,
         bool checkTileOnly = false, double maxr = -1.0, double * distTo = NULL, const ShootableMapObject *pOrigin = NULL);
+    //! Forgets all results of line of sight checks
+    void clearLosCache() { losGeneration_++; }
+    //! Makes cached lines of sight passing near the given tile obsolete
+    void invalidateLosAt(const TilePoint &tile);
+    //! Number of line of sight checks answered by the cache
+    uint32 losCacheHits() const { return nbLosHits_; }
+    //! Number of line of sight checks that had to be computed
+    uint32 losCacheMisses() const { return nbLosMisses_; }
     //! Returns the distance between a ped and a object if a path exists between the two
     uint8 getPathLengthBetween(PedInstance *pPed, ShootableMapObject* objectToReach, double distanceMax, double *length);
 
@@ -318,7 +346,91 @@ public:
      */
     Squad * getSquad() const { return p_squad_; }
 
+    /*!
+     * Returns the arena where peds, vehicles and statics are allocated.
+     */
+    MissionArena & arena() { return arena_; }
+
 protected:
+    /*!
+     * Describes which part of a tile blocks shots.
+     */
+    struct TileShape {
+        enum EType {
+            /*! Tile does not block.*/
+            kShapeEmpty,
+            /*! The whole tile blocks.*/
+            kShapeSolid,
+            /*! Points under a plane block : coef . offset <= d (stairs).*/
+            kShapeSlope
+        };
+        EType type;
+        /*! Plane coefficients for x, y and z offsets in the tile.*/
+        double coef[3];
+        double d;
+    };
+
+    /*! Distance between a blocking point and the position returned.*/
+    static const double kTileStepBack;
+    /*! Collision shape for each walkdata.*/
+    static TileShape tileShapes_[256];
+    /*! The shapes are filled during static initialization, before any
+     thread can use them.*/
+    static const bool kTileShapesReady;
+
+    //! Returns the collision shape for the given walkdata
+    static const TileShape & tileShape(uint8 twd) { return tileShapes_[twd]; }
+    //! Fills the table of collision shapes
+    static bool initTileShapes();
+    //! Finds the first tile blocking the given segment
+    bool traverseTiles(const WorldPoint & originPosW, const WorldPoint & targetPosW,
+        double length, double *pHit);
+    //! Does the actual work for checkIfBlockersInShootingLine
+    uint8 computeBlockersInShootingLine(const WorldPoint & originLoc, ShootableMapObject **pTarget,
+        WorldPoint *pTargetPosW, bool setBlocker, bool checkTileOnly, double maxr,
+        double * distTo, const ShootableMapObject *pOrigin);
+
+    /*! Number of entries in the line of sight cache (a power of 2).*/
+    static const int kLosCacheSize = 512;
+    /*! Number of entries looked at to find a line of sight.*/
+    static const int kLosCacheProbes = 8;
+    /*! Size in tiles of the map cells used to invalidate lines of sight.*/
+    static const int kLosCellTiles = 8;
+
+    /*!
+     * Key for the cache of line of sight checks. Positions are the exact
+     * world positions so the key implies source and target tiles.
+     */
+    struct LosKey {
+        int ox, oy, oz;
+        int tx, ty, tz;
+        const ShootableMapObject *pTarget;
+        const ShootableMapObject *pOrigin;
+        double maxr;
+        bool checkTileOnly;
+
+        bool operator==(const LosKey &other) const;
+        uint32 hash() const;
+    };
+
+    /*!
+     * Result of a line of sight check.
+     */
+    struct LosEntry {
+        LosKey key;
+        uint8 mask;
+        double distTo;
+        /*! Value of losGeneration_ when the result was computed.*/
+        uint32 generation;
+        /*! Value of losStamp_ when the result was computed.*/
+        uint32 stamp;
+        /*! Cells around the line : a blocker moving there changes the result.*/
+        int minCellX, minCellY, maxCellX, maxCellY;
+    };
+
+    //! Returns true if no blocker has changed around the line since the entry was computed
+    bool isLosEntryValid(const LosEntry &entry);
+
     bool sWalkable(char thisTile, char upperTile);
     bool isSurface(char thisTile);
     bool isStairs(char thisTile);
@@ -326,6 +438,15 @@ protected:
     void transferWeaponsFromPedInstanceToAgent(PedInstance *p, Agent *pAg);
 
 protected:
+    //! Floods mdpoints_ from the seeds using nbThreads threads
+    void floodSurfaces(const std::vector<WorldPoint> &seeds, int nbThreads);
+    //! Floods the given points from the seeds in the calling thread
+    void floodSurfacesSerial(const uint8 *pSurfaces, floodPointDesc *pPoints,
+        const std::vector<WorldPoint> &seeds);
+    //! Makes surfaces under large doors walkable
+    void clearLargeDoorSurfaces(uint8 *pSurfaces);
+    //! Compares surfaces and flood points with the serial algorithm
+    void checkSurfaces(const std::vector<WorldPoint> &seeds);
 
     /*! List of all vehicles, cars and train.*/
     std::vector<Vehicle *> vehicles_;
@@ -333,6 +454,8 @@ protected:
     //! List of all weapons that have no owner
     std::vector<WeaponInstance *> weaponsOnGround_;
     std::vector<Static *> statics_;
+    /*! Memory for peds, vehicles and statics.*/
+    MissionArena arena_;
     std::vector<SFXObject *> sfx_objects_;
     std::vector<ProjectileShot *> prj_shots_;
     /*!
@@ -340,10 +463,14 @@ protected:
      * It's used for performance reasons.
      */
     std::vector<PedInstance *> armedPedsVec_;
+    /*! Positions of armed peds and agents shared by all behaviours.*/
+    PedSensors sensors_;
 
     std::vector <ObjectiveDesc *> objectives_;
     //std::vector <ObjectiveDesc> sub_objectives_;
     uint16 cur_objective_;
+    /*! Mask of EObjectiveTrigger signaled since last objectives check.*/
+    uint32 pendingObjTriggers_;
     /*!
      * Mission status.
      * By default, a mission is running but it can be
@@ -373,6 +500,33 @@ protected:
      * The squad selected for the mission. It contains only active agents.
      */
     Squad *p_squad_;
+    /*!
+     * Results of line of sight checks that do not modify their
+     * arguments, in an open addressed table of kLosCacheSize entries.
+     * Cleared at each game tick.
+     */
+    std::vector<LosEntry> losCache_;
+    /*!
+     * Incremented when the cache is cleared.
+     * Entries computed with a previous value are free.
+     */
+    uint32 losGeneration_;
+    /*! Incremented each time a blocker changes somewhere.*/
+    uint32 losStamp_;
+    /*!
+     * For each cell of kLosCellTiles * kLosCellTiles tiles, value of
+     * losStamp_ when a blocker has last moved, appeared or disappeared
+     * in the cell.
+     */
+    std::vector<uint32> losCellStamps_;
+    /*! Number of cells on the x axis.*/
+    int losCellsX_;
+    /*! Number of cells on the y axis.*/
+    int losCellsY_;
+    /*! Number of checks found in the cache.*/
+    uint32 nbLosHits_;
+    /*! Number of checks not found in the cache.*/
+    uint32 nbLosMisses_;
 };
 
 #endif
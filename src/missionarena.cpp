@@ -0,0 +1,104 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include "missionarena.h"
+#include "utils/log.h"
+
+const size_t MissionArena::kChunkSize = 64 * 1024;
+/*! Objects are aligned on this size.*/
+static const size_t kArenaAlignment = 16;
+
+MissionArena::MissionArena() {
+    for (int i = 0; i < kNbGroups; i++) {
+        groups_[i].used = kChunkSize;
+        groups_[i].nbObjects = 0;
+        groups_[i].nbBytes = 0;
+    }
+}
+
+MissionArena::~MissionArena() {
+    release();
+}
+
+/*!
+ * Returns a block in the last chunk of the group. If there's not enough
+ * space, a new chunk is allocated.
+ * \param size Size of the object
+ * \param group The group of the object
+ * \return the block
+ */
+void * MissionArena::allocate(size_t size, EGroup group) {
+    Group &grp = groups_[group];
+    size_t blockSize = (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+
+    if (blockSize > kChunkSize) {
+        // object alone in its own chunk, inserted before the current one
+        char *pChunk = static_cast<char *>(::operator new(blockSize));
+        grp.chunks.insert(grp.chunks.end() - (grp.chunks.empty() ? 0 : 1), pChunk);
+        grp.nbObjects++;
+        grp.nbBytes += blockSize;
+        return pChunk;
+    }
+
+    if (grp.used + blockSize > kChunkSize) {
+        grp.chunks.push_back(static_cast<char *>(::operator new(kChunkSize)));
+        grp.used = 0;
+    }
+
+    void *pBlock = grp.chunks.back() + grp.used;
+    grp.used += blockSize;
+    grp.nbObjects++;
+    grp.nbBytes += blockSize;
+    return pBlock;
+}
+
+/*!
+ * Frees all the memory. Destructors of objects must have been called before.
+ */
+void MissionArena::release() {
+    for (int i = 0; i < kNbGroups; i++) {
+        Group &grp = groups_[i];
+        for (size_t c = 0; c < grp.chunks.size(); c++) {
+            ::operator delete(grp.chunks[c]);
+        }
+        grp.chunks.clear();
+        grp.used = kChunkSize;
+        grp.nbObjects = 0;
+        grp.nbBytes = 0;
+    }
+}
+
+void MissionArena::logStats() {
+    for (int i = 0; i < kNbGroups; i++) {
+        LOG(Log::k_FLG_MEM, "MissionArena", "logStats", ("group %d : %d objects, %d bytes in %d chunks",
+            i, groups_[i].nbObjects, (int) groups_[i].nbBytes, (int) groups_[i].chunks.size()));
+    }
+}
+
+void * operator new(size_t size, MissionArena &arena, MissionArena::EGroup group) {
+    return arena.allocate(size, group);
+}
+
+void operator delete(void *pBlock, MissionArena &arena, MissionArena::EGroup group) {
+    // memory is released with the arena
+}
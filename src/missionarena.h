@@ -0,0 +1,100 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef MISSIONARENA_H
+#define MISSIONARENA_H
+
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+
+/*!
+ * The mission arena holds the memory of the objects that live as long as
+ * the mission : peds, vehicles and statics. Objects of the same group are
+ * stored next to each other in big chunks so iterating over them in the
+ * game loop is cache friendly, and all memory is released at once when
+ * the mission is destroyed.
+ * Objects are created with : new (arena, MissionArena::kGroupPeds) PedInstance(...)
+ * and must be destroyed with MissionArena::destroy(), never with delete.
+ * Weapons are not in the arena as agents keep them after the mission.
+ */
+class MissionArena {
+public:
+    /*!
+     * Objects of a group are allocated in the same chunks.
+     */
+    enum EGroup {
+        kGroupPeds = 0,
+        kGroupVehicles = 1,
+        kGroupStatics = 2,
+        kNbGroups = 3
+    };
+
+    //! Size of a chunk of memory
+    static const size_t kChunkSize;
+
+    MissionArena();
+    ~MissionArena();
+
+    //! Returns a block of the given size in the given group
+    void * allocate(size_t size, EGroup group);
+    //! Frees all chunks
+    void release();
+
+    /*!
+     * Calls the destructor of an object allocated in the arena. Memory
+     * is only released with release().
+     */
+    template <class T> static void destroy(T *pObject) {
+        if (pObject) {
+            pObject->~T();
+        }
+    }
+
+    //! Logs memory used by each group
+    void logStats();
+
+private:
+    /*!
+     * Chunks of a group. Only the last chunk has free space.
+     */
+    struct Group {
+        std::vector<char *> chunks;
+        /*! Used bytes in the last chunk.*/
+        size_t used;
+        /*! Number of objects allocated.*/
+        uint32 nbObjects;
+        /*! Number of bytes allocated to objects.*/
+        size_t nbBytes;
+    };
+
+    Group groups_[kNbGroups];
+};
+
+//! Allocates an object in the given group of the arena
+void * operator new(size_t size, MissionArena &arena, MissionArena::EGroup group);
+//! Only called if a constructor throws an exception
+void operator delete(void *pBlock, MissionArena &arena, MissionArena::EGroup group);
+
+#endif // MISSIONARENA_H
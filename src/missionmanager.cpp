@@ -23,8 +23,11 @@
  ************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 
+#include <SDL_thread.h>
+
 #include "missionmanager.h"
 #include "app.h"
 #include "utils/file.h"
@@ -68,6 +71,15 @@ private:
 
 MissionManager::MissionManager()
 {
+    pPreload_ = NULL;
+    pBriefingData_ = NULL;
+    briefingDataId_ = -1;
+}
+
+MissionManager::~MissionManager()
+{
+    cancelPreload();
+    delete pBriefingData_;
 }
 
 /*!
@@ -109,15 +121,23 @@ MissionBriefing *MissionManager::loadBriefing(int n) {
     delete[] data;
 
     // Loads the mission to get the minimap
-    LevelData::LevelDataAll level_data;
-    if (load_level_data(n, level_data)) {
-        uint16 map_id = READ_LE_UINT16(level_data.mapinfos.map);
+    LevelData::LevelDataAll *pLevelData = new LevelData::LevelDataAll;
+    if (load_level_data(n, *pLevelData)) {
+        uint16 map_id = READ_LE_UINT16(pLevelData->mapinfos.map);
         Map *p_map = g_App.maps().loadMap(map_id);
         if (p_map == NULL) {
+            delete pLevelData;
             delete p_mb;
             return NULL;
         }
-        p_mb->init_minimap(p_map, level_data);
+        p_mb->init_minimap(p_map, *pLevelData);
+
+        // keep the data for preloadMission()
+        delete pBriefingData_;
+        pBriefingData_ = pLevelData;
+        briefingDataId_ = n;
+    } else {
+        delete pLevelData;
     }
 
     return p_mb;
@@ -134,6 +154,26 @@ Mission *MissionManager::loadMission(int n)
 {
     LOG(Log::k_FLG_IO, "MissionManager", "loadMission()", ("loading mission %i", n));
 
+    // Use mission prepared in background if player has not changed his mind
+    if (pPreload_ && pPreload_->missionId == n) {
+        SDL_WaitThread(pPreload_->pThread, NULL);
+        pPreload_->pThread = NULL;
+
+        Mission *m = pPreload_->pMission;
+        if (m && pPreload_->surfacesSet) {
+            LOG(Log::k_FLG_IO, "MissionManager", "loadMission()", ("using preloaded mission %i", n));
+            createWeapons(*(pPreload_->pLevelData), pPreload_->di, m);
+            createObjectives(*(pPreload_->pLevelData), pPreload_->di, m);
+            setupAgents(m);
+            g_App.maps().setSurfacesMemory(m->mapId(), m->surfacesMemorySize());
+            // mission is no longer owned by the job
+            pPreload_->pMission = NULL;
+            destroyPreload();
+            return m;
+        }
+    }
+    cancelPreload();
+
     // Initialize LevelData structure from data read in file
     LevelData::LevelDataAll level_data;
     if (load_level_data(n, level_data)) {
@@ -148,6 +188,7 @@ Mission *MissionManager::loadMission(int n)
             }
             m->set_map(p_map);
             m->setSurfaces();
+            g_App.maps().setSurfacesMemory(m->mapId(), m->surfacesMemorySize());
         }
 
         return m;
@@ -156,6 +197,182 @@ Mission *MissionManager::loadMission(int n)
     return NULL;
 }
 
+/*!
+ * Starts preparing the given mission while the player is still in the menus.
+ * Level data read by loadBriefing() is reused and the map is taken from
+ * the cache, then the mission is built and its surfaces are computed in
+ * a background thread. Any previous preloading for another mission is
+ * cancelled. The result is used by loadMission() if it is called with
+ * the same id.
+ * \param n Mission id
+ */
+void MissionManager::preloadMission(int n) {
+    if (pPreload_ && pPreload_->missionId == n) {
+        // already loading
+        return;
+    }
+    cancelPreload();
+
+    PreloadJob *pJob = new PreloadJob();
+    pJob->missionId = n;
+    pJob->pLevelData = NULL;
+    pJob->pMap = NULL;
+    pJob->pMission = NULL;
+    pJob->surfacesSet = false;
+    pJob->cancelled = false;
+    pJob->pMutex = NULL;
+    pJob->pThread = NULL;
+    pJob->pManager = this;
+
+    if (pBriefingData_ && briefingDataId_ == n) {
+        pJob->pLevelData = pBriefingData_;
+        pBriefingData_ = NULL;
+        briefingDataId_ = -1;
+    } else {
+        pJob->pLevelData = new LevelData::LevelDataAll;
+        if (!load_level_data(n, *(pJob->pLevelData))) {
+            delete pJob->pLevelData;
+            delete pJob;
+            return;
+        }
+    }
+
+    // MapManager is not thread safe so the map is loaded here
+    pJob->pMap = g_App.maps().loadMap(READ_LE_UINT16(pJob->pLevelData->mapinfos.map));
+    if (pJob->pMap == NULL) {
+        delete pJob->pLevelData;
+        delete pJob;
+        return;
+    }
+
+    pJob->pMutex = SDL_CreateMutex();
+    pJob->pThread = SDL_CreateThread(runPreload, pJob);
+    if (pJob->pThread == NULL) {
+        FSERR(Log::k_FLG_IO, "MissionManager", "preloadMission", ("Cannot create thread to preload mission %i\n", n));
+        SDL_DestroyMutex(pJob->pMutex);
+        delete pJob->pLevelData;
+        delete pJob;
+        return;
+    }
+    // the thread is reading the map so it must stay in cache
+    g_App.maps().lockMap(pJob->pMap->id());
+
+    LOG(Log::k_FLG_IO, "MissionManager", "preloadMission()", ("preloading mission %i", n));
+    pPreload_ = pJob;
+}
+
+bool MissionManager::isCancelled(PreloadJob *pJob) {
+    SDL_mutexP(pJob->pMutex);
+    bool cancelled = pJob->cancelled;
+    SDL_mutexV(pJob->pMutex);
+    return cancelled;
+}
+
+/*!
+ * Builds the preloaded mission without our agents, weapons and objectives
+ * and computes its surfaces unless the job has been cancelled.
+ * While the thread runs, no mission is played so the thread is the only
+ * one to use the object pools. Weapons are not created here as the menus
+ * use the weapon manager and create weapon instances : they are created
+ * by loadMission() with the objectives that refer to them. For the same
+ * reason, enemy agents get their mods in setupAgents().
+ * The mission is never destroyed here as it would unlock the map.
+ * \param data The PreloadJob
+ * \return always 0
+ */
+int MissionManager::runPreload(void *data) {
+    PreloadJob *pJob = (PreloadJob *) data;
+
+    if (isCancelled(pJob)) {
+        return 0;
+    }
+
+    pJob->pMission = pJob->pManager->createMissionBase(*(pJob->pLevelData),
+        pJob->di, false);
+    if (pJob->pMission == NULL) {
+        return 0;
+    }
+    // the lock taken by preloadMission() now belongs to the mission
+    pJob->pMission->set_map(pJob->pMap, false);
+
+    if (isCancelled(pJob)) {
+        return 0;
+    }
+
+    pJob->surfacesSet = pJob->pMission->setSurfaces();
+
+    return 0;
+}
+
+/*!
+ * Cancels the current preloading if any. This is used when the player
+ * leaves the mission he was looking at.
+ */
+void MissionManager::cancelPreload() {
+    if (pPreload_ == NULL) {
+        return;
+    }
+
+    LOG(Log::k_FLG_IO, "MissionManager", "cancelPreload()", ("cancel preload of mission %i", pPreload_->missionId));
+    SDL_mutexP(pPreload_->pMutex);
+    pPreload_->cancelled = true;
+    SDL_mutexV(pPreload_->pMutex);
+
+    destroyPreload();
+}
+
+void MissionManager::destroyPreload() {
+    if (pPreload_->pThread) {
+        SDL_WaitThread(pPreload_->pThread, NULL);
+    }
+    if (pPreload_->pMission) {
+        // also releases the lock on the map
+        delete pPreload_->pMission;
+    } else {
+        g_App.maps().unlockMap(pPreload_->pMap->id());
+    }
+    SDL_DestroyMutex(pPreload_->pMutex);
+    delete pPreload_->pLevelData;
+    delete pPreload_;
+    pPreload_ = NULL;
+}
+
+/*!
+ * Our agents have been created for every slot found in the mission file
+ * by the preload as the squad was not known yet. Agents of inactive
+ * slots are removed and the others are set up from the squad members
+ * like PedManager::loadInstance() does. Enemy agents get their mods
+ * here as research may have found new ones during the preload.
+ * \param pMission The preloaded mission
+ */
+void MissionManager::setupAgents(Mission *pMission) {
+    PedManager peds;
+    size_t i = 0;
+    while (i < pMission->numPeds()) {
+        PedInstance *pPed = pMission->ped(i);
+        if (!pPed->isOurAgent()) {
+            if (pPed->objGroupDef() == PedInstance::og_dmAgent) {
+                peds.addEnemyMods(pPed);
+            }
+            i++;
+            continue;
+        }
+
+        uint16 slot = pPed->id();
+        if (g_gameCtrl.agents().isSquadSlotActive(slot)) {
+            peds.initOurAgent(g_gameCtrl.agents().squadMember(slot),
+                PedInstance::kPlayerGroupId, pPed);
+            pMission->getSquad()->setMember(slot, pPed);
+            i++;
+        } else {
+            if (pPed->inVehicle()) {
+                pPed->inVehicle()->dropPassenger(pPed);
+            }
+            pMission->removePed(i);
+        }
+    }
+}
+
 /*!
  * Creates a Mission object from the LevelDataAll structure and fills the overlay for the
  * briefing minimap.
@@ -189,6 +406,7 @@ bool MissionManager::load_level_data(int n, LevelData::LevelDataAll &level_data)
     copydata(mapinfos, 113960);
     copydata(objectives, 113974);
     copydata(u11, 114058);
+    delete[] data;
 
     return true;
 }
@@ -320,12 +538,31 @@ void MissionManager::exportMissionData(LevelData::LevelDataAll &level_data, Miss
 
 /*!
  * Creates a Mission object from the LevelDataAll structure.
+ * \param level_data Data read from the mission file
  */
 Mission * MissionManager::create_mission(LevelData::LevelDataAll &level_data) {
+    DataIndex di;
+    Mission *p_mission = createMissionBase(level_data, di, true);
+    if (p_mission) {
+        createWeapons(level_data, di, p_mission);
+        createObjectives(level_data, di, p_mission);
+    }
+    return p_mission;
+}
+
+/*!
+ * Creates a Mission object from the LevelDataAll structure without its
+ * weapons and objectives. It does not use the weapon manager.
+ * \param level_data Data read from the mission file
+ * \param di Indexes to fill for createWeapons() and createObjectives()
+ * \param withSquad If false, our agents are created for all slots and are
+ * not set up from the squad (see setupAgents()).
+ */
+Mission * MissionManager::createMissionBase(LevelData::LevelDataAll &level_data,
+        DataIndex &di, bool withSquad) {
     Mission *p_mission = new Mission(level_data.mapinfos);
 
     // Init indexes
-    DataIndex di;
     memset(di.vindx, 0xFF, 2*64);
     memset(di.pindx, 0xFF, 2*256);
     memset(di.driverindx, 0xFF, 2*256);
@@ -334,22 +571,18 @@ Mission * MissionManager::create_mission(LevelData::LevelDataAll &level_data) {
     try {
         createVehicles(level_data, di, p_mission);
 
-        createPeds(level_data, di, p_mission);
+        createPeds(level_data, di, p_mission, withSquad);
 
         for (uint16 i = 0; i < 400; i++) {
             LevelData::Statics & sref = level_data.statics[i];
             if(sref.desc == 0)
                 continue;
-            Static *s = Static::loadInstance((uint8 *) & sref, i, p_mission->mapId());
+            Static *s = Static::loadInstance((uint8 *) & sref, i, p_mission->mapId(), p_mission->arena());
             if (s) {
                 p_mission->addStatic(s);
             }
         }
 
-        createWeapons(level_data, di, p_mission);
-
-        createObjectives(level_data, di, p_mission);
-
 #ifdef SHOW_SCENARIOS_DEBUG
     for (uint16 i = 1; i < 2047; i++) {
         LevelData::Scenarios & scenario = level_data.scenarios[i];
@@ -495,7 +728,7 @@ void MissionManager::createVehicles(const LevelData::LevelDataAll &level_data, D
         if (car.type == 0x0)
             continue;
         Vehicle *v =
-            createVehicleInstance(car, i, pMission->mapId());
+            createVehicleInstance(car, i, pMission->mapId(), pMission->arena());
         if (v) {
             di.vindx[i] = pMission->numVehicles();
             pMission->addVehicle(v);
@@ -521,7 +754,7 @@ void MissionManager::createVehicles(const LevelData::LevelDataAll &level_data, D
 /*!
  *
  */
-Vehicle * MissionManager::createVehicleInstance(const LevelData::Cars &gamdata, uint16 id, uint16 map) {
+Vehicle * MissionManager::createVehicleInstance(const LevelData::Cars &gamdata, uint16 id, uint16 map, MissionArena &arena) {
 
     int hp = READ_LE_INT16(gamdata.health);
     int dir = gamdata.orientation >> 5;
@@ -533,14 +766,14 @@ Vehicle * MissionManager::createVehicleInstance(const LevelData::Cars &gamdata,
     Vehicle *pVehicle = NULL;
     if (gamdata.sub_type == Vehicle::kVehicleTypeTrainHead) {
         LOG(Log::k_FLG_GAME, "MissionManager","createVehicleInstance", ("Create Train Head %d", id))
-        pVehicle = new TrainHead(id, Vehicle::kVehicleTypeTrainHead, vehicleanim, hp, gamdata.orientation == 192);
+        pVehicle = new (arena, MissionArena::kGroupVehicles) TrainHead(id, Vehicle::kVehicleTypeTrainHead, vehicleanim, hp, gamdata.orientation == 192);
     } else if (gamdata.sub_type == Vehicle::kVehicleTypeTrainBody) {
         LOG(Log::k_FLG_GAME, "MissionManager","createVehicleInstance", ("Create Train Body %d", id))
-        pVehicle = new TrainBody(id, Vehicle::kVehicleTypeTrainBody, vehicleanim, hp, gamdata.orientation == 192);
+        pVehicle = new (arena, MissionArena::kGroupVehicles) TrainBody(id, Vehicle::kVehicleTypeTrainBody, vehicleanim, hp, gamdata.orientation == 192);
     } else {
         // standard car
         LOG(Log::k_FLG_GAME, "MissionManager","createVehicleInstance", ("Create generic car %d", id))
-        pVehicle = new GenericCar(vehicleanim, id, gamdata.sub_type, map);
+        pVehicle = new (arena, MissionArena::kGroupVehicles) GenericCar(vehicleanim, id, gamdata.sub_type, map);
         pVehicle->setHealth(hp);
         pVehicle->setStartHealth(hp);
 
@@ -605,7 +838,7 @@ Vehicle * MissionManager::createVehicleInstance(const LevelData::Cars &gamdata,
     return pVehicle;
 }
 
-void MissionManager::createPeds(const LevelData::LevelDataAll &level_data, DataIndex &di, Mission *pMission) {
+void MissionManager::createPeds(const LevelData::LevelDataAll &level_data, DataIndex &di, Mission *pMission, bool withSquad) {
 
 #if 0
     // for hacking peds data
@@ -633,7 +866,7 @@ void MissionManager::createPeds(const LevelData::LevelDataAll &level_data, DataI
         const LevelData::People & pedref = level_data.people[i];
 
         PedInstance *p =
-            peds.loadInstance(pedref, i, pMission->mapId(), PedInstance::kPlayerGroupId);
+            peds.loadInstance(pedref, i, pMission->mapId(), PedInstance::kPlayerGroupId, pMission->arena(), withSquad);
         if (p) {
             di.pindx[i] = pMission->numPeds();
             pMission->addPed(p);
@@ -668,7 +901,9 @@ void MissionManager::createPeds(const LevelData::LevelDataAll &level_data, DataI
 
             if (p->isOurAgent()) {
                 // adds the agent to the mission squad
-                pMission->getSquad()->setMember(i, p);
+                if (withSquad) {
+                    pMission->getSquad()->setMember(i, p);
+                }
             } else {
                 // Set scenarios for non player ped
                 createScriptedActionsForPed(pMission, di, level_data, p);
@@ -31,8 +31,12 @@
 #include "model/leveldata.h"
 #include "ia/actions.h"
 
+struct SDL_Thread;
+struct SDL_mutex;
 class Mission;
 class MissionBriefing;
+class MissionArena;
+class Map;
 class WeaponInstance;
 class VehicleInstance;
 class PedInstance;
@@ -44,10 +48,17 @@ class PedInstance;
 class MissionManager {
 public:
     MissionManager();
+    ~MissionManager();
     //! Loads mission for the given mission id
     Mission *loadMission(int n);
+    //! Starts loading the given mission in a background thread
+    void preloadMission(int n);
+    //! Stops and discards the current background loading
+    void cancelPreload();
     //! Loads briefing for the given mission id
     MissionBriefing *loadBriefing(int n);
+    //! Reads the mission file and return a representation of that file
+    bool load_level_data(int n, LevelData::LevelDataAll &level_data);
 
 private:
     /*!
@@ -69,13 +80,54 @@ private:
         DataIndex() : weapons() {}
     };
 
+    /*!
+     * Part of a mission loading that is done in a background thread
+     * while the player is in the briefing and squad selection menus.
+     * The mission is built and its surfaces are computed but our agents
+     * depend on the squad that is not yet selected : they are set up
+     * by loadMission(). Weapons and objectives are also created there
+     * as the menus use the weapon manager.
+     */
+    struct PreloadJob {
+        /*! Id of the preloaded mission.*/
+        int missionId;
+        /*! Level data read from the mission file.*/
+        LevelData::LevelDataAll *pLevelData;
+        /*! The mission map. It is locked for the job.*/
+        Map *pMap;
+        /*! The mission built by the thread. It owns the lock on the map.*/
+        Mission *pMission;
+        /*! Indexes used to create weapons and objectives after the thread.*/
+        DataIndex di;
+        /*! True if the surfaces of the mission have been computed.*/
+        bool surfacesSet;
+        /*! True when the player has abandoned the mission.*/
+        bool cancelled;
+        /*! Protects the cancelled flag.*/
+        SDL_mutex *pMutex;
+        /*! The thread doing the work.*/
+        SDL_Thread *pThread;
+        /*! The manager that builds the mission.*/
+        MissionManager *pManager;
+    };
+
 private:
+    //! Body of the preload thread
+    static int runPreload(void *data);
+    //! Waits for the preload thread and frees the job
+    void destroyPreload();
+    //! Returns true if the preload job has been cancelled
+    static bool isCancelled(PreloadJob *pJob);
+    //! Sets up our agents in a mission built without the squad
+    void setupAgents(Mission *pMission);
+
     //! When loading missions, possibly adds some info to the data
     void hackMissions(int n, uint8 *data);
-    //! Reads the mission file and return a representation of that file
-    bool load_level_data(int n, LevelData::LevelDataAll &level_data);
     // Instanciate a mission from the data file
     Mission * create_mission(LevelData::LevelDataAll &level_data);
+    //! Instanciate a mission without its weapons and objectives
+    Mission * createMissionBase(LevelData::LevelDataAll &level_data,
+                            DataIndex &di, bool withSquad);
     //! Creates all weapons
     void createWeapons(const LevelData::LevelDataAll &level_data, DataIndex &di, Mission *pMission);
     //! Creates a weapon from the game data
@@ -84,10 +136,10 @@ private:
     void createVehicles(const LevelData::LevelDataAll &level_data,
                             DataIndex &di, Mission *pMission);
     //! Creates a vehicle from the game data
-    Vehicle * createVehicleInstance(const LevelData::Cars &gamdata, uint16 id, uint16 map);
+    Vehicle * createVehicleInstance(const LevelData::Cars &gamdata, uint16 id, uint16 map, MissionArena &arena);
     //! Creates all peds
     void createPeds(const LevelData::LevelDataAll &level_data,
-                            DataIndex &di, Mission *pMission);
+                            DataIndex &di, Mission *pMission, bool withSquad);
     void createScriptedActionsForPed(Mission *pMission,
                                         DataIndex &di,
                                         const LevelData::LevelDataAll &level_data,
@@ -98,6 +150,14 @@ private:
 
     //! Export data for debug (will be moved in editor)
     void exportMissionData(LevelData::LevelDataAll &level_data, Mission *pMission);
+
+private:
+    /*! Current background loading. May be null.*/
+    PreloadJob *pPreload_;
+    /*! Level data read by the last loadBriefing(). May be null.*/
+    LevelData::LevelDataAll *pBriefingData_;
+    /*! Id of the mission of pBriefingData_.*/
+    int briefingDataId_;
 };
 
 #endif
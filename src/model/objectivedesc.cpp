@@ -36,10 +36,8 @@
 void ObjectiveDesc::endObjective(bool succeeded) {
     status = succeeded ? kCompleted : kFailed;
 
-    GameEvent evt;
-    evt.stream = GameEvent::kMission;
-    evt.type = succeeded ? GameEvent::kObjCompleted : GameEvent::kObjFailed;
-    evt.pCtxt = NULL;
+    GameEvent evt(GameEvent::kMission,
+                  succeeded ? GameEvent::kObjCompleted : GameEvent::kObjFailed);
     g_gameCtrl.fireGameEvent(evt);
 }
 
@@ -47,15 +45,14 @@ void ObjectiveDesc::endObjective(bool succeeded) {
  * All targeted objectives sets the current target to the objective target.
  */
 void TargetObjective::handleStart(Mission *p_mission) {
-    GameEvent evt;
-    evt.stream = GameEvent::kMission;
-    evt.type = GameEvent::kObjTargetSet;
-    evt.pCtxt = p_target_;
+    GameEvent evt(GameEvent::kMission, GameEvent::kObjTargetSet);
+    evt.pTarget = p_target_;
     g_gameCtrl.fireGameEvent(evt);
 }
 
 ObjPersuade::ObjPersuade(MapObject * pMapObject) : TargetObjective(pMapObject) {
     msg = g_Ctx.getMessage("GOAL_PERSUADE");
+    triggers_ = kObjTrigDeath | kObjTrigPersuasion;
 }
 
 /*!
@@ -76,6 +73,7 @@ void ObjPersuade::evaluate(Mission *pMission) {
 
 ObjAssassinate::ObjAssassinate(MapObject * pMapObject) : TargetObjective(pMapObject) {
     msg = g_Ctx.getMessage("GOAL_ASSASSINATE");
+    triggers_ = kObjTrigDeath | kObjTrigEscape;
 }
 
 /*!
@@ -95,6 +93,7 @@ void ObjAssassinate::evaluate(Mission *pMission) {
 
 ObjProtect::ObjProtect(MapObject * pMapObject) : TargetObjective(pMapObject) {
     msg = g_Ctx.getMessage("GOAL_PROTECT");
+    triggers_ = kObjTrigDeath | kObjTrigActionsDone;
 }
 
 /*!
@@ -140,6 +139,7 @@ void ObjDestroyVehicle::evaluate(Mission *pMission) {
  */
 ObjUseVehicle::ObjUseVehicle(MapObject * pVehicle) : TargetObjective(pVehicle) {
     msg = g_Ctx.getMessage("GOAL_USE_VEHICLE");
+    triggers_ = kObjTrigDeath | kObjTrigVehicleEntry;
 }
 
 /*!
@@ -167,6 +167,7 @@ void ObjUseVehicle::evaluate(Mission *pMission) {
  */
 ObjTakeWeapon::ObjTakeWeapon(MapObject * pWeapon) : TargetObjective(pWeapon) {
     msg = g_Ctx.getMessage("GOAL_TAKE_WEAPON");
+    triggers_ = kObjTrigDeath | kObjTrigWeaponTaken;
 }
 
 /*!
@@ -190,6 +191,8 @@ void ObjTakeWeapon::evaluate(Mission *pMission) {
 
 ObjEliminate::ObjEliminate(PedInstance::objGroupDefMasks subtype) :
         ObjectiveDesc() {
+    // persuaded peds change group so they count as eliminated
+    triggers_ = kObjTrigDeath | kObjTrigPersuasion;
     if (subtype == PedInstance::og_dmAgent) {
         msg = g_Ctx.getMessage("GOAL_ELIMINATE_AGENTS");
         groupDefMask_ = subtype;
@@ -227,6 +230,7 @@ void ObjEliminate::evaluate(Mission *pMission) {
 ObjEvacuate::ObjEvacuate(int x, int y, int z, std::vector <PedInstance *> &lstOfPeds) :
         LocationObjective(x, y, z) {
     msg = g_Ctx.getMessage("GOAL_EVACUATE");
+    triggers_ = kObjTrigDeath | kObjTrigSquadMove;
     // Copy all peds in the local list
     for (std::vector<PedInstance *>::iterator it_p = lstOfPeds.begin();
             it_p != lstOfPeds.end(); it_p++)
@@ -236,14 +240,26 @@ ObjEvacuate::ObjEvacuate(int x, int y, int z, std::vector <PedInstance *> &lstOf
 }
 
 void ObjEvacuate::handleStart(Mission *p_mission) {
-    GameEvent evt;
-    evt.stream = GameEvent::kMission;
-    evt.type = GameEvent::kObjEvacuate;
-    evt.pCtxt = &objectiveLocw_;
+    GameEvent evt(GameEvent::kMission, GameEvent::kObjEvacuate);
+    evt.locW = objectiveLocw_;
     g_gameCtrl.fireGameEvent(evt);
 }
 
 
+/*!
+ * Returns true if the object is one of the peds to evacuate.
+ * \param pObject The object
+ */
+bool ObjEvacuate::isTarget(MapObject *pObject) {
+    for (std::vector<PedInstance *>::iterator it_p
+        = pedsToEvacuate.begin(); it_p != pedsToEvacuate.end(); it_p++) {
+        if (*it_p == pObject) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*!
  * Evaluate the objective.
  * \param pMission
@@ -45,6 +45,29 @@ enum EObjectiveStatus {
     kCompleted
 };
 
+/*!
+ * State changes that can end an objective. Each objective is only
+ * evaluated when one of the changes it has subscribed to has occured
+ * since the last evaluation.
+ */
+enum EObjectiveTrigger {
+    kObjTrigNone = 0x00,
+    //! A ped, vehicle or weapon has been destroyed
+    kObjTrigDeath = 0x01,
+    //! A ped has been persuaded
+    kObjTrigPersuasion = 0x02,
+    //! A ped has escaped the map
+    kObjTrigEscape = 0x04,
+    //! A ped has taken the wheel of a vehicle
+    kObjTrigVehicleEntry = 0x08,
+    //! A weapon has been picked up
+    kObjTrigWeaponTaken = 0x10,
+    //! A ped has finished all his actions
+    kObjTrigActionsDone = 0x20,
+    //! An agent or a persuaded ped has moved to another tile
+    kObjTrigSquadMove = 0x40
+};
+
 class Mission;
 
 /*!
@@ -57,6 +80,7 @@ public:
         status = kNotStarted;
         subobjindx = 0;
         nxtobjindx = 0;
+        triggers_ = kObjTrigDeath;
     }
 
     virtual ~ObjectiveDesc() {};
@@ -84,6 +108,12 @@ public:
         return status == kCompleted || status == kFailed;
     }
 
+    //! Returns the mask of EObjectiveTrigger that require an evaluation
+    uint32 triggers() { return triggers_; }
+
+    //! Returns true if the given object is a target of this objective
+    virtual bool isTarget(MapObject *pObject) { return false; }
+
     /*!
      * This method declares the objective as 'started'.
      * Then calls handleStart() to give the class the ability
@@ -112,6 +142,10 @@ protected:
      * \param succeeded True means objective is completed with success.
      */
     void endObjective(bool succeeded);
+
+protected:
+    /*! Mask of EObjectiveTrigger the objective has subscribed to.*/
+    uint32 triggers_;
 };
 
 /*!
@@ -139,6 +173,8 @@ public:
     }
 
     MapObject * target() { return p_target_; }
+
+    bool isTarget(MapObject *pObject) { return pObject == p_target_; }
 protected:
     /*!
      * All targeted objectives sends the same event to indicate
@@ -238,6 +274,8 @@ public:
 
     void evaluate(Mission *pMission);
 
+    bool isTarget(MapObject *pObject);
+
 protected:
     std::vector <PedInstance *> pedsToEvacuate;
 };
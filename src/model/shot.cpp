@@ -32,6 +32,7 @@
 #include "mission.h"
 #include "ped.h"
 #include "vehicle.h"
+#include "utils/blockpool.h"
 
 void InstantImpactShot::inflictDamage(Mission *pMission) {
     WorldPoint originLocW(dmg_.d_owner->position()); // origin of shooting
@@ -281,7 +282,11 @@ void Explosion::inflictDamage(Mission *pMission) {
     // create the ring of fire around the origin of explosion
     generateFlameWaves(pMission, &(dmg_.originLocW), dmg_.range);
 
-    g_App.gameSounds().play(snd::EXPLOSION_BIG);
+    TilePoint originTp;
+    Point2D scPt;
+    dmg_.originLocW.convertToTilePoint(&originTp);
+    pMission->get_map()->tileToScreenPoint(originTp, &scPt);
+    g_App.gameSounds().queue(snd::EXPLOSION_BIG, scPt);
 }
 
 /*! Draws animation of impact/explosion
@@ -381,6 +386,24 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
     }
 }
 
+/*!
+ * All kinds of projectiles share the same pool. Gauss gun and flamer
+ * shots have different sizes so they use different free lists.
+ */
+static fs_utils::BlockPool gProjectilePool("ProjectileShot", 32);
+
+void * ProjectileShot::operator new(size_t size) {
+    return gProjectilePool.allocate(size);
+}
+
+void ProjectileShot::operator delete(void *pBlock, size_t size) {
+    gProjectilePool.release(pBlock, size);
+}
+
+void ProjectileShot::logPoolStats() {
+    gProjectilePool.logStats();
+}
+
 ProjectileShot::ProjectileShot(const fs_dmg::DamageToInflict &dmg) : Shot(dmg) {
     elapsed_ = -1;
     curPosW_ = dmg.originLocW;
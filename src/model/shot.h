@@ -116,6 +116,13 @@ class ProjectileShot: public Shot {
     //! Constructor
     explicit ProjectileShot(const fs_dmg::DamageToInflict &dmg);
 
+    //! Projectiles are allocated from a pool of recycled blocks
+    static void * operator new(size_t size);
+    //! Gives the block back to the pool
+    static void operator delete(void *pBlock, size_t size);
+    //! Logs allocation counters of the pool
+    static void logPoolStats();
+
     //! Animate the shot
     virtual bool animate(int elapsed, Mission *m);
 
@@ -28,6 +28,8 @@
 #include "train.h"
 #include "mission.h"
 #include "model/squad.h"
+#include "model/objectivedesc.h"
+#include "core/gamesession.h"
 
 TrainBody::TrainBody(uint16 anId, uint8 aType, VehicleAnimation *pAnimation, int startHp, bool isMoveOnXAxis) :
     Vehicle(anId, aType, -1, pAnimation) {
@@ -47,6 +49,7 @@ void TrainBody::dropAllPassengers(const Mission &mission, const TilePoint &dropP
         PedInstance *pPed = passengers_.front();
         pPed->leaveVehicle();
         pPed->setPosition(dropPos);
+        g_Session.getMission()->signalObjectiveTrigger(kObjTrigSquadMove);
         // when leaving train, passengers walk towards the station
         if (pPed->isOurAgent()) {
             TilePoint movePos(dropPos);
@@ -65,13 +68,7 @@ void TrainBody::dropAllPassengers(const Mission &mission, const TilePoint &dropP
 void TrainBody::changeTrainAndPassengersPosition(int distanceX, int distanceY) {
     addOffsetToPosition(distanceX, distanceY);
 
-    if (!passengers_.empty()) {
-        for (std::list<PedInstance *>::iterator it = passengers_.begin();
-            it != passengers_.end(); it++
-        ) {
-            (*it)->setPosition(pos_);
-        }
-    }
+    movePassengers();
 
     if (pNextBody_ != NULL) {
         pNextBody_->changeTrainAndPassengersPosition(distanceX, distanceY);
@@ -35,6 +35,7 @@
 #include "gfx/screen.h"
 #include "vehicle.h"
 #include "model/shot.h"
+#include "model/objectivedesc.h"
 
 const uint8 Vehicle::kVehicleTypeLargeArmored = 0x01;
 const uint8 Vehicle::kVehicleTypeLargeArmoredDamaged = 0x04;
@@ -147,6 +148,28 @@ bool Vehicle::containsOurAgents() {
     return false;
 }
 
+/*!
+ * Puts all passengers at the vehicle's position. Like when they walk,
+ * objectives are warned if our agents or persuaded peds change tile
+ * as they may have entered an evacuation zone.
+ */
+void Vehicle::movePassengers() {
+    bool squadMoved = false;
+    for (std::list<PedInstance *>::iterator it = passengers_.begin();
+        it != passengers_.end(); it++)
+    {
+        PedInstance *pPed = *it;
+        if ((pPed->isOurAgent() || pPed->isPersuaded()) && !pPed->sameTile(pos_)) {
+            squadMoved = true;
+        }
+        pPed->setPosition(pos_);
+    }
+
+    if (squadMoved) {
+        g_Session.getMission()->signalObjectiveTrigger(kObjTrigSquadMove);
+    }
+}
+
 /*!
  * Returns true if the vehicle contains peds considered hostile by the given ped.
  * \param pPed The ped evaluating the hostility of the vehicle
@@ -776,13 +799,7 @@ bool GenericCar::doMove(int elapsed, Mission *m)
                speed_);
         speed_ = 0;
     }
-    if (!passengers_.empty()) {
-        for (std::list<PedInstance *>::iterator it = passengers_.begin();
-            it != passengers_.end(); it++
-        ) {
-            (*it)->setPosition(pos_);
-        }
-    }
+    movePassengers();
 
     return updated;
 }
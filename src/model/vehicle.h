@@ -128,6 +128,10 @@ public:
     //! Returns true if the vehicle contains peds considered hostile by the given ped
     bool containsHostilesForPed(PedInstance *p, unsigned int hostile_desc_alt);
 
+protected:
+    //! Moves the passengers with the vehicle
+    void movePassengers();
+
 protected:
     /*! The passengers of the vehicle.*/
     std::list <PedInstance *> passengers_;
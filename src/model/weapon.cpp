@@ -36,6 +36,7 @@
 #include "mission.h"
 #include "model/shot.h"
 #include "core/gamesession.h"
+#include "model/objectivedesc.h"
 
 #define Z_SHIFT_TO_AIR   4
 
@@ -288,7 +289,12 @@ bool WeaponInstance::animate(int elapsed) {
     if (activated_) {
         if (isInstanceOf(Weapon::TimeBomb)) {
             if (bombSoundTimer.update(elapsed)) {
-                g_App.gameSounds().play(snd::TIMEBOMB);
+                Map *pMap = g_Session.getMission()->get_map();
+                if (pMap) {
+                    Point2D scPt;
+                    pMap->tileToScreenPoint(pos_, &scPt);
+                    g_App.gameSounds().queue(snd::TIMEBOMB, scPt);
+                }
             }
 
             if (bombExplosionTimer.update(elapsed)) {
@@ -348,10 +354,15 @@ void WeaponInstance::draw(int x, int y) {
 }
 
 /*!
- * Plays the sound associated with that weapon.
+ * Plays the sound associated with that weapon from the position
+ * of the ped holding it.
+ * \param pMission Mission data
  */
-void WeaponInstance::playSound() {
-    g_App.gameSounds().play(pWeaponClass_->getSound());
+void WeaponInstance::playSound(Mission *pMission) {
+    Point2D scPt;
+    MapObject *pSource = pOwner_ ? static_cast<MapObject *>(pOwner_) : this;
+    pMission->get_map()->tileToScreenPoint(pSource->position(), &scPt);
+    g_App.gameSounds().queue(pWeaponClass_->getSound(), scPt);
 }
 
 void WeaponInstance::activate() {
@@ -424,6 +435,7 @@ void WeaponInstance::fire(Mission *pMission, fs_dmg::DamageToInflict &dmg, int e
         updateStats = false;
         setDrawable(false);
         health_ = 0;
+        pMission->signalObjectiveTrigger(kObjTrigDeath);
         deactivate();
         Explosion::createExplosion(pMission, this,
             (double)pWeaponClass_->rangeDmg(), pWeaponClass_->damagePerShot());
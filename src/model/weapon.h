@@ -329,7 +329,7 @@ public:
     void reload() { ammo_remaining_ = pWeaponClass_->ammo(); }
 
     //! Plays the weapon's sound.
-    void playSound();
+    void playSound(Mission *pMission);
 
     void activate();
     void deactivate();
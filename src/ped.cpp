@@ -34,6 +34,7 @@
 #include "mission.h"
 #include "core/gamesession.h"
 #include "ia/behaviour.h"
+#include "model/objectivedesc.h"
 
 //*************************************
 // Constant definition
@@ -391,8 +392,7 @@ bool PedInstance::updateAnimation(int elapsed) {
 
 /*!
  * Animates the ped (ie executes all the ped's actions).
- * If Ped has currently no action, execute behaviour
- * to determine default actions. Then executes the actions.
+ * The ped's behaviour has already been run by the BehaviourRunner.
  * Ped can shoot while doing an action only if that action is not exclusive
  * (like dropping a weapon or entering a car).
  * Finally, update the animation. If an action is waiting for an animation
@@ -402,12 +402,16 @@ bool PedInstance::updateAnimation(int elapsed) {
  * \return True if something has changed (so update rendering)
  */
 bool PedInstance::animate(int elapsed, Mission *mission) {
-    // Execute current behaviour
-    behaviour_.execute(elapsed, mission);
+    TilePoint prevTile(pos_);
 
     // Execute any active action
     bool update = executeAction(elapsed, mission);
 
+    if ((isOurAgent() || isPersuaded()) && !sameTile(prevTile)) {
+        // squad may have entered an evacuation zone
+        mission->signalObjectiveTrigger(kObjTrigSquadMove);
+    }
+
     // cannot shoot if ped is doing something exlusive
     if (currentAction_ == NULL || !currentAction_->isExclusive()) {
         update |= executeUseWeaponAction(elapsed, mission);
@@ -436,6 +440,7 @@ bool PedInstance::animate(int elapsed, Mission *mission) {
  */
 bool PedInstance::executeAction(int elapsed, Mission *pMission) {
     bool updated = false;
+    bool hadActions = currentAction_ != NULL;
 
     while(currentAction_ != NULL) {
         // execute action
@@ -492,6 +497,10 @@ bool PedInstance::executeAction(int elapsed, Mission *pMission) {
         }
     }
 
+    if (hadActions && currentAction_ == NULL) {
+        pMission->signalObjectiveTrigger(kObjTrigActionsDone);
+    }
+
     return updated;
 }
 
@@ -924,6 +933,7 @@ void PedInstance::handleWeaponDeselected(WeaponInstance * wi) {
         behaviour_.handleBehaviourEvent(Behaviour::kBehvEvtPersuadotronDeactivated);
     } else if (wi->canShoot() && (type_ != kPedTypePolice || isPersuaded())) {
         // don't warn if ped is police to limit calls
+        g_Session.getMission()->removeArmedPed(this);
         GameEvent::sendEvt(GameEvent::kMission, GameEvent::kEvtShootingWeaponDeselected, this);
     }
 }
@@ -959,9 +969,12 @@ void PedInstance::handleWeaponSelected(WeaponInstance * wi, WeaponInstance * pre
     if (type_ != kPedTypePolice || isPersuaded()) {
         if (previousWeapon == NULL && selectedWeapon()->canShoot()) {
             // alert if it's the first time the ped shows a shooting weapon
+            // sensors must see the ped at the next tick so don't wait for the event
+            g_Session.getMission()->addArmedPed(this);
             GameEvent::sendEvt(GameEvent::kMission, GameEvent::kEvtShootingWeaponSelected, this);
         } else if (previousWeapon != NULL && previousWeapon->canShoot() && !selectedWeapon()->canShoot()) {
             // or alert if ped go from a shooting weapon to a no shooting weapon like the persuadotron
+            g_Session.getMission()->removeArmedPed(this);
             GameEvent::sendEvt(GameEvent::kMission, GameEvent::kEvtShootingWeaponDeselected, this);
         }
     }
@@ -1620,6 +1633,7 @@ void PedInstance::handlePersuadedBy(PedInstance *pAgent) {
     setObjGroupID(pAgent->objGroupID());
     owner_ = pAgent;
     setPanicImmuned();
+    g_Session.getMission()->signalObjectiveTrigger(kObjTrigPersuasion);
 
     behaviour_.replaceAllcomponentsBy(new PersuadedBehaviourComponent());
 
@@ -30,6 +30,7 @@
 #include "utils/log.h"
 #include "pedmanager.h"
 #include "core/gamecontroller.h"
+#include "missionarena.h"
 
 PedManager::PedManager()
 {
@@ -142,9 +143,13 @@ void PedManager::initAnimation(Ped *pedanim, unsigned short baseAnim)
  * \param gamdata
  * \param ped_idx Index of the ped in the file.
  * \param map id of the map
+ * \param arena The ped is allocated in this arena
+ * \param withSquad If false, our agents are created even if their slot is
+ * not active and they are not set up from the squad members. Enemy agents
+ * don't get their mods either (see addEnemyMods()).
  * \return NULL if the ped could not be created.
  */
-PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16 ped_idx, int map, uint32 playerGroupId)
+PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16 ped_idx, int map, uint32 playerGroupId, MissionArena &arena, bool withSquad)
 {
     if(gamdata.type == 0x0 ||
         gamdata.location == LevelData::kPeopleLocNotVisible ||
@@ -152,7 +157,7 @@ PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16
         return NULL;
 
     bool isOurAgent = ped_idx < AgentManager::kMaxSlot;
-    if (isOurAgent && !g_gameCtrl.agents().isSquadSlotActive(ped_idx)) {
+    if (isOurAgent && withSquad && !g_gameCtrl.agents().isSquadSlotActive(ped_idx)) {
         // Creates agent only if he's active
         return NULL;
     }if (ped_idx >= 4 && ped_idx < 8) {
@@ -163,7 +168,7 @@ PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16
 
     Ped *pedanim = new Ped();
     initAnimation(pedanim, READ_LE_UINT16(gamdata.index_base_anim));
-    PedInstance *newped = new PedInstance(pedanim, ped_idx, map, isOurAgent);
+    PedInstance *newped = new (arena, MissionArena::kGroupPeds) PedInstance(pedanim, ped_idx, map, isOurAgent);
 
     int hp = READ_LE_INT16(gamdata.health);
     if (isOurAgent) {
@@ -208,13 +213,18 @@ PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16
 
     if (isOurAgent) {
         // We're loading one of our agents
-        Agent *pAg = g_gameCtrl.agents().squadMember(ped_idx);
-        initOurAgent(pAg, playerGroupId, newped);
+        if (withSquad) {
+            Agent *pAg = g_gameCtrl.agents().squadMember(ped_idx);
+            initOurAgent(pAg, playerGroupId, newped);
+        }
     } else {
         unsigned int mt = newped->type();
         newped->setObjGroupDef(mt);
         if (mt == PedInstance::og_dmAgent) {
             initEnemyAgent(newped);
+            if (withSquad) {
+                addEnemyMods(newped);
+            }
         } else if (mt == PedInstance::og_dmGuard) {
             initGuard(newped);
         } else if (mt == PedInstance::og_dmPolice) {
@@ -272,7 +282,17 @@ void PedManager::initEnemyAgent(PedInstance *pPed) {
     pPed->setObjGroupID(2);
     pPed->addEnemyGroupDef(1);
     pPed->setBaseSpeed(256);
-    // enemies get top version of mods
+    pPed->setTimeBeforeCheck(400);
+    pPed->setBaseModAcc(0.5);
+
+    pPed->behaviour().addComponent(new PlayerHostileBehaviourComponent());
+}
+
+/*!
+ * Enemies get top version of mods among those the player has found.
+ * \param pPed The enemy agent
+ */
+void PedManager::addEnemyMods(PedInstance *pPed) {
     pPed->addMod(g_gameCtrl.mods().getHighestVersion(Mod::MOD_LEGS));
     pPed->addMod(g_gameCtrl.mods().getHighestVersion(Mod::MOD_LEGS));
     pPed->addMod(g_gameCtrl.mods().getHighestVersion(Mod::MOD_ARMS));
@@ -280,10 +300,6 @@ void PedManager::initEnemyAgent(PedInstance *pPed) {
     pPed->addMod(g_gameCtrl.mods().getHighestVersion(Mod::MOD_HEART));
     pPed->addMod(g_gameCtrl.mods().getHighestVersion(Mod::MOD_EYES));
     pPed->addMod(g_gameCtrl.mods().getHighestVersion(Mod::MOD_BRAIN));
-    pPed->setTimeBeforeCheck(400);
-    pPed->setBaseModAcc(0.5);
-
-    pPed->behaviour().addComponent(new PlayerHostileBehaviourComponent());
 }
 
 /*!
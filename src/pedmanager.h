@@ -33,6 +33,8 @@
 #include "ped.h"
 #include "model/leveldata.h"
 
+class MissionArena;
+
 
 /*!
  * Pedestrians manager class.
@@ -42,11 +44,13 @@ public:
     PedManager();
     virtual ~PedManager() {}
 
-    PedInstance *loadInstance(const LevelData::People & ped_data, uint16 ped_idx, int map, uint32 playerGroupId);
-protected:
-    void initAnimation(Ped *pedanim, unsigned short baseAnim);
+    PedInstance *loadInstance(const LevelData::People & ped_data, uint16 ped_idx, int map, uint32 playerGroupId, MissionArena &arena, bool withSquad = true);
     //! Initialize the ped instance as our agent
     void initOurAgent(Agent *p_agent, unsigned int obj_group_id, PedInstance *pPed);
+    //! Gives the best available mods to an enemy agent
+    void addEnemyMods(PedInstance *pPed);
+protected:
+    void initAnimation(Ped *pedanim, unsigned short baseAnim);
     //! Initialize the ped instance as an enemy agent
     void initEnemyAgent(PedInstance *pPed);
     //! Initialize the ped instance as a guard
@@ -24,10 +24,14 @@
  *                                                                      *
  ************************************************************************/
 
+#include <stdio.h>
+#include <string.h>
+
 #include "config.h"
 #include "audio.h"
 #include "musicmanager.h"
 #include "xmidi.h"
+#include "utils/ccrc32.h"
 #include "utils/file.h"
 #include "utils/log.h"
 
@@ -41,11 +45,16 @@ MusicManager::MusicManager(bool disabled):is_playing_(false), disabled_(disabled
 MusicManager::~MusicManager()
 {
     for (unsigned int i = 0; i < tracks_.size(); ++i) {
-        delete tracks_[i];
+        delete tracks_[i].pMusic;
+        delete[] tracks_[i].pData;
     }
     tracks_.clear();
 }
 
+/*!
+ * Only lists the available tracks : the XMidi files are read to count
+ * their tracks but nothing is converted until a track is played.
+ */
 void MusicManager::loadMusic()
 {
     // If audio has not been initialized -> do nothing
@@ -53,51 +62,141 @@ void MusicManager::loadMusic()
         return;
     }
 
-    XMidi xmidi;
-    std::vector < XMidi::Midi > tracks;
-    int size;
-    uint8 *data;
-
 #if USE_INTRO_OGG
-    tracks_.push_back(new Music);
-    tracks_.back()->loadMusicFile("music/intro.ogg");
+    addMusicFileTrack("music/intro.ogg");
 #else
-    data = File::loadOriginalFile("INTRO.XMI", size);
-    tracks = xmidi.convertXMidi(data, size);
-    for (unsigned int i = 0; i < tracks.size(); ++i) {
-        tracks_.push_back(new Music);
-        tracks_.back()->loadMusic(tracks[i].data_, tracks[i].size_);
-    }
-    delete[] data;
+    addXMidiTracks("INTRO.XMI");
 #endif
 
-    data = File::loadOriginalFile("SYNGAME.XMI", size);
-    tracks = xmidi.convertXMidi(data, size);
-    for (unsigned int i = 0; i < tracks.size(); ++i) {
-        if (i == 0) {
+    size_t firstGameTrack = tracks_.size();
+    addXMidiTracks("SYNGAME.XMI");
 #if USE_ASSASSINATE_OGG
-            tracks_.push_back(new Music);
-            tracks_.back()->loadMusicFile("music/assassinate.ogg");
-#else
-            tracks_.push_back(new Music);
-            tracks_.back()->loadMusic(tracks[i].data_, tracks[i].size_);
+    if (tracks_.size() > firstGameTrack) {
+        tracks_[firstGameTrack].musicFile = "music/assassinate.ogg";
+    }
 #endif
-        } else {
-            tracks_.push_back(new Music);
-            tracks_.back()->loadMusic(tracks[i].data_, tracks[i].size_);
+    LOG(Log::k_FLG_SND, "MusicManager", "loadMusic", ("%d tracks found, first game track is %d",
+        (int) tracks_.size(), (int) firstGameTrack))
+}
+
+void MusicManager::addXMidiTracks(const char *filename)
+{
+    int size;
+    uint8 *data = File::loadOriginalFile(filename, size);
+    if (data == NULL) {
+        FSERR(Log::k_FLG_SND, "MusicManager", "addXMidiTracks", ("Cannot read %s", filename))
+        return;
+    }
+
+    CCRC32 crc;
+    unsigned int sourceCrc = crc.FullCRC(data, size);
+
+    XMidi xmidi;
+    int nbTracks = xmidi.countTracks(data, size);
+    delete[] data;
+
+    for (int i = 0; i < nbTracks; ++i) {
+        Track track;
+        track.source = filename;
+        track.index = i;
+        track.sourceCrc = sourceCrc;
+        track.pMusic = NULL;
+        track.pData = NULL;
+        tracks_.push_back(track);
+    }
+}
+
+void MusicManager::addMusicFileTrack(const char *filename)
+{
+    Track track;
+    track.index = 0;
+    track.sourceCrc = 0;
+    track.musicFile = filename;
+    track.pMusic = NULL;
+    track.pData = NULL;
+    tracks_.push_back(track);
+}
+
+/*!
+ * Midi tracks are looked for in the cache first. The name of the cached
+ * file contains the CRC of the XMidi file so a different version of the
+ * original data never uses an old conversion.
+ * \param track The track to convert
+ * \param size Set with the size of the midi data
+ * \return NULL if the track could not be converted.
+ */
+uint8 *MusicManager::getMidiData(const Track &track, int &size)
+{
+    char cacheName[32];
+    sprintf(cacheName, "%08x_%02d.mid", track.sourceCrc, track.index);
+
+    uint8 *midi = File::loadCacheFile(cacheName, size);
+    if (midi) {
+        if (size > 4 && memcmp(midi, "MThd", 4) == 0) {
+            LOG(Log::k_FLG_SND, "MusicManager", "getMidiData", ("Track %s:%d read from cache",
+                track.source.c_str(), track.index))
+            return midi;
         }
+        delete[] midi;
+    }
+
+    int xmiSize;
+    uint8 *data = File::loadOriginalFile(track.source, xmiSize);
+    if (data == NULL) {
+        return NULL;
     }
+
+    XMidi xmidi;
+    XMidi::Midi converted;
+    bool ok = xmidi.convertTrack(data, xmiSize, track.index, converted);
     delete[] data;
+    if (!ok) {
+        return NULL;
+    }
+
+    File::saveCacheFile(cacheName, converted.data_, converted.size_);
+    size = converted.size_;
+    return converted.data_;
+}
+
+bool MusicManager::loadTrack(Track &track)
+{
+    Music *pMusic = new Music;
+
+    if (!track.musicFile.empty()) {
+        if (!pMusic->loadMusicFile(track.musicFile.c_str())) {
+            delete pMusic;
+            return false;
+        }
+    } else {
+        int size = 0;
+        uint8 *data = getMidiData(track, size);
+        if (data == NULL || !pMusic->loadMusic(data, size)) {
+            FSERR(Log::k_FLG_SND, "MusicManager", "loadTrack", ("Cannot load track %d of %s",
+                track.index, track.source.c_str()))
+            delete pMusic;
+            delete[] data;
+            return false;
+        }
+        track.pData = data;
+    }
+
+    track.pMusic = pMusic;
+    return true;
 }
 
 void MusicManager::playTrack(msc::MusicTrack track, int loops)
 {
     if (disabled_) return;
     if (Audio::isInitialized()) {
+        Track &newTrack = tracks_.at(track);
+        if (newTrack.pMusic == NULL && !loadTrack(newTrack)) {
+            return;
+        }
         if (is_playing_) {
-            tracks_.at(current_track_)->stopFadeOut();
+            tracks_.at(current_track_).pMusic->stopFadeOut();
         }
-        tracks_.at(track)->play(loops);
+        newTrack.pMusic->play(loops);
         current_track_ = track;
         is_playing_ = true;
     }
@@ -107,7 +206,7 @@ void MusicManager::stopPlayback()
 {
     if (disabled_) return;
     if (Audio::isInitialized() && is_playing_) {
-        tracks_.at(current_track_)->stop();
+        tracks_.at(current_track_).pMusic->stop();
         is_playing_ = false;
     }
 }
@@ -30,6 +30,7 @@
 #include "common.h"
 #include "music.h"
 
+#include <string>
 #include <vector>
 
 /*!
@@ -51,7 +52,35 @@ public:
     void toggleMusic();
 
 protected:
-    std::vector<Music *> tracks_;
+    /*!
+     * A music track. Midi tracks are converted from the original XMidi
+     * files only the first time they are played.
+     */
+    struct Track {
+        /*! Original XMidi file the track comes from.*/
+        std::string source;
+        /*! Index of the track in the XMidi file.*/
+        int index;
+        /*! CRC of the XMidi file. Names the cached midi file.*/
+        unsigned int sourceCrc;
+        /*! If not empty, the track is played from this file.*/
+        std::string musicFile;
+        /*! NULL until the track is played for the first time.*/
+        Music *pMusic;
+        /*! Midi data played by pMusic. Must live as long as pMusic.*/
+        uint8 *pData;
+    };
+
+    //! Adds a track for each track of the given XMidi file
+    void addXMidiTracks(const char *filename);
+    //! Adds a track played from a music file
+    void addMusicFileTrack(const char *filename);
+    //! Loads the track so it can be played
+    bool loadTrack(Track &track);
+    //! Returns the track as a midi file, from the cache or converted
+    uint8 *getMidiData(const Track &track, int &size);
+
+    std::vector<Track> tracks_;
     msc::MusicTrack current_track_;
     bool is_playing_;
     /*! 
@@ -77,6 +77,23 @@ void SdlMixerSound::stop(int channel) const
     }
 }
 
+/*!
+ * Counts the mixer channels that are currently playing this sound.
+ */
+int SdlMixerSound::nbPlaying() const
+{
+    int count = 0;
+    if (Audio::isInitialized() && sound_data_) {
+        int nbChannels = Mix_AllocateChannels(-1);
+        for (int i = 0; i < nbChannels; i++) {
+            if (Mix_Playing(i) && Mix_GetChunk(i) == sound_data_) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
 /*!
  * Each sample has its own volume wich is taken into account
  * on the mixing phase. This method sets the volume of this
@@ -97,7 +114,9 @@ bool SdlMixerSound::setVolume(int volume)
 }
 
 /*!
- * Loads the sample from the given data.
+ * Loads the sample from the given data. SDL_mixer converts the sample
+ * to the format of the audio device so playing it needs no conversion.
+ * The given data is not used after the call.
  * \param soundData Data as loaded from original resource
  * \param size The size of the input data
  */
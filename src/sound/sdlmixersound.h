@@ -49,6 +49,10 @@ public:
     bool setVolume(int volume);
     //! Loads the sample from memory
     bool loadSound(uint8 *soundData, uint32 size);
+    //! Returns the number of channels playing the sound
+    int nbPlaying() const;
+    //! Returns the size of the converted sample
+    uint32 memorySize() const { return sound_data_ ? sound_data_->alen : 0; }
 
 protected:
     /*! The sdl structure that stores sound data.*/
@@ -97,6 +97,8 @@ public:
     void stop() const {;}
     bool setVolume(int volume) { return true; }
     bool loadSound(uint8 *soundData, uint32 size) { return true; }
+    uint32 memorySize() const { return 0; }
+    int nbPlaying() const { return 0; }
 };
 
 #define Sound DefaultSound
@@ -30,6 +30,74 @@
 #include "utils/file.h"
 #include "utils/log.h"
 
+//*************************************
+// Constant definition
+//*************************************
+/*! Sounds further than this distance from the viewport are not played.*/
+static const int kCullDistance = GAME_SCREEN_WIDTH;
+/*! Maximum number of channels playing the same sample.*/
+static const int kMaxVoicesPerSample = 2;
+/*! Maximum number of queued sounds started in one tick.*/
+static const int kMaxVoicesPerTick = 4;
+
+/*!
+ * Returns how important a sample is : a higher value is played first.
+ */
+static int samplePriority(snd::InGameSample sample) {
+    switch (sample) {
+    case snd::EXPLOSION_BIG:
+    case snd::EXPLOSION:
+        return 3;
+    case snd::PERSUADE:
+    case snd::TIMEBOMB:
+        return 2;
+    case snd::SHOTGUN:
+    case snd::PISTOL:
+    case snd::LASER:
+    case snd::FLAME:
+    case snd::UZI:
+    case snd::LONGRANGE:
+    case snd::MINIGUN:
+    case snd::GAUSSGUN:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*!
+ * Returns the distance in pixels between the point and the viewport,
+ * 0 if the point is visible.
+ */
+static int distanceToViewport(const Point2D &pos, int viewX, int viewY) {
+    int dx = 0;
+    int dy = 0;
+    if (pos.x < viewX) {
+        dx = viewX - pos.x;
+    } else if (pos.x >= viewX + GAME_SCREEN_WIDTH) {
+        dx = pos.x - (viewX + GAME_SCREEN_WIDTH - 1);
+    }
+    if (pos.y < viewY) {
+        dy = viewY - pos.y;
+    } else if (pos.y >= viewY + GAME_SCREEN_HEIGHT) {
+        dy = pos.y - (viewY + GAME_SCREEN_HEIGHT - 1);
+    }
+    return dx > dy ? dx : dy;
+}
+
+/*!
+ * Orders requests by priority then by distance to the viewport.
+ */
+bool SoundManager::compareRequests(const SoundRequest &r1,
+                                   const SoundRequest &r2) {
+    int p1 = samplePriority(r1.sample);
+    int p2 = samplePriority(r2.sample);
+    if (p1 != p2) {
+        return p1 > p2;
+    }
+    return r1.distance < r2.distance;
+}
+
 SoundManager::SoundManager(bool disabled):tabentry_startoffset_(58), tabentry_offset_(32), disabled_(disabled)
 {
     volumeBeforeMute_ = -1;
@@ -37,75 +105,86 @@ SoundManager::SoundManager(bool disabled):tabentry_startoffset_(58), tabentry_of
 
 SoundManager::~SoundManager()
 {
-    for(std::vector< Sound * >::iterator it = sounds_.begin(); it != sounds_.end(); ++it)
-    {
-        delete *it;
+    logMemoryUsage();
+    for (size_t i = 0; i < samples_.size(); ++i) {
+        delete samples_[i].pSound;
+    }
+    for (size_t i = 0; i < banks_.size(); ++i) {
+        delete[] banks_[i].data;
     }
 }
 
-Sound *SoundManager::sound(snd::InGameSample sample)
+/*!
+ * The sample is loaded from its bank the first time it is requested.
+ * \param sample The sample
+ * \param load If false, returns NULL for a sample that was never loaded
+ */
+Sound *SoundManager::sound(snd::InGameSample sample, bool load)
 {
     if (sample == snd::NO_SOUND)
         return NULL;
-    return sounds_.at(sample);
+    SampleDesc &desc = samples_.at(sample);
+    if (desc.pSound == NULL && load) {
+        desc.pSound = new Sound;
+        desc.pSound->loadSound(banks_[desc.bank].data + desc.offset, desc.size);
+    }
+    return desc.pSound;
 }
 
 
 bool SoundManager::loadSounds(SampleSet set)
 {
-    int tabSize, size;
-    uint8 *tabData, *data;
     switch (set) {
     case SAMPLES_INTRO:
-        {
-            tabData = File::loadOriginalFile("ISNDS-0.TAB", tabSize);
-            data = File::loadOriginalFile("ISNDS-0.DAT", size);
-            bool loaded = loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-            if (!loaded) {
-                printf("Error : Could not load sounds from file ISNDS-0.DAT\n");
-                return false;
-            }
-            tabData = File::loadOriginalFile("ISNDS-1.TAB", tabSize);
-            data = File::loadOriginalFile("ISNDS-1.DAT", size);
-            loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-            if (!loaded) {
-                printf("Error : Could not load sounds from file ISNDS-1.DAT\n");
-                return false;
-            }
+        if (!loadBank("ISNDS-0.TAB", "ISNDS-0.DAT")) {
+            printf("Error : Could not load sounds from file ISNDS-0.DAT\n");
+            return false;
+        }
+        if (!loadBank("ISNDS-1.TAB", "ISNDS-1.DAT")) {
+            printf("Error : Could not load sounds from file ISNDS-1.DAT\n");
+            return false;
         }
         break;
     case SAMPLES_GAME:
-        {
-            tabData = File::loadOriginalFile("SOUND-0.TAB", tabSize);
-            data = File::loadOriginalFile("SOUND-0.DAT", size);
-            loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-            tabData = File::loadOriginalFile("SOUND-1.TAB", tabSize);
-            data = File::loadOriginalFile("SOUND-1.DAT", size);
-            loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-        }
+        loadBank("SOUND-0.TAB", "SOUND-0.DAT");
+        loadBank("SOUND-1.TAB", "SOUND-1.DAT");
         break;
     default:
         break;
     }
 
+    logMemoryUsage();
     return true;
 }
 
-bool SoundManager::loadSounds(uint8 * tabData, int tabSize,
-                              uint8 * soundData)
+/*!
+ * The .DAT file is kept in memory as it is and only the position of each
+ * sample is read from the .TAB file.
+ * \return False if one of the files could not be read.
+ */
+bool SoundManager::loadBank(const char *tabName, const char *datName)
 {
-    if (!tabData || !soundData) {
+    int tabSize;
+    SampleBank bank;
+    uint8 *tabData = File::loadOriginalFile(tabName, tabSize);
+    bank.name = datName;
+    bank.data = File::loadOriginalFile(datName, bank.size);
+
+    if (!tabData || !bank.data) {
+        delete[] tabData;
+        delete[] bank.data;
         return false;
     }
-    
+
+    banks_.push_back(bank);
+    bool loaded = loadSounds(tabData, tabSize, banks_.size() - 1);
+    delete[] tabData;
+    return loaded;
+}
+
+bool SoundManager::loadSounds(uint8 * tabData, int tabSize, size_t bank)
+{
+    uint8 *soundData = banks_[bank].data;
     tabData += tabentry_startoffset_;
     uint32 offset = 0;
 
@@ -116,19 +195,20 @@ bool SoundManager::loadSounds(uint8 * tabData, int tabSize,
 
         // Samples with size < 144 are bogus
         if (soundsize > 144) {
-            sounds_.push_back(new Sound);
-            uint8 *sample = new uint8[soundsize];
-            memcpy(sample, soundData, soundsize);
-            //printf("sample rate %x\n", sample[0x1e]);
-            // patching wrong sample rate
-            if (sounds_.size() == 13)
-                sample[0x1e] = 0x9c;
-            else if (sounds_.size() == 24)
-                sample[0x1e] = 0x9c;
-            else if (sounds_.size() == 25)
-                sample[0x1e] = 0x38;
-            sounds_.back()->loadSound(sample, soundsize);
-            delete []sample;
+            SampleDesc desc;
+            desc.bank = bank;
+            desc.offset = offset;
+            desc.size = soundsize;
+            desc.pSound = NULL;
+            samples_.push_back(desc);
+            //printf("sample rate %x\n", soundData[0x1e]);
+            // patching wrong sample rate directly in the bank
+            if (samples_.size() == 13)
+                soundData[0x1e] = 0x9c;
+            else if (samples_.size() == 24)
+                soundData[0x1e] = 0x9c;
+            else if (samples_.size() == 25)
+                soundData[0x1e] = 0x38;
         }
         soundData += soundsize;
         offset += soundsize;
@@ -138,6 +218,27 @@ bool SoundManager::loadSounds(uint8 * tabData, int tabSize,
     return true;
 }
 
+void SoundManager::logMemoryUsage()
+{
+    for (size_t b = 0; b < banks_.size(); ++b) {
+        int nbSamples = 0;
+        int nbLoaded = 0;
+        uint32 loadedSize = 0;
+        for (size_t i = 0; i < samples_.size(); ++i) {
+            if (samples_[i].bank == b) {
+                nbSamples++;
+                if (samples_[i].pSound) {
+                    nbLoaded++;
+                    loadedSize += samples_[i].pSound->memorySize();
+                }
+            }
+        }
+        LOG(Log::k_FLG_SND, "SoundManager", "logMemoryUsage",
+            ("%s : %d bytes for %d samples, %d samples loaded using %d bytes",
+            banks_[b].name, banks_[b].size, nbSamples, nbLoaded, (int) loadedSize))
+    }
+}
+
 /*!
  *
  */
@@ -156,13 +257,97 @@ void SoundManager::play(snd::InGameSample sample, int channel, int loops) {
  */
 void SoundManager::stop(snd::InGameSample sample) {
     if (disabled_) return;
-    Sound *pSound = sound(sample);
+    // a sample that was never loaded cannot be playing
+    Sound *pSound = sound(sample, false);
 
     if (pSound) {
         pSound->stop(sample >= snd::MENU_UP ? 1 : 0);
     }
 }
 
+/*!
+ * The sound is not played immediately : it will be played by flushQueue()
+ * unless too many sounds are already playing or it is too far from the
+ * viewport.
+ * \param sample The sample
+ * \param pos Position of the source on the map (in screen coordinates)
+ */
+void SoundManager::queue(snd::InGameSample sample, const Point2D &pos) {
+    if (disabled_ || sample == snd::NO_SOUND) return;
+
+    SoundRequest req;
+    req.sample = sample;
+    req.pos = pos;
+    req.distance = 0;
+    requests_.push_back(req);
+}
+
+/*!
+ * Plays the queued sounds, the most important and the closest first.
+ * Identical samples are played once from the closest source, sounds far
+ * from the viewport are dropped and a sample is not started if it is
+ * already playing on kMaxVoicesPerSample channels.
+ * \param viewX Origin of the viewport on the map
+ * \param viewY Origin of the viewport on the map
+ */
+void SoundManager::flushQueue(int viewX, int viewY) {
+    if (requests_.empty()) {
+        return;
+    }
+
+    // merge identical samples keeping the closest source
+    std::vector<SoundRequest> merged;
+    for (size_t i = 0; i < requests_.size(); i++) {
+        SoundRequest &req = requests_[i];
+        req.distance = distanceToViewport(req.pos, viewX, viewY);
+
+        size_t j = 0;
+        while (j < merged.size() && merged[j].sample != req.sample) {
+            j++;
+        }
+        if (j == merged.size()) {
+            merged.push_back(req);
+        } else if (req.distance < merged[j].distance) {
+            merged[j].pos = req.pos;
+            merged[j].distance = req.distance;
+        }
+    }
+    std::sort(merged.begin(), merged.end(), compareRequests);
+
+    int nbCulled = 0;
+    int nbLimited = 0;
+    int nbPlayed = 0;
+    for (size_t i = 0; i < merged.size(); i++) {
+        SoundRequest &req = merged[i];
+        if (req.distance > kCullDistance) {
+            nbCulled++;
+            continue;
+        }
+
+        if (nbPlayed >= kMaxVoicesPerTick) {
+            nbLimited++;
+            continue;
+        }
+
+        Sound *pSound = sound(req.sample);
+        if (pSound) {
+            if (pSound->nbPlaying() >= kMaxVoicesPerSample) {
+                nbLimited++;
+                continue;
+            }
+            // Sound is played on first available channel (value -1)
+            pSound->play(0, -1);
+            nbPlayed++;
+        }
+    }
+
+    LOG(Log::k_FLG_SND, "SoundManager", "flushQueue",
+        ("%d sounds queued : %d played, %d merged, %d culled, %d limited",
+        (int) requests_.size(), nbPlayed, (int) (requests_.size() - merged.size()),
+        nbCulled, nbLimited))
+    requests_.clear();
+}
+
 void SoundManager::setVolume(int volume) {
     Audio::setSoundVolume(volume);
 }
@@ -31,6 +31,7 @@
 #include "sound.h"
 
 #include <vector>
+#include <algorithm>
 
 /*!
  * Sound manager class.
@@ -51,6 +52,12 @@ public:
     void play(snd::InGameSample sample, int channel = 0, int loops = 0);
     //! Stops the sound
     void stop(snd::InGameSample sample);
+    //! Queues a sound emitted at the given point of the map
+    void queue(snd::InGameSample sample, const Point2D &pos);
+    //! Plays the sounds queued since the last call
+    void flushQueue(int viewX, int viewY);
+    //! Drops all queued sounds
+    void clearQueue() { requests_.clear(); }
 
     //! Sets the music volume to the given level
     void setVolume(int volume);
@@ -58,14 +65,53 @@ public:
     int getVolume();
     //! Mute / unmute the music
     void toggleSound();
+    //! Logs the memory used by the banks and the loaded samples
+    void logMemoryUsage();
 
 protected:
-    Sound *sound(snd::InGameSample sample);
-    bool loadSounds(uint8 *tabData, int tabSize, uint8 *soundData);
+    /*!
+     * The content of a .DAT file. All samples of a bank stay in the
+     * same buffer from which they are loaded when first played.
+     */
+    struct SampleBank {
+        const char *name;
+        uint8 *data;
+        int size;
+    };
+
+    /*! Where a sample is and its loaded version.*/
+    struct SampleDesc {
+        /*! Index of the bank in banks_.*/
+        size_t bank;
+        uint32 offset;
+        uint32 size;
+        /*! NULL until the sample is played for the first time.*/
+        Sound *pSound;
+    };
+
+    /*! A sound emitted on the map during the current tick.*/
+    struct SoundRequest {
+        snd::InGameSample sample;
+        Point2D pos;
+        /*! Distance to the viewport computed when flushing the queue.*/
+        int distance;
+    };
+
+    //! Orders requests by priority then by distance to the viewport
+    static bool compareRequests(const SoundRequest &r1, const SoundRequest &r2);
+
+    //! Returns the sound, loading it if asked
+    Sound *sound(snd::InGameSample sample, bool load = true);
+    //! Adds a bank and its samples
+    bool loadBank(const char *tabName, const char *datName);
+    bool loadSounds(uint8 *tabData, int tabSize, size_t bank);
 
     const int tabentry_startoffset_;
     const int tabentry_offset_;
-    std::vector<Sound *> sounds_;
+    std::vector<SampleBank> banks_;
+    std::vector<SampleDesc> samples_;
+    /*! Sounds waiting to be played at the end of the tick.*/
+    std::vector<SoundRequest> requests_;
     /*! 
      * Saves the volume level before a mute so
      * we can restore it after a unmute.
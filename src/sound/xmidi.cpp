@@ -80,9 +80,38 @@ std::vector<XMidi::Midi> XMidi::convertXMidi(uint8* buf, int size)
     return midi;
 }
 
-XMidi::XMidiFile* XMidi::loadXMidi(uint8* buf, int size)
+int XMidi::countTracks(uint8* buf, int size)
+{
+    int tracks = 0;
+    XMidiFile* xmi = loadXMidi(buf, size, kExtractNone);
+    if (xmi)
+    {
+    tracks = xmi->tracks;
+    delete xmi;
+    }
+    return tracks;
+}
+
+bool XMidi::convertTrack(uint8* buf, int size, int track, Midi &midi)
+{
+    midi.data_ = NULL;
+    midi.size_ = 0;
+    XMidiFile* xmi = loadXMidi(buf, size, track);
+    if (xmi)
+    {
+    if (track < xmi->tracks)
+    {
+        midi.size_ = retrieveMidi(xmi, track, &midi.data_);
+    }
+    delete xmi;
+    }
+    return midi.size_ != 0;
+}
+
+XMidi::XMidiFile* XMidi::loadXMidi(uint8* buf, int size, int track)
 {
     XMidiFile* xmidi = new XMidiFile;
+    xmidi->extract_track = track;
 
     if (!readFile (xmidi, buf, size))
     {
@@ -798,6 +827,14 @@ bool XMidi::handleChunkEVNT(XMidiFile* xmidi, const unsigned char* stream, uint3
 
     xmidi->allocData(); // precaution, in case XDIR wasn't found
 
+    if (xmidi->extract_track != kExtractAll
+        && xmidi->extract_track != xmidi->curr_track)
+    {
+    // this track is not wanted, skip its events
+    ++xmidi->curr_track;
+    return true;
+    }
+
     int count = extractEvents(xmidi, stream, chunksize);
 
     if (count != 1)
@@ -816,6 +853,7 @@ XMidi::XMidiFile::XMidiFile()
     list(0),
     current(0),
     curr_track(0),
+    extract_track(kExtractAll),
     timbres(0),
     timbre_sizes(0)
 {
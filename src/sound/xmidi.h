@@ -40,8 +40,18 @@ class XMidi {
 
     // Reads an .xmi file and returns a vector with individual MIDI tracks
     std::vector<Midi> convertXMidi(uint8 *buf, int size);
+    // Returns the number of tracks in an .xmi file without converting them
+    int countTracks(uint8 *buf, int size);
+    // Converts only one track of an .xmi file. Returns false if it failed
+    bool convertTrack(uint8 *buf, int size, int track, Midi &midi);
 
 protected:
+    // Values for XMidiFile::extract_track that are not a track index
+    enum ExtractTrack {
+        kExtractAll = -1,
+        kExtractNone = -2
+    };
+
     // The code below and corresponding original implementation was taken
     // from the The System Shock Hack Project (BSD license),
     // http://tsshp.sourceforge.net/, Copyright (c) 2001 Ryan Nunn
@@ -75,6 +85,7 @@ protected:
       static void deleteEventList(midi_event *mlist);
 
       int curr_track; // used during load of multi-track XMI's (e.g. syngame.xmi)
+      int extract_track; // only events of this track are read (or kExtractAll)
 
       //
       // Data from the TIMB (timbre) chunk.
@@ -92,7 +103,7 @@ protected:
      * Loads an XMidi file.
      * Returns NULL if failed
      */
-    XMidiFile *loadXMidi(uint8* buf, int size);
+    XMidiFile *loadXMidi(uint8* buf, int size, int track = kExtractAll);
 
     /* Frees an XMidi returned by XMidi_Load */
     void freeXMidi(XMidiFile *xmidi);
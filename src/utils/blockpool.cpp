@@ -0,0 +1,104 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include "utils/blockpool.h"
+#include "utils/log.h"
+
+namespace fs_utils {
+
+BlockPool::BlockPool(const char *name, size_t blocksPerChunk) {
+    name_ = name;
+    blocksPerChunk_ = blocksPerChunk;
+    for (size_t i = 0; i < kMaxBlockSize / kGranularity; i++) {
+        freeLists_[i] = NULL;
+    }
+    nbAllocs_ = 0;
+    nbReused_ = 0;
+    nbChunks_ = 0;
+    nbHeapAllocs_ = 0;
+    nbLive_ = 0;
+    maxLive_ = 0;
+}
+
+/*!
+ * Allocates a chunk of blocks of the given list index and chains
+ * them in the free list. Chunks are never released.
+ */
+void BlockPool::fillFreeList(size_t listIdx) {
+    size_t blockSize = (listIdx + 1) * kGranularity;
+    char *pChunk = static_cast<char *>(::operator new(blockSize * blocksPerChunk_));
+    // chain blocks backward so they are given in address order
+    for (size_t i = blocksPerChunk_; i > 0; i--) {
+        FreeBlock *pBlock = reinterpret_cast<FreeBlock *>(pChunk + (i - 1) * blockSize);
+        pBlock->pNext = freeLists_[listIdx];
+        freeLists_[listIdx] = pBlock;
+    }
+    nbChunks_++;
+}
+
+void * BlockPool::allocate(size_t size) {
+    nbAllocs_++;
+    nbLive_++;
+    if (nbLive_ > maxLive_) {
+        maxLive_ = nbLive_;
+    }
+
+    if (size > kMaxBlockSize) {
+        nbHeapAllocs_++;
+        return ::operator new(size);
+    }
+
+    size_t listIdx = (size - 1) / kGranularity;
+    if (freeLists_[listIdx] == NULL) {
+        fillFreeList(listIdx);
+    } else {
+        nbReused_++;
+    }
+    FreeBlock *pBlock = freeLists_[listIdx];
+    freeLists_[listIdx] = pBlock->pNext;
+    return pBlock;
+}
+
+void BlockPool::release(void *pBlock, size_t size) {
+    if (pBlock == NULL) {
+        return;
+    }
+    nbLive_--;
+
+    if (size > kMaxBlockSize) {
+        ::operator delete(pBlock);
+        return;
+    }
+
+    size_t listIdx = (size - 1) / kGranularity;
+    FreeBlock *pFree = static_cast<FreeBlock *>(pBlock);
+    pFree->pNext = freeLists_[listIdx];
+    freeLists_[listIdx] = pFree;
+}
+
+void BlockPool::logStats() const {
+    LOG(Log::k_FLG_MEM, "BlockPool", "logStats", ("%s : %d allocated, %d reused, %d chunks, %d on heap, %d in use, %d max in use",
+        name_, nbAllocs_, nbReused_, nbChunks_, nbHeapAllocs_, nbLive_, maxLive_));
+}
+
+}
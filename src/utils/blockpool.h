@@ -0,0 +1,97 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2026  FreeSynd contributors                          *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef UTILS_BLOCKPOOL_H_
+#define UTILS_BLOCKPOOL_H_
+
+#include <cstddef>
+
+#include "common.h"
+
+namespace fs_utils {
+
+/*!
+ * A pool of recycled memory blocks for objects that are created and
+ * destroyed very often during a mission (actions, shots, sfx...).
+ * Blocks are grouped in free lists by size so a class hierarchy can
+ * share the same pool. When a list is empty, a chunk of blocks is
+ * taken from the heap. Chunks are never given back so the pool can be
+ * used by static class allocators.
+ * The pool is not thread safe : objects must be created and destroyed
+ * by the main thread.
+ */
+class BlockPool {
+public:
+    //! Blocks sizes are multiple of this
+    static const size_t kGranularity = 8;
+    //! Bigger blocks are allocated on the heap
+    static const size_t kMaxBlockSize = 512;
+
+    BlockPool(const char *name, size_t blocksPerChunk);
+
+    //! Returns a block of at least the given size
+    void * allocate(size_t size);
+    //! Gives the block back to the pool
+    void release(void *pBlock, size_t size);
+
+    //! Returns the number of blocks currently in use
+    uint32 nbLive() const { return nbLive_; }
+    //! Returns the max number of blocks in use at the same time
+    uint32 maxLive() const { return maxLive_; }
+    //! Logs allocation counters of the pool
+    void logStats() const;
+
+private:
+    /*!
+     * Free blocks are chained using their first bytes.
+     */
+    struct FreeBlock {
+        FreeBlock *pNext;
+    };
+
+    void fillFreeList(size_t listIdx);
+
+private:
+    /*! Name used in logs.*/
+    const char *name_;
+    /*! Number of blocks allocated at once when a list is empty.*/
+    size_t blocksPerChunk_;
+    /*! One free list by size of block.*/
+    FreeBlock *freeLists_[kMaxBlockSize / kGranularity];
+    /*! Number of blocks allocated.*/
+    uint32 nbAllocs_;
+    /*! Number of blocks given by a free list.*/
+    uint32 nbReused_;
+    /*! Number of chunks allocated on the heap.*/
+    uint32 nbChunks_;
+    /*! Number of blocks too big for the pool.*/
+    uint32 nbHeapAllocs_;
+    /*! Number of blocks currently in use.*/
+    uint32 nbLive_;
+    /*! High-water mark : max number of blocks in use at the same time.*/
+    uint32 maxLive_;
+};
+
+}
+
+#endif  // UTILS_BLOCKPOOL_H_
@@ -93,6 +93,114 @@ void File::getFullPathForSaveSlot(int slot, std::string &path) {
     path.append(out.str());
 }
 
+/*!
+ * The cache directory is in the home directory. It holds files that are
+ * built from the original data and can be deleted at any time.
+ * \param path Set with the path of the cache directory ending with a '/'
+ * \return False if the directory cannot be created.
+ */
+bool File::getCachePath(std::string &path) {
+    path.assign(homePath_);
+    char c = path[path.size() - 1];
+    if (c != '\\' && c != '/')
+        path.append("/");
+    path.append("cache");
+
+#ifdef _WIN32
+    if (!CreateDirectory(path.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+        FSERR(Log::k_FLG_IO, "File", "getCachePath", ("Cannot create cache directory in %s", homePath_.c_str()))
+        return false;
+    }
+#else
+    DIR * rep = opendir(path.c_str());
+    if (rep == NULL) {
+        if (mkdir(path.c_str(), 0777) == -1) {
+            FSERR(Log::k_FLG_IO, "File", "getCachePath", ("Cannot create cache directory in %s", homePath_.c_str()))
+            return false;
+        }
+    } else {
+        closedir(rep);
+    }
+#endif
+
+    path.append("/");
+    return true;
+}
+
+/*!
+ * \param filename Name of the file in the cache directory
+ * \param filesize Set with the size of the file
+ * \return NULL if file is not in the cache.
+ */
+uint8 *File::loadCacheFile(const std::string& filename, int &filesize) {
+    std::string path;
+    filesize = 0;
+    if (!getCachePath(path)) {
+        return NULL;
+    }
+    path.append(filename);
+
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    int size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8 *data = NULL;
+    if (size > 0) {
+        data = new uint8[size];
+        if (fread(data, 1, size, fp) == (size_t) size) {
+            filesize = size;
+        } else {
+            delete[] data;
+            data = NULL;
+        }
+    }
+    fclose(fp);
+
+    return data;
+}
+
+/*!
+ * The file is written under a temporary name and then renamed so that
+ * an interrupted write never leaves a truncated file in the cache.
+ * \param filename Name of the file in the cache directory
+ * \param data Content of the file
+ * \param size Size of data
+ * \return False if the file could not be written.
+ */
+bool File::saveCacheFile(const std::string& filename, const uint8 *data, int size) {
+    std::string path;
+    if (!getCachePath(path)) {
+        return false;
+    }
+    path.append(filename);
+    std::string tmpPath(path);
+    tmpPath.append(".tmp");
+
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (!fp) {
+        FSERR(Log::k_FLG_IO, "File", "saveCacheFile", ("Cannot write file %s", tmpPath.c_str()))
+        return false;
+    }
+    bool ok = fwrite(data, 1, size, fp) == (size_t) size;
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok) {
+        // rename() does not replace an existing file on Windows
+        remove(path.c_str());
+        ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        FSERR(Log::k_FLG_IO, "File", "saveCacheFile", ("Cannot write file %s", path.c_str()))
+        remove(tmpPath.c_str());
+    }
+    return ok;
+}
+
 /*!
  * \return NULL if file cannot be read.
  */
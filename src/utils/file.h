@@ -57,6 +57,13 @@ public:
     static void getGameSavedNames(std::vector<std::string> &files);
     static uint8 *loadOriginalFileToMem(const std::string& filename, int &filesize);
 
+    //! Loads a file from the cache directory
+    static uint8 *loadCacheFile(const std::string& filename, int &filesize);
+    //! Writes a file in the cache directory
+    static bool saveCacheFile(const std::string& filename, const uint8 *data, int size);
+    //! Returns the cache directory, creating it if needed
+    static bool getCachePath(std::string &path);
+
 private:
     static void processSaveFile(const std::string& filename, std::vector<std::string> &files);
     /*! The path to the original game data.*/
@@ -20,6 +20,8 @@
  *                                                                      *
  ************************************************************************/
 
+#include <string.h>
+
 #include "portablefile.h"
 
 // runtime endianness test
@@ -64,23 +66,78 @@ static const unsigned char * const endianness_test_ptr = (unsigned char *)&endia
                   )
 
 PortableFile::PortableFile()
-    : big_endian_(true)
+    : pos_(0), fp_(NULL), good_(false), big_endian_(true)
 {
 }
 
+PortableFile::~PortableFile()
+{
+    close();
+}
+
 void PortableFile::open_to_read(const char *path)
 {
-    f_.open(path, std::ios::in | std::ios::binary);
+    close();
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size > 0) {
+        data_.resize(size);
+        good_ = fread(&data_[0], 1, size, fp) == (size_t) size;
+    } else {
+        good_ = size == 0;
+    }
+    fclose(fp);
 }
 
 void PortableFile::open_to_write(const char *path)
 {
-    f_.open(path, std::ios::out | std::ios::binary);
+    open_to_overwrite(path);
 }
 
 void PortableFile::open_to_overwrite(const char *path)
 {
-    f_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    close();
+    // file is opened now so errors are known before writing
+    fp_ = fopen(path, "wb");
+    good_ = fp_ != NULL;
+}
+
+void PortableFile::open_to_buffer()
+{
+    close();
+    good_ = true;
+}
+
+/*!
+ * Writes the buffer to the file if it was opened for writing
+ * then releases the buffer.
+ * \return false if an error occured while reading or writing.
+ */
+bool PortableFile::close()
+{
+    bool ok = good_;
+    if (fp_) {
+        if (!data_.empty()) {
+            ok = fwrite(data_.data(), 1, data_.size(), fp_) == data_.size() && ok;
+        }
+        ok = (fclose(fp_) == 0) && ok;
+        fp_ = NULL;
+    }
+    data_.clear();
+    pos_ = 0;
+    good_ = false;
+    return ok;
+}
+
+const std::string &PortableFile::buffer() const
+{
+    return data_;
 }
 
 bool PortableFile::big_endian() const
@@ -100,32 +157,54 @@ void PortableFile::set_system_endian()
 
 bool PortableFile::operator !() const
 {
-    return !f_.good();
+    return !good_;
 }
 
 PortableFile::operator bool() const
 {
-    return f_.good();
+    return good_;
 }
 
 void PortableFile::skip(int64 bytes_forward)
 {
-    f_.seekg(bytes_forward, std::ios::cur);
+    seek((int64) pos_ + bytes_forward);
 }
 
 void PortableFile::seek(int64 byte_position)
 {
-    f_.seekg(byte_position, std::ios::beg);
+    if (byte_position < 0 || byte_position > (int64) data_.size()) {
+        good_ = false;
+    } else {
+        pos_ = (size_t) byte_position;
+    }
 }
 
 void PortableFile::rewind(int64 bytes_backward)
 {
-    f_.seekg(-bytes_backward, std::ios::cur);
+    seek((int64) pos_ - bytes_backward);
 }
 
 int64 PortableFile::offset()
 {
-    return f_.tellg();
+    return pos_;
+}
+
+// appends to the end of the buffer
+void PortableFile::write_bytes(const void *data, size_t length)
+{
+    data_.append((const char *) data, length);
+}
+
+// false if there is not enough data left, then nothing is read
+bool PortableFile::read_bytes(void *data, size_t length)
+{
+    if (!good_ || length > data_.size() - pos_) {
+        good_ = false;
+        return false;
+    }
+    memcpy(data, data_.data() + pos_, length);
+    pos_ += length;
+    return true;
 }
 
 void PortableFile::write64(uint64 value)
@@ -133,7 +212,7 @@ void PortableFile::write64(uint64 value)
     if (system_big_endian != big_endian_) {
         value = swap64(value);
     }
-    f_.write((const char *)&value, 8);
+    write_bytes(&value, 8);
 }
 
 void PortableFile::write32(uint32 value)
@@ -141,7 +220,7 @@ void PortableFile::write32(uint32 value)
     if (system_big_endian != big_endian_) {
         value = swap32(value);
     }
-    f_.write((const char *)&value, 4);
+    write_bytes(&value, 4);
 }
 
 void PortableFile::write16(uint16 value)
@@ -149,18 +228,17 @@ void PortableFile::write16(uint16 value)
     if (system_big_endian != big_endian_) {
         value = swap16(value);
     }
-    f_.write((const char *)&value, 2);
+    write_bytes(&value, 2);
 }
 
 void PortableFile::write8(uint8 value)
 {
-    f_.write((const char *)&value, 1);
+    data_.push_back((char) value);
 }
 
 void PortableFile::write8b(bool value)
 {
-    uint8 u8 = value ? 1 : 0;
-    f_.write((const char *)&u8, 1);
+    data_.push_back(value ? 1 : 0);
 }
 
 void PortableFile::write_float(float value)
@@ -179,31 +257,28 @@ void PortableFile::write_double(double value)
 void PortableFile::write_string(const std::string& value, size_t length)
 {
     if (length > value.size()) {
-        f_.write(value.c_str(), value.size());
+        write_bytes(value.c_str(), value.size());
         write_zeros(length - value.size());
     } else {
-        f_.write(value.c_str(), length);
+        write_bytes(value.c_str(), length);
     }
 }
 
 void PortableFile::write_variable_string(const std::string& value, bool nul_terminate)
 {
-    f_.write(value.c_str(), value.size());
-    if (nul_terminate) f_.put(0);
+    write_bytes(value.c_str(), value.size());
+    if (nul_terminate) data_.push_back(0);
 }
 
 void PortableFile::write_zeros(size_t length)
 {
-    size_t i;
-    for (i = 0; i < length; i++) {
-        f_.put(0);
-    }
+    data_.append(length, '\0');
 }
 
 uint64 PortableFile::read64()
 {
     uint64 value = 0;
-    f_.read((char *)&value, 8);
+    read_bytes(&value, 8);
     if (system_big_endian != big_endian_) {
         value = swap64(value);
     }
@@ -213,7 +288,7 @@ uint64 PortableFile::read64()
 uint32 PortableFile::read32()
 {
     uint32 value = 0;
-    f_.read((char *)&value, 4);
+    read_bytes(&value, 4);
     if (system_big_endian != big_endian_) {
         value = swap32(value);
     }
@@ -223,7 +298,7 @@ uint32 PortableFile::read32()
 uint16 PortableFile::read16()
 {
     uint16 value = 0;
-    f_.read((char *)&value, 2);
+    read_bytes(&value, 2);
     if (system_big_endian != big_endian_) {
         value = swap16(value);
     }
@@ -233,14 +308,14 @@ uint16 PortableFile::read16()
 uint8 PortableFile::read8()
 {
     uint8 value = 0;
-    f_.read((char *)&value, 1);
+    read_bytes(&value, 1);
     return value;
 }
 
 bool PortableFile::read8b()
 {
     uint8 u8 = 0;
-    f_.read((char *)&u8, 1);
+    read_bytes(&u8, 1);
     return (u8 != 0);
 }
 
@@ -264,14 +339,18 @@ double PortableFile::read_double()
 std::string PortableFile::read_string()
 {
     std::string value;
-    char buf[256];
-    while (f_.good()) {
-        f_.get(buf, 256, '\0');
-        int n = (int)f_.gcount();
-        value.append(buf, n);
-        if (f_.peek() == '\0') {
-            break;
-        }
+    if (!good_) {
+        return value;
+    }
+    size_t end = data_.find('\0', pos_);
+    if (end == std::string::npos) {
+        // no nul : read until the end and put file in error
+        value = data_.substr(pos_);
+        pos_ = data_.size();
+        good_ = false;
+    } else {
+        value = data_.substr(pos_, end - pos_);
+        pos_ = end + 1;
     }
     return value;
 }
@@ -280,13 +359,16 @@ std::string PortableFile::read_string()
 std::string PortableFile::read_string(size_t length, bool strip_nul)
 {
     std::string value;
-    char buf[256];
-    while (f_.good() && length) {
-        int n = (length < 256) ? length : 256;
-        f_.read(buf, n);
-        length -= n;
-        value.append(buf, (uint32)f_.gcount());
-        if (f_.fail()) break;
+    if (good_) {
+        size_t n = data_.size() - pos_;
+        if (length > n) {
+            // read what's left like a stream would
+            good_ = false;
+        } else {
+            n = length;
+        }
+        value = data_.substr(pos_, n);
+        pos_ += n;
     }
 
     if (strip_nul) {
@@ -300,4 +382,3 @@ std::string PortableFile::read_string(size_t length, bool strip_nul)
     }
     return value;
 }
-
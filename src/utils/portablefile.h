@@ -23,23 +23,31 @@
 #ifndef PORTABLEFILE_H
 #define PORTABLEFILE_H
 
+#include <stdio.h>
 #include <string>
 #include <vector>
-#include <fstream>
 #include "common.h"
 
 /*!
  * Portable file class.  Simplifies implementation of portable file formats.
  *
- * NOTE: does not inherit from std::fstream to avoid any usage which might
- * circumvent endian-aware functionality.
+ * The whole file is kept in memory : it is read at once when opened for
+ * reading and written at once by close() when opened for writing. Fields
+ * are then decoded from or encoded to that buffer. Reading past the end
+ * of the buffer puts the file in error, like a stream would.
  */
 class PortableFile {
 public:
     PortableFile();
+    ~PortableFile();
     void open_to_read(const char *path);
     void open_to_write(const char *path);
     void open_to_overwrite(const char *path);
+    void open_to_buffer(); // writes are kept in memory, see buffer()
+    bool close(); // writes the buffer if opened for writing
+
+    // content read or written since the file was opened
+    const std::string &buffer() const;
 
     operator bool() const;
     bool operator !() const;
@@ -79,7 +87,20 @@ public:
     std::string read_string(size_t length, bool strip_nul); // reads length bytes exactly
 
 private:
-    std::fstream f_;
+    // not copyable
+    PortableFile(const PortableFile &);
+    PortableFile &operator=(const PortableFile &);
+
+    void write_bytes(const void *data, size_t length);
+    bool read_bytes(void *data, size_t length);
+
+    // content of the file
+    std::string data_;
+    // read position in data_
+    size_t pos_;
+    // file written by close(), NULL if not writing to a file
+    FILE *fp_;
+    bool good_;
     bool big_endian_;
 };
 